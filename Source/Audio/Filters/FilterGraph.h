@@ -71,17 +71,10 @@ public:
 
 	static const String getInstrumentName(File csdFile)
 	{
-		StringArray csdLines;
-		csdLines.addLines(csdFile.loadFileAsString());
+		const ValueTree form = CsdDocument::load(csdFile)->getForm();
 
-		for (auto line : csdLines)
-		{
-			ValueTree temp("temp");
-			CabbageWidgetData::setWidgetState(temp, line, 0);
-
-			if (CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::type) == CabbageWidgetTypes::form)
-				return CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::caption);
-		}
+		if (form.isValid())
+			return CabbageWidgetData::getStringProp(form, CabbageIdentifierIds::caption);
 
         return "";
 	}
@@ -247,27 +240,17 @@ public:
 		std::unique_ptr < AudioProcessor> processor;
         
 		const bool isCabbageFile = CabbageUtilities::hasCabbageTags(File(filename));
-        StringArray csdLines;
-        csdLines.addLines(File(filename).loadFileAsString());
+        //held until the processor is built so that its compile reuses this parse
+        const CsdDocument::Ptr document = CsdDocument::load(File(filename));
         int sideChainChannels = 0;
-        for (auto line : csdLines)
-        {
-            ValueTree temp("temp");
-            CabbageWidgetData::setWidgetState(temp, line, 0);
-            
-            if (CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::type) == CabbageWidgetTypes::form)
-            {
-                sideChainChannels = CabbageWidgetData::getProperty(temp, CabbageIdentifierIds::sidechain);
-                break;
-            }
-            
-        }
+        if (document->getForm().isValid())
+            sideChainChannels = CabbageWidgetData::getProperty(document->getForm(), CabbageIdentifierIds::sidechain);
         
-        const String csdString = File(filename).loadFileAsString();
-        const int numOutChannels = CabbageUtilities::getHeaderInfo(csdString, "nchnls");
+        const int numOutChannels = document->getHeaderValue("nchnls", 2);
         int numInChannels = numOutChannels;
-        if (CabbageUtilities::getHeaderInfo(csdString, "nchnls_i") != -1 && CabbageUtilities::getHeaderInfo(csdString, "nchnls_i") != 0)
-            numInChannels = CabbageUtilities::getHeaderInfo(csdString, "nchnls_i") - sideChainChannels;
+        const int requestedInChannels = document->getHeaderValue("nchnls_i");
+        if (requestedInChannels != -1 && requestedInChannels != 0)
+            numInChannels = requestedInChannels - sideChainChannels;
 
 
 
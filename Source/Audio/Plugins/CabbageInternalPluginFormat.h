@@ -61,13 +61,15 @@ public:
 
 	std::unique_ptr < GenericCabbagePluginProcessor> createGenericPluginFilter(File inputFile)
 	{
-		const int numChannels = CabbageUtilities::getHeaderInfo(inputFile.loadFileAsString(), "nchnls");
+		const CsdDocument::Ptr document = CsdDocument::load(inputFile);
+		const int numChannels = document->getHeaderValue("nchnls", 2);
 		return std::unique_ptr < GenericCabbagePluginProcessor>(new GenericCabbagePluginProcessor(inputFile, AudioChannelSet::discreteChannels(numChannels), AudioChannelSet::discreteChannels(numChannels)));
 	}
 
 	std::unique_ptr<CabbagePluginProcessor> createCabbagePluginFilter(File inputFile)
 	{
-		const int numChannels = CabbageUtilities::getHeaderInfo(inputFile.loadFileAsString(), "nchnls");
+		const CsdDocument::Ptr document = CsdDocument::load(inputFile);
+		const int numChannels = document->getHeaderValue("nchnls", 2);
 		return std::unique_ptr<CabbagePluginProcessor>(new CabbagePluginProcessor(inputFile, AudioChannelSet::discreteChannels(numChannels), AudioChannelSet::discreteChannels(numChannels)));
 	}
 
@@ -605,16 +605,7 @@ void CabbagePluginEditor::insertLight (ValueTree cabbageWidgetData)
 //======================================================================================================
 CabbagePluginParameter* CabbagePluginEditor::getParameterForComponent (const String name)
 {
-    for (auto param : cabbageProcessor.getCabbageParameters())
-    {
-        if (CabbagePluginParameter* cabbageParam = dynamic_cast<CabbagePluginParameter*> (param))
-        {
-            if (name == cabbageParam->getWidgetName())
-                return cabbageParam;
-        }
-    }
-
-    return nullptr;
+    return cabbageProcessor.getParameterForWidget (name);
 }
 
 //======================================================================================================
@@ -897,6 +888,26 @@ void CabbagePluginEditor::updatefTableData (GenTable* table)
 
     if ( table->genRoutine == 5 || table->genRoutine == 7 || table->genRoutine == 2)
     {
+        Array<double> arguments;
+
+        if (table->genRoutine == 5)
+        {
+            for (int i = 0; i < pFields.size() - 1; i++)
+                arguments.add (jmax (0.00001, pFields[i + 1]));
+        }
+        else if (table->genRoutine == 7)
+        {
+            for (int i = 0; i < pFields.size() - 1; i++)
+                arguments.add (pFields[i + 1]);
+        }
+        else
+            arguments = pFields;
+
+        //generated off the message thread and swapped into the table between k-cycles,
+        //the gentable hears about the new contents from the table editor
+        if (cabbageProcessor.getTableEditor().requestEdit (table->tableNumber, table->realGenRoutine, table->tableSize, arguments))
+            return;
+
         FUNC* ftpp;
         EVTBLK  evt;
 #ifdef JUCE_WINDOWS
@@ -914,21 +925,8 @@ void CabbagePluginEditor::updatefTableData (GenTable* table)
         evt.p[3] = table->tableSize;
         evt.p[4] = table->realGenRoutine;
 
-        if (table->genRoutine == 5)
-        {
-            for (int i = 0; i < pFields.size() - 1; i++)
-                evt.p[5 + i] = jmax (0.00001, pFields[i + 1]);
-        }
-        else if (table->genRoutine == 7)
-        {
-            for (int i = 0; i < pFields.size() - 1; i++)
-                evt.p[5 + i] = pFields[i + 1];
-        }
-        else
-        {
-            for (int i = 0; i < pFields.size(); i++)
-                evt.p[5 + i] = pFields[i];
-        }
+        for (int i = 0; i < arguments.size(); i++)
+            evt.p[5 + i] = arguments[i];
 
         StringArray fStatement;
         int pCnt = 0;
@@ -988,10 +986,10 @@ void CabbagePluginEditor::sendScoreEventToCsound (String scoreEvent)
         cabbageProcessor.getCsound()->InputMessage(scoreEvent.toUTF8());
 }
 
-void CabbagePluginEditor::createEventMatrix(int cols, int rows, String channel)
+void CabbagePluginEditor::createEventMatrix(int cols, int rows, String channel, bool vertical)
 {
     if (cabbageProcessor.csdCompiledWithoutError())
-        cabbageProcessor.createMatrixEventSequencer(cols, rows, channel);
+        cabbageProcessor.createMatrixEventSequencer(cols, rows, channel, vertical);
 }
 
 void CabbagePluginEditor::setEventMatrixData(int cols, int rows, String channel, String data)
@@ -1001,17 +999,17 @@ void CabbagePluginEditor::setEventMatrixData(int cols, int rows, String channel,
 }
 
 
-const Array<float, CriticalSection> CabbagePluginEditor::getArrayForSignalDisplay (const String signalVariable, const String displayType)
+SignalDisplay* CabbagePluginEditor::getSignalDisplay (const String signalVariable, const String displayType)
 {
     if (csdCompiledWithoutError())
-        return cabbageProcessor.getSignalArray (signalVariable, displayType)->getPoints();
+        return cabbageProcessor.getSignalArray (signalVariable, displayType);
 
-    return Array<float, CriticalSection>();
+    return nullptr;
 }
 
-bool CabbagePluginEditor::shouldUpdateSignalDisplay(String signalVariableName)
+int CabbagePluginEditor::getSignalDisplayVersion()
 {
-    return cabbageProcessor.shouldUpdateSignalDisplay(signalVariableName);
+    return cabbageProcessor.getSignalArraysVersion();
 }
 
 void CabbagePluginEditor::enableXYAutomator (String name, bool enable, Line<float> dragLine)
@@ -1040,6 +1038,14 @@ const Array<float, CriticalSection> CabbagePluginEditor::getTableFloats (int tab
     return Array<float, CriticalSection>();
 }
 
+TableView CabbagePluginEditor::getTableView (int tableNumber)
+{
+    if (csdCompiledWithoutError())
+        return cabbageProcessor.getTableView (tableNumber);
+
+    return {};
+}
+
 CabbagePluginProcessor& CabbagePluginEditor::getProcessor()
 {
     return cabbageProcessor;
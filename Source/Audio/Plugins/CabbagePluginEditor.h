@@ -126,22 +126,23 @@ public:
     void sendChannelStringDataToCsound (String channel, String value);
     float getChannelDataFromCsound (String channel);
     void sendScoreEventToCsound (String scoreEvent);
-    void createEventMatrix(int cols, int rows, String channel);
+    void createEventMatrix(int cols, int rows, String channel, bool vertical);
     void setEventMatrixData(int cols, int rows, String channel, String data);
     void setEventMatrixCurrentPosition(int cols, int rows, String channel, int position);
     bool isAudioUnit()
     {
         return processor.wrapperType_AudioUnit;
     }
-    bool shouldUpdateSignalDisplay(String variableName);
     String currentPresetName;
     void savePluginStateToFile (File snapshotFile, String presetName="", bool remove = false);
     void restorePluginStateFrom (String childPreset, File xmlFile);
-    const Array<float, CriticalSection> getArrayForSignalDisplay (const String signalVariable, const String displayType);
+    SignalDisplay* getSignalDisplay (const String signalVariable, const String displayType);
+    int getSignalDisplayVersion();
     const String getCsoundOutputFromProcessor();
     StringArray getTableStatement (int tableNumber);
     bool csdCompiledWithoutError();
     const Array<float, CriticalSection> getTableFloats (int tableNum);
+    TableView getTableView (int tableNum);
     CabbagePluginProcessor& getProcessor();
     void enableXYAutomator (String name, bool enable, Line<float> dragLine = Line<float> (0, 0, 1, 1));
 
@@ -57,31 +57,17 @@ createPluginFilter() {
 	if (csdFile.existsAsFile() == false)
 		Logger::writeToLog("Could not find .csd file " + csdFile.getFullPathName() + ", please make sure it's in the correct folder");
 
-	String csdString = csdFile.loadFileAsString();
-#ifdef CabbagePro
-	csdString = Encrypt::decode(csdFile);
-#endif
+	const CsdDocument::Ptr document = CsdDocument::load(csdFile);
 
-	StringArray csdLines;
-	csdLines.addLines(csdString);
 	int sideChainChannels = 0;
-	for (auto line : csdLines)
-	{
-		ValueTree temp("temp");
-		CabbageWidgetData::setWidgetState(temp, line, 0);
-
-		if (CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::type) == CabbageWidgetTypes::form)
-		{
-			sideChainChannels = CabbageWidgetData::getProperty(temp, CabbageIdentifierIds::sidechain);
-			break;
-		}
-
-	}
+	if (document->getForm().isValid())
+		sideChainChannels = CabbageWidgetData::getProperty(document->getForm(), CabbageIdentifierIds::sidechain);
 
-	const int numOutChannels = CabbageUtilities::getHeaderInfo(csdString, "nchnls");
+	const int numOutChannels = document->getHeaderValue("nchnls", 2);
 	int numInChannels = numOutChannels;
-	if (CabbageUtilities::getHeaderInfo(csdString, "nchnls_i") != -1 && CabbageUtilities::getHeaderInfo(csdString, "nchnls_i") != 0)
-		numInChannels = CabbageUtilities::getHeaderInfo(csdString, "nchnls_i") - sideChainChannels;
+	const int requestedInChannels = document->getHeaderValue("nchnls_i");
+	if (requestedInChannels != -1 && requestedInChannels != 0)
+		numInChannels = requestedInChannels - sideChainChannels;
 
 #if !Cabbage_IDE_Build && !Cabbage_Lite
 	PluginHostType pluginHostType;
@@ -121,12 +107,12 @@ CabbagePluginProcessor::CabbagePluginProcessor(File inputFile, AudioChannelSet i
 	createCsound(inputFile);
 }
 
-void CabbagePluginProcessor::createCsound(File inputFile, bool shouldCreateParameters)
+void CabbagePluginProcessor::createCsound(File inputFile, bool shouldCreateParameters, bool compileInBackground)
 {
 	if (inputFile.existsAsFile()) {
 		setWidthHeight();
-		StringArray linesFromCsd;
-		linesFromCsd.addLines(inputFile.loadFileAsString());
+		csdDocument = CsdDocument::load(inputFile);
+		StringArray linesFromCsd = csdDocument->getLines();
 
 		//only create extended temp file if imported plants are being added...
 		if (addImportFiles(linesFromCsd) == true)
@@ -135,35 +121,48 @@ void CabbagePluginProcessor::createCsound(File inputFile, bool shouldCreateParam
 
 
 			File tempFile = File::createTempFile(inputFile.getFileNameWithoutExtension() + "_temp.csd");
-			tempFile.replaceWithText(linesFromCsd.joinIntoString("\n")
+			const String tempText = linesFromCsd.joinIntoString("\n")
 				.replace("$lt;", "<")
 				.replace("&amp;", "&")
 				.replace("$quote;", "\"")
-				.replace("$gt;", ">"));
+				.replace("$gt;", ">");
+			tempFile.replaceWithText(tempText);
 
 
-			CabbageUtilities::debug(tempFile.loadFileAsString());
-
-			if (setupAndCompileCsound(tempFile, inputFile.getParentDirectory(), samplingRate) == false)
-				this->suspendProcessing(true);
-
+			CabbageUtilities::debug(tempText);
 			csdFile = tempFile;
+			csdDocument = CsdDocument::create(tempFile, tempText);
 
 		}
 
 		else {
 			parseCsdFile(linesFromCsd);
 			csdFile = inputFile;
-			if (setupAndCompileCsound(inputFile, inputFile.getParentDirectory(), samplingRate) == false)
-				this->suspendProcessing(true);
 		}
 
+		if (compileInBackground)
+		{
+			//the new widgets' channels are resolved once the new instance is swapped in
+			buildChannelBindings();
+			//channels are initialised from a copy of the widget tree on the worker thread
+			//if a reload is still in flight, try again on the next timer tick
+			if (recompileCsoundInBackground(csdFile, inputFile.getParentDirectory(), cabbageWidgets.createCopy()))
+				csdLastModifiedAt = csdFile.getLastModificationTime().toMilliseconds();
+			else
+				csdLastModifiedAt = 0;
+			return;
+		}
+
+		if (setupAndCompileCsound(csdFile, inputFile.getParentDirectory(), samplingRate) == false)
+			this->suspendProcessing(true);
+
 		if (shouldCreateParameters)
 			createCabbageParameters();
 
 		csoundChanList = NULL;
 
 		initAllCsoundChannels(cabbageWidgets);
+		buildChannelBindings();
 
 		csdLastModifiedAt = csdFile.getLastModificationTime().toMilliseconds();
 
@@ -188,26 +187,17 @@ void CabbagePluginProcessor::timerCallback()
 	{
 		csdLastModifiedAt = csdFile.getLastModificationTime().toMilliseconds();
 		CabbageUtilities::debug("resetting file due to update of file on disk");
-		createCsound(csdFile, false);
+		createCsound(csdFile, false, true);
 	}
 }
 
 //==============================================================================
 void CabbagePluginProcessor::setWidthHeight() {
-	StringArray csdLines;
-	csdLines.addLines(csdFile.loadFileAsString());
-
-	for (auto line : csdLines) {
-		if (line.contains("</Cabbage>"))
-			return;
+	const ValueTree form = CsdDocument::load(csdFile)->getForm();
 
-		ValueTree temp("temp");
-		CabbageWidgetData::setWidgetState(temp, line, 0);
-
-		if (CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::type) == CabbageWidgetTypes::form) {
-			screenHeight = CabbageWidgetData::getNumProp(temp, CabbageIdentifierIds::height);
-			screenWidth = CabbageWidgetData::getNumProp(temp, CabbageIdentifierIds::width);
-		}
+	if (form.isValid()) {
+		screenHeight = CabbageWidgetData::getNumProp(form, CabbageIdentifierIds::height);
+		screenWidth = CabbageWidgetData::getNumProp(form, CabbageIdentifierIds::width);
 	}
 }
 
@@ -302,7 +292,9 @@ void CabbagePluginProcessor::parseCsdFile(StringArray& linesFromCsd)
 			if (CabbageWidgetData::getNumProp(tempWidget, CabbageIdentifierIds::logger) == 1)
 				createFileLogger(this->csdFile);
 
-			setGUIRefreshRate(CabbageWidgetData::getNumProp(tempWidget, CabbageIdentifierIds::guirefresh));
+			//guirefresh() is always given a default, so only an explicit one is passed on
+			setGUIRefreshRate(currentLineOfCabbageCode.contains("guirefresh(") ? CabbageWidgetData::getNumProp(tempWidget, CabbageIdentifierIds::guirefresh) : 0);
+			setGUIFrameRate(CabbageWidgetData::getNumProp(tempWidget, CabbageIdentifierIds::guiframerate));
 		}
 
 		const String precedingCharacters = currentLineOfCabbageCode.substring(0, currentLineOfCabbageCode.indexOf(
@@ -715,6 +707,11 @@ void CabbagePluginProcessor::addCabbageParameter(std::unique_ptr<CabbagePluginPa
 		addParameter(parameter->releaseHostParameter());
 	}
 
+	if (!parametersByWidgetName.contains(parameter->getWidgetName()))
+		parametersByWidgetName.set(parameter->getWidgetName(), parameter.get());
+	if (!parametersByChannel.contains(parameter->getChannel()))
+		parametersByChannel.set(parameter->getChannel(), parameter.get());
+
 	parameters.add(parameter.release());
 }
 
@@ -1130,14 +1127,11 @@ void CabbagePluginProcessor::setParametersFromXml(XmlElement* e)
 				//now make changes parameter changes so host can see them..
 				//getParameters().
 
-				for (auto cabbageParam : getCabbageParameters())
+				if (CabbagePluginParameter* cabbageParam = getParameterForWidget(widgetName))
 				{
-					if (widgetName == cabbageParam->getWidgetName())
-					{
-						cabbageParam->beginChangeGesture();
-						cabbageParam->setValueNotifyingHost(cabbageParam->getNormalisableRange().convertTo0to1(e->getAttributeValue(i).getFloatValue()));
-						cabbageParam->endChangeGesture();
-					}
+					cabbageParam->beginChangeGesture();
+					cabbageParam->setValueNotifyingHost(cabbageParam->getNormalisableRange().convertTo0to1(e->getAttributeValue(i).getFloatValue()));
+					cabbageParam->endChangeGesture();
 				}
 			}
 		}
@@ -1145,21 +1139,20 @@ void CabbagePluginProcessor::setParametersFromXml(XmlElement* e)
 }
 
 //==============================================================================
-// This method is responsible for updating widget valuetrees based on the current
-// data stored in each widget's software channel bus. 
+// Builds the channel binding table used by getChannelDataFromCsound(). Channel
+// names are worked out once here rather than on every update.
 //==============================================================================
-void CabbagePluginProcessor::getChannelDataFromCsound()
+void CabbagePluginProcessor::buildChannelBindings()
 {
-	if (!getCsound())
-		return;
+	channelBindings.clear();
+	channelBindings.widgetCount = cabbageWidgets.getNumChildren();
 
-    const int chnsetGestureMode = getChnsetGestureMode();
 	for (int i = 0; i < cabbageWidgets.getNumChildren(); i++)
 	{
-		const var chanArray = CabbageWidgetData::getProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::channel);
+		ValueTree widget = cabbageWidgets.getChild(i);
+		const var chanArray = CabbageWidgetData::getProperty(widget, CabbageIdentifierIds::channel);
 		const String channelName = (chanArray.size() > 0 ? chanArray[0].toString() : chanArray.toString());
-		const var widgetArray = CabbageWidgetData::getProperty(cabbageWidgets.getChild(i),
-			CabbageIdentifierIds::widgetarray);
+		const var widgetArray = CabbageWidgetData::getProperty(widget, CabbageIdentifierIds::widgetarray);
 
 		StringArray channels;
 
@@ -1172,168 +1165,255 @@ void CabbagePluginProcessor::getChannelDataFromCsound()
 				channels.add(var(chanArray[j]));
 		}
 
-		const var value = CabbageWidgetData::getProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::value);
+		const String typeOfWidget = CabbageWidgetData::getStringProp(widget, CabbageIdentifierIds::type);
 
-		const String identChannel = CabbageWidgetData::getStringProp(cabbageWidgets.getChild(i),
-			CabbageIdentifierIds::identchannel);
+		if (channels.size() > 0 && channels[0].isNotEmpty())
+			channelBindings.widgetIndexByChannel.set(channels[0], i);
 
-		const String typeOfWidget = CabbageWidgetData::getStringProp(cabbageWidgets.getChild(i),
-			CabbageIdentifierIds::type);
-
-		const String chann = channels[0];
-
-		if (channels.size() == 1 && channels[0].isNotEmpty()) {
-
-			if (value.isString() == false)
-			{
-				if (getCsound()->GetChannel(channels[0].toUTF8()) != float(value))
-				{
-					CabbageWidgetData::setNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::value,
-						getCsound()->GetChannel(channels[0].toUTF8()));
-					//now update plugin parameters..
-					
-					if (chnsetGestureMode == 1) // by default, we don't call beginChangeGesture()...
-					{
-						for (auto cabbageParam : getCabbageParameters())
-						{
-							if (cabbageParam->getChannel() == channels[0].toUTF8())
-							{
-								cabbageParam->beginChangeGesture();
-								cabbageParam->setValueNotifyingHost(cabbageParam->getNormalisableRange().convertTo0to1(getCsound()->GetChannel(channels[0].toUTF8())));
-								cabbageParam->endChangeGesture();
-							}
-						}
-					}
-				}
-
-			}
+		if (channels.size() == 1 && channels[0].isNotEmpty())
+		{
+			//string channels must not be registered as control channels, Csound would refuse the string type later
+			if (CabbageWidgetData::getProperty(widget, CabbageIdentifierIds::value).isString())
+				channelBindings.add(i, ChannelBindings::stringValue, nullptr, nullptr, channels[0]);
 			else
-			{
-				char tmp_str[4096] = { 0 };
-				getCsound()->GetStringChannel(channels[0].toUTF8(), tmp_str);
-				CabbageWidgetData::setProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::value,
-					String(tmp_str));
-			}
+				channelBindings.add(i, ChannelBindings::numericValue, registerChannel(channels[0]), nullptr, channels[0],
+					getParameterForChannel(channels[0]));
 		}
-
 		//currently only dealing with a max of 2 channels...
 		else if (channels.size() == 2 && channels[0].isNotEmpty() && channels[1].isNotEmpty() &&
 			typeOfWidget != CabbageWidgetTypes::eventsequencer)
 		{
-			const float valuex = CabbageWidgetData::getNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::valuex);
-			const float valuey = CabbageWidgetData::getNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::valuey);
-			if (getCsound()->GetChannel(channels[0].toUTF8()) != valuex
-				|| getCsound()->GetChannel(channels[1].toUTF8()) != valuey) {
-				if (typeOfWidget == CabbageWidgetTypes::xypad) {
-					CabbageWidgetData::setNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::valuex,
-						getCsound()->GetChannel(channels[0].toUTF8()));
-					CabbageWidgetData::setNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::valuey,
-						getCsound()->GetChannel(channels[1].toUTF8()));
-				}
-				else if (typeOfWidget.contains("range")) {
-					//                    const float minValue = CabbageWidgetData::getNumProp(cabbageWidgets.getChild(i),
-					//                        CabbageIdentifierIds::minvalue);
-					//                    const float maxValue = CabbageWidgetData::getNumProp(cabbageWidgets.getChild(i),
-					//                        CabbageIdentifierIds::maxvalue);
-					CabbageWidgetData::setNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::minvalue,
-						getCsound()->GetChannel(channels[0].toUTF8()));
-					CabbageWidgetData::setNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::maxvalue,
-						getCsound()->GetChannel(channels[1].toUTF8()));
-				}
-			}
+			if (typeOfWidget == CabbageWidgetTypes::xypad)
+				channelBindings.add(i, ChannelBindings::xyPad, registerChannel(channels[0]), registerChannel(channels[1]), channels[0]);
+			else if (typeOfWidget.contains("range"))
+				channelBindings.add(i, ChannelBindings::rangeSlider, registerChannel(channels[0]), registerChannel(channels[1]), channels[0]);
 		}
 
-		if (identChannel.isNotEmpty()) {
-			const String identChannelMessage = CabbageWidgetData::getStringProp(cabbageWidgets.getChild(i),
-				CabbageIdentifierIds::identchannelmessage);
-			memset(&tmp_string[0], 0, sizeof(tmp_string));
-			getCsound()->GetStringChannel(identChannel.toUTF8(), tmp_string);
-
-			const String identifierText(tmp_string);
-			//CabbageUtilities::debug(identifierText);
-			if (identifierText.isNotEmpty() && identifierText != identChannelMessage) {
-                CabbageWidgetData::setCustomWidgetState(cabbageWidgets.getChild(i), " " + identifierText);
-                
-                if(CabbageWidgetData::getStringProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::type) == CabbageWidgetTypes::form)
-                {
-                    double scale = CabbageWidgetData::getNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::scale);
-                    
-                    CabbagePluginEditor* editor = static_cast<CabbagePluginEditor*> (this->getActiveEditor());
-#ifdef Cabbage_IDE_Build
-                    double pluginWidth = CabbageWidgetData::getNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::width);
-                    double pluginHeight = CabbageWidgetData::getNumProp(cabbageWidgets.getChild(i), CabbageIdentifierIds::height);
-                    editor->setSize(pluginWidth*scale, pluginHeight*scale);
-#endif
-                    editor->setScaleFactor(scale);
-                    editor->resized();
-                }
-				
-
-				if (identifierText.contains("tablenumber")) //update even if table number has not changed
-					CabbageWidgetData::setProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::update, 1);
-				else if (identifierText == CabbageIdentifierIds::tofront.toString() + "()") {
-					CabbageWidgetData::setProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::tofront,
-						Random::getSystemRandom().nextInt());
-				}
-
-				getCsound()->SetChannel(identChannel.toUTF8(), (char*) "");
-
-				CabbageWidgetData::setProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::update,
-					0); //reset value for further updates
+		//signaldisplays watching audio channels get their taps here, an existing tap is reused
+		if (typeOfWidget == CabbageWidgetTypes::signaldisplay)
+		{
+			const var audioChannels = CabbageWidgetData::getProperty(widget, CabbageIdentifierIds::audiochannel);
+			const String displayType = CabbageWidgetData::getStringProp(widget, CabbageIdentifierIds::displaytype);
+			const bool isSpectrum = displayType != "waveform" && displayType != "lissajous";
 
-			}
-			else
+			for (int j = 0; j < audioChannels.size(); j++)
 			{
-				float update = CabbageWidgetData::getProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::update);
-				if (update == 1.0f)
-					CabbageWidgetData::setProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::update,
-						0);
+				if (audioChannels[j].toString().isNotEmpty())
+					addSignalTap(audioChannels[j].toString(), isSpectrum,
+						CabbageWidgetData::getNumProp(widget, CabbageIdentifierIds::updaterate),
+						CabbageWidgetData::getNumProp(widget, CabbageIdentifierIds::peakhold));
 			}
 		}
 
-		// reset value for widgets without identchannel
-		else
+		const String identChannel = CabbageWidgetData::getStringProp(widget, CabbageIdentifierIds::identchannel);
+
+		if (identChannel.isNotEmpty())
 		{
-			CabbageWidgetData::setProperty(cabbageWidgets.getChild(i), CabbageIdentifierIds::update,
-				0);
+			channelBindings.identWidgetIndices.add(i);
+			channelBindings.identChannelNames.add(identChannel);
+			channelBindings.widgetIndexByChannel.set(identChannel, i);
 		}
+
+		if (float(CabbageWidgetData::getProperty(widget, CabbageIdentifierIds::update)) != 0.f)
+			channelBindings.pendingUpdateResets.add(i);
 	}
 }
 
-void CabbagePluginProcessor::triggerCsoundEvents() {
+//==============================================================================
+// Applies identifier text from an identchannel or from cabbageSet to a widget
+//==============================================================================
+void CabbagePluginProcessor::applyIdentifierText(ValueTree widget, const String& identifierText)
+{
+    CabbageWidgetData::setCustomWidgetState(widget, " " + identifierText);
+    
+    if(CabbageWidgetData::getStringProp(widget, CabbageIdentifierIds::type) == CabbageWidgetTypes::form)
+    {
+        double scale = CabbageWidgetData::getNumProp(widget, CabbageIdentifierIds::scale);
+        
+        CabbagePluginEditor* editor = static_cast<CabbagePluginEditor*> (this->getActiveEditor());
+#ifdef Cabbage_IDE_Build
+        double pluginWidth = CabbageWidgetData::getNumProp(widget, CabbageIdentifierIds::width);
+        double pluginHeight = CabbageWidgetData::getNumProp(widget, CabbageIdentifierIds::height);
+        editor->setSize(pluginWidth*scale, pluginHeight*scale);
+#endif
+        editor->setScaleFactor(scale);
+        editor->resized();
+    }
+	
+
+	if (identifierText.contains("tablenumber")) //update even if table number has not changed
+		CabbageWidgetData::setProperty(widget, CabbageIdentifierIds::update, 1);
+	else if (identifierText == CabbageIdentifierIds::tofront.toString() + "()") {
+		CabbageWidgetData::setProperty(widget, CabbageIdentifierIds::tofront,
+			Random::getSystemRandom().nextInt());
+	}
+
+	CabbageWidgetData::setProperty(widget, CabbageIdentifierIds::update,
+		0); //reset value for further updates
+}
+
+//==============================================================================
+// This method is responsible for updating widget valuetrees based on the current
+// data stored in each widget's software channel bus. 
+//==============================================================================
+void CabbagePluginProcessor::csoundInstanceChanged()
+{
+	//identchannel data pointers belong to the old instance, look them up again on the next poll
+	channelBindings.identResolvedFor = nullptr;
+}
+
+void CabbagePluginProcessor::getChannelDataFromCsound()
+{
 	if (!getCsound())
 		return;
 
-	for (int x = 0; x < matrixEventSequencers.size(); x++) {
-		const ValueTree widgetData = CabbageWidgetData::getValueTreeForComponent(cabbageWidgets,
-			matrixEventSequencers[x]->channel,
-			true);
-		const String channel = CabbageWidgetData::getStringProp(widgetData, CabbageIdentifierIds::channel);
-		const int position = getCsound()->GetChannel(channel.toUTF8());
-
-		if (CabbageWidgetData::getStringProp(widgetData, CabbageIdentifierIds::orientation) == "vertical") {
-			for (int i = 0; i < CabbageWidgetData::getNumProp(widgetData, CabbageIdentifierIds::matrixcols); i++) {
-				if (matrixEventSequencers[x]->position != position) {
-					String event = matrixEventSequencers[x]->events.getUnchecked(i)->getReference(position);
-					if (event.isNotEmpty()) {
-						getCsound()->InputMessage(event.toUTF8());
-					}
-				}
+	if (channelBindings.widgetCount != cabbageWidgets.getNumChildren())
+		buildChannelBindings();
+
+	ChannelBindings& bindings = channelBindings;
+    const int chnsetGestureMode = getChnsetGestureMode();
+
+	for (int i = 0; i < bindings.size(); i++)
+	{
+		const uint8 kind = bindings.kinds.getUnchecked(i);
+
+		if (kind == ChannelBindings::stringValue)
+		{
+			char tmp_str[4096] = { 0 };
+			getCsound()->GetStringChannel(bindings.channelNames[i].toUTF8(), tmp_str);
+
+			//firstValues still holds NaN until the string has been read once
+			if (bindings.lastStrings[i] != tmp_str || std::isnan(bindings.firstValues.getUnchecked(i)))
+			{
+				bindings.firstValues.setUnchecked(i, 0);
+				bindings.lastStrings.set(i, String(tmp_str));
+				CabbageWidgetData::setProperty(cabbageWidgets.getChild(bindings.widgetIndices.getUnchecked(i)),
+					CabbageIdentifierIds::value, String(tmp_str));
 			}
+			continue;
 		}
-		else //horizontal
+
+		ChannelPointer* const first = bindings.firstChannels.getUnchecked(i);
+		ChannelPointer* const second = bindings.secondChannels.getUnchecked(i);
+
+		//channels are unresolved while a recompile is being swapped in
+		if (!first->isValid() || (second != nullptr && !second->isValid()))
+			continue;
+
+		//mid-ramp values are the smoother's own, writing them back would cut the ramp short
+		if (CabbagePluginParameter* cabbageParam = bindings.parameters.getUnchecked(i))
+			if (cabbageParam->isRamping())
+				continue;
+
+		const MYFLT firstValue = first->get();
+		const MYFLT secondValue = second != nullptr ? second->get() : 0;
+
+		if (firstValue == bindings.firstValues.getUnchecked(i) && secondValue == bindings.secondValues.getUnchecked(i))
+			continue;
+
+		bindings.firstValues.setUnchecked(i, firstValue);
+		bindings.secondValues.setUnchecked(i, secondValue);
+
+		ValueTree widget = cabbageWidgets.getChild(bindings.widgetIndices.getUnchecked(i));
+
+		if (kind == ChannelBindings::numericValue)
 		{
-			for (int i = 0; i < CabbageWidgetData::getNumProp(widgetData, CabbageIdentifierIds::matrixrows); i++) {
-				if (matrixEventSequencers[x]->position != position) {
-					String event = matrixEventSequencers[x]->events.getUnchecked(position)->getReference(i);
-					if (event.isNotEmpty()) {
-						getCsound()->InputMessage(event.toUTF8());
+			//the GUI may already hold this value if it was the one that set the channel
+			if (float(CabbageWidgetData::getProperty(widget, CabbageIdentifierIds::value)) != float(firstValue))
+			{
+				CabbageWidgetData::setNumProp(widget, CabbageIdentifierIds::value, firstValue);
+				//now update plugin parameters..
+
+				if (chnsetGestureMode == 1) // by default, we don't call beginChangeGesture()...
+				{
+					if (CabbagePluginParameter* cabbageParam = bindings.parameters.getUnchecked(i))
+					{
+						cabbageParam->beginChangeGesture();
+						cabbageParam->setValueNotifyingHost(cabbageParam->getNormalisableRange().convertTo0to1(firstValue));
+						cabbageParam->endChangeGesture();
 					}
 				}
 			}
 		}
-		matrixEventSequencers[x]->position = position;
+		else if (kind == ChannelBindings::xyPad)
+		{
+			CabbageWidgetData::setNumProp(widget, CabbageIdentifierIds::valuex, firstValue);
+			CabbageWidgetData::setNumProp(widget, CabbageIdentifierIds::valuey, secondValue);
+		}
+		else if (kind == ChannelBindings::rangeSlider)
+		{
+			CabbageWidgetData::setNumProp(widget, CabbageIdentifierIds::minvalue, firstValue);
+			CabbageWidgetData::setNumProp(widget, CabbageIdentifierIds::maxvalue, secondValue);
+		}
+	}
+
+	//widget updates pushed from the orchestra with cabbageSet
+	CabbageWidgetMessageQueue::Message message;
+	while (getWidgetMessageQueue() != nullptr && getWidgetMessageQueue()->pop(message))
+	{
+		const String channel(CharPointer_UTF8(message.channel));
+
+		if (bindings.widgetIndexByChannel.contains(channel))
+			applyIdentifierText(cabbageWidgets.getChild(bindings.widgetIndexByChannel[channel]), String(CharPointer_UTF8(message.text)));
 	}
+
+	//identchannels set with chnset still work, but are only copied out when something was written to them
+	CSOUND* const cs = getCsound()->GetCsound();
+	if (bindings.identResolvedFor != cs)
+	{
+		bindings.identResolvedFor = cs;
+		bindings.identData.clearQuick();
+		bindings.identLocks.clearQuick();
+
+		for (auto& identChannel : bindings.identChannelNames)
+		{
+			MYFLT* data = nullptr;
+			if (csoundGetChannelPtr(cs, &data, identChannel.toUTF8(),
+				CSOUND_STRING_CHANNEL | CSOUND_INPUT_CHANNEL | CSOUND_OUTPUT_CHANNEL) != 0)
+				data = nullptr;
+
+			bindings.identData.add((STRINGDAT*) data);
+			bindings.identLocks.add(data != nullptr ? csoundGetChannelLock(cs, identChannel.toUTF8()) : nullptr);
+		}
+	}
+
+	for (int i = 0; i < bindings.identWidgetIndices.size(); i++)
+	{
+		STRINGDAT* const identData = bindings.identData.getUnchecked(i);
+		int* const lock = bindings.identLocks.getUnchecked(i);
+
+		if (identData == nullptr)
+			continue;
+
+		if (lock != nullptr)
+			csoundSpinLock(lock);
+		const bool hasMessage = identData->data != nullptr && identData->data[0] != 0;
+		if (lock != nullptr)
+			csoundSpinUnLock(lock);
+
+		if (!hasMessage)
+			continue;
+
+		ValueTree widget = cabbageWidgets.getChild(bindings.identWidgetIndices.getUnchecked(i));
+		const String& identChannel = bindings.identChannelNames[i];
+
+		memset(&tmp_string[0], 0, sizeof(tmp_string));
+		getCsound()->GetStringChannel(identChannel.toUTF8(), tmp_string);
+
+		const String identifierText(tmp_string);
+		//CabbageUtilities::debug(identifierText);
+		if (identifierText.isNotEmpty() && identifierText != CabbageWidgetData::getStringProp(widget, CabbageIdentifierIds::identchannelmessage))
+		{
+			applyIdentifierText(widget, identifierText);
+			getCsound()->SetChannel(identChannel.toUTF8(), (char*) "");
+		}
+	}
+
+	//clear the update flags widgets were created with
+	for (auto widgetIndex : bindings.pendingUpdateResets)
+		CabbageWidgetData::setProperty(cabbageWidgets.getChild(widgetIndex), CabbageIdentifierIds::update, 0);
+
+	bindings.pendingUpdateResets.clearQuick();
 }
 
 //================================================================================
@@ -1389,15 +1469,7 @@ void CabbagePluginProcessor::enableXYAutomator(String name, bool enable, Line<fl
 
 //======================================================================================================
 CabbagePluginParameter* CabbagePluginProcessor::getParameterForXYPad(String name) {
-	for (auto param : getCabbageParameters()) {
-		if (CabbagePluginParameter * cabbageParam = dynamic_cast<CabbagePluginParameter*> (param)) {
-			DBG(cabbageParam->getWidgetName());
-			if (name == cabbageParam->getWidgetName())
-				return dynamic_cast<CabbagePluginParameter*> (cabbageParam);
-		}
-	}
-
-	return nullptr;
+	return getParameterForWidget(name);
 }
 
 //==============================================================================
@@ -1408,6 +1480,13 @@ void CabbagePluginProcessor::setCabbageParameter(String channel, float value) {
 	getCsound()->SetChannel(channel.toUTF8().getAddress(), value);
 }
 
+void CabbagePluginProcessor::setCabbageParameter(SmoothedParameter* parameter, float value) {
+	if (parameter == nullptr || !getCsound())
+		return;
+
+	queueParameterChange(parameter, value);
+}
+
 void CabbagePluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
 	bool csoundRecompiled = false;
@@ -67,18 +67,21 @@ public:
 
 	CabbagePluginProcessor (File inputFile, AudioChannelSet ins, AudioChannelSet outs);
     CabbagePluginProcessor (File inputFile, AudioChannelSet ins, AudioChannelSet outs, AudioChannelSet sidechain);
-	void createCsound(File inputFile, bool shouldCreateParameters = true);
+	//compileInBackground keeps the current instance running until the new one is ready
+	void createCsound(File inputFile, bool shouldCreateParameters = true, bool compileInBackground = false);
     ~CabbagePluginProcessor();
 
     ValueTree cabbageWidgets;
     void getChannelDataFromCsound() override;
-    void triggerCsoundEvents() override;
+    void csoundInstanceChanged() override;
     void setWidthHeight();
     bool addImportFiles (StringArray& lineFromCsd);
     void parseCsdFile (StringArray& linesFromCsd);
     // use this instead of AudioProcessor::addParameter
     void addCabbageParameter(std::unique_ptr<CabbagePluginParameter> parameter);
     void createCabbageParameters();
+    void buildChannelBindings();
+    void applyIdentifierText (ValueTree widget, const String& identifierText);
     void updateWidgets (String csdText);
     void handleXmlImport (XmlElement* xml, StringArray& linesFromCsd);
     void getMacros (const StringArray& csdText);
@@ -92,6 +95,7 @@ public:
     void expandMacroText (String &line, ValueTree wData);
 	void prepareToPlay(double sampleRate, int samplesPerBlock) override;
 	void setCabbageParameter(String channel, float value);
+	void setCabbageParameter(SmoothedParameter* parameter, float value);
     CabbagePluginParameter* getParameterForXYPad (String name);
     //==============================================================================
     AudioProcessorEditor* createEditor() override;
@@ -121,19 +125,22 @@ public:
 
 	StringArray getCurrentCsdFileAsStringArray()
 	{
-		StringArray csdArray;
-		csdArray.addLines(csdFile.loadFileAsString());
-		return csdArray;
+		return CsdDocument::load(csdFile)->getLines();
 	}
     
     // use this instead of AudioProcessor::getParameters
     const OwnedArray<CabbagePluginParameter>& getCabbageParameters() const { return parameters; }
+    // hashed lookups, these return nullptr if there is no parameter for the widget or channel
+    CabbagePluginParameter* getParameterForWidget (const String& widgetName) const { return parametersByWidgetName[widgetName]; }
+    CabbagePluginParameter* getParameterForChannel (const String& channel) const { return parametersByChannel[channel]; }
     
 private:
     controlChannelInfo_s* csoundChanList;
     int numberOfLinesInPlantCode = 0;
     String pluginName;
     File csdFile;
+    //keeps the parsed .csd shared with the compile and the editor until the next reload
+    CsdDocument::Ptr csdDocument;
     int linesToSkip = 0;
     NamedValueSet macroText;
     var macroNames;
@@ -146,6 +153,80 @@ private:
 	bool isUnityPlugin = false;
     int automationMode = 0;
     OwnedArray<CabbagePluginParameter> parameters;
+    //filled in by addCabbageParameter(), the first parameter added for a name wins
+    HashMap<String, CabbagePluginParameter*> parametersByWidgetName, parametersByChannel;
+
+    //flat table of the widget channels polled by getChannelDataFromCsound(). It is built
+    //once per compile so each update is a tight loop over cached channel pointers, and the
+    //ValueTree is only touched for channels whose value has changed
+    struct ChannelBindings
+    {
+        enum Kind
+        {
+            numericValue, stringValue, xyPad, rangeSlider
+        };
+
+        void add (int widgetIndex, Kind kind, ChannelPointer* first, ChannelPointer* second, const String& channelName,
+                  CabbagePluginParameter* parameter = nullptr)
+        {
+            widgetIndices.add (widgetIndex);
+            parameters.add (parameter);
+            kinds.add ((uint8) kind);
+            firstChannels.add (first);
+            secondChannels.add (second);
+            //NaN never compares equal, so the first pass checks every widget against Csound
+            firstValues.add (std::numeric_limits<MYFLT>::quiet_NaN());
+            secondValues.add (std::numeric_limits<MYFLT>::quiet_NaN());
+            channelNames.add (channelName);
+            lastStrings.add (String());
+        }
+
+        void clear()
+        {
+            widgetIndices.clearQuick();
+            parameters.clearQuick();
+            kinds.clearQuick();
+            firstChannels.clearQuick();
+            secondChannels.clearQuick();
+            firstValues.clearQuick();
+            secondValues.clearQuick();
+            channelNames.clearQuick();
+            lastStrings.clearQuick();
+            identWidgetIndices.clearQuick();
+            identChannelNames.clearQuick();
+            identData.clearQuick();
+            identLocks.clearQuick();
+            identResolvedFor = nullptr;
+            widgetIndexByChannel.clear();
+            pendingUpdateResets.clearQuick();
+            widgetCount = -1;
+        }
+
+        int size() const { return widgetIndices.size(); }
+
+        Array<int> widgetIndices;
+        //host parameter for the channel, notified of changes in chnset gesture mode
+        Array<CabbagePluginParameter*> parameters;
+        Array<uint8> kinds;
+        Array<ChannelPointer*> firstChannels, secondChannels;
+        Array<MYFLT> firstValues, secondValues;
+        StringArray channelNames, lastStrings;
+        //identchannels carry strings, so they are kept apart from the numeric bindings. Their
+        //channel data is resolved per instance so an empty channel can be skipped without a copy
+        Array<int> identWidgetIndices;
+        StringArray identChannelNames;
+        Array<STRINGDAT*> identData;
+        Array<int*> identLocks;
+        CSOUND* identResolvedFor = nullptr;
+        //channel and identchannel names to widget indices, for messages sent with cabbageSet
+        HashMap<String, int> widgetIndexByChannel;
+        //update flags set when widgets were created only need clearing once
+        Array<int> pendingUpdateResets;
+        //number of widgets the table was built from, it's rebuilt when widgets are added
+        int widgetCount = -1;
+    };
+
+    ChannelBindings channelBindings;
 
 };
 
@@ -236,6 +317,8 @@ public:
     
     const String getChannel() const { return parameter->getChannel(); }
     const String getWidgetName() { return widgetName; }
+    //true while the audio thread is still smoothing towards the last value written
+    bool isRamping() const { return parameter->smoothedParameter != nullptr && parameter->smoothedParameter->isRamping(); }
     bool getIsAutomatable() const { return isAutomatable; }
     
 private:
@@ -248,7 +331,10 @@ private:
         void setValue(float newValue) override
         {
             currentValue = isCombo ? juce::roundToInt(range.convertFrom0to1 (newValue)) : range.convertFrom0to1 (newValue);
-            processor->setCabbageParameter(channel, currentValue);
+            if (smoothedParameter != nullptr)
+                processor->setCabbageParameter(smoothedParameter, currentValue);
+            else
+                processor->setCabbageParameter(channel, currentValue);
         }
         
         String getText(float normalizedValue, int length) const override
@@ -318,7 +404,11 @@ private:
         currentValue(def),
         isCombo(isCombo),
         owner(owner),
-        processor(proc)
+        processor(proc),
+        smoothedParameter(CabbageWidgetData::getStringProp(wData, CabbageIdentifierIds::channeltype) == "string" ? nullptr
+                          : proc->registerSmoothedParameter(proc->registerChannel(channelToUse),
+                                                            CabbageWidgetData::getNumProp(wData, CabbageIdentifierIds::smoothing),
+                                                            CabbageWidgetData::getStringProp(wData, CabbageIdentifierIds::smoothingtype) == "exponential"))
         {
             
         }
@@ -331,6 +421,9 @@ private:
         
         CabbagePluginParameter& owner;
         CabbagePluginProcessor* processor;
+        //resolved once, so automation writes never look the channel up by name. Writes
+        //are queued and reach Csound on the audio thread at the next k-boundary
+        SmoothedParameter* smoothedParameter;
         
         mutable bool showingAffixes = true;
         
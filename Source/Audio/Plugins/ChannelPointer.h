@@ -0,0 +1,121 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef CHANNELPOINTER_H_INCLUDED
+#define CHANNELPOINTER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <csound.hpp>
+
+//==================================================================================
+// A control channel resolved through csoundGetChannelPtr() so it can be read and
+// written without hashing its name or going through SetChannel(). Pointers belong
+// to the Csound instance they were resolved against, and resolveChannelPointers()
+// refreshes them each time Csound is compiled. A background reload prepares them
+// against its instance and the audio thread commits them when it swaps that in.
+class ChannelPointer
+{
+public:
+    explicit ChannelPointer (String channelName) : name (channelName) {}
+
+    //message thread. Points the channel at cs straight away
+    void resolve (CSOUND* cs)
+    {
+        prepare (cs);
+        pending = false;
+        active = getSpare();
+    }
+
+    //message thread. Looks the channel up in an instance that isn't running yet and
+    //leaves the live binding alone until commit() is called
+    void prepare (CSOUND* cs)
+    {
+        Binding& spare = *getSpare();
+        spare.instance = cs;
+        spare.data = nullptr;
+        spare.lock = nullptr;
+
+        if (cs != nullptr && csoundGetChannelPtr (cs, &spare.data, name.toUTF8().getAddress(),
+                                                  CSOUND_CONTROL_CHANNEL | CSOUND_INPUT_CHANNEL | CSOUND_OUTPUT_CHANNEL) == 0)
+            spare.lock = csoundGetChannelLock (cs, name.toUTF8().getAddress());
+        else
+            spare.data = nullptr;
+
+        pending = true;
+    }
+
+    //audio thread, when the instance passed to prepare() is swapped in
+    void commit()
+    {
+        if (pending.exchange (false))
+            active = getSpare();
+    }
+
+    void set (MYFLT value) const
+    {
+        const Binding& binding = *active.load();
+
+        if (binding.data == nullptr)
+            return;
+
+        if (binding.lock != nullptr)
+            csoundSpinLock (binding.lock);
+        *binding.data = value;
+        if (binding.lock != nullptr)
+            csoundSpinUnLock (binding.lock);
+    }
+
+    MYFLT get() const
+    {
+        const Binding& binding = *active.load();
+
+        if (binding.data == nullptr)
+            return 0;
+
+        if (binding.lock != nullptr)
+            csoundSpinLock (binding.lock);
+        const MYFLT value = *binding.data;
+        if (binding.lock != nullptr)
+            csoundSpinUnLock (binding.lock);
+        return value;
+    }
+
+    bool isValid() const { return active.load()->data != nullptr; }
+    bool isResolvedFor (CSOUND* cs) const { return active.load()->instance == cs; }
+    const String& getName() const { return name; }
+
+private:
+    //the live binding is swapped as a whole, so a reader never pairs data from one
+    //instance with the lock from another
+    struct Binding
+    {
+        CSOUND* instance = nullptr;
+        MYFLT* data = nullptr;
+        int* lock = nullptr;
+    };
+
+    Binding* getSpare() noexcept    { return active.load() == &bindings[0] ? &bindings[1] : &bindings[0]; }
+
+    const String name;
+    Binding bindings[2];
+    std::atomic<Binding*> active { &bindings[0] };
+    std::atomic<bool> pending { false };
+};
+
+#endif  // CHANNELPOINTER_H_INCLUDED
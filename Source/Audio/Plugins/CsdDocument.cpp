@@ -0,0 +1,197 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#include "CsdDocument.h"
+#include "../../Utilities/CabbageUtilities.h"
+#include "../../Widgets/CabbageWidgetData.h"
+#ifdef CabbagePro
+#include "../../Utilities/encrypt.h"
+#endif
+
+//==============================================================================
+static CriticalSection& getCsdDocumentLock()
+{
+    static CriticalSection lock;
+    return lock;
+}
+
+//one per file, dropped when nothing holds it any more or the file changes
+static std::vector<std::weak_ptr<const CsdDocument>>& getSharedCsdDocuments()
+{
+    static std::vector<std::weak_ptr<const CsdDocument>> documents;
+    return documents;
+}
+
+CsdDocument::Ptr CsdDocument::load (const File& file)
+{
+    {
+        const ScopedLock sl (getCsdDocumentLock());
+        const int64 lastModified = file.getLastModificationTime().toMilliseconds();
+        const int64 size = file.getSize();
+
+        for (auto& shared : getSharedCsdDocuments())
+        {
+            if (Ptr document = shared.lock())
+                if (document->file == file && document->modificationTime == lastModified && document->fileSize == size)
+                    return document;
+        }
+    }
+
+    const String fileText = file.loadFileAsString();
+    //Pro files are encrypted, so only the decoded text can be parsed
+#ifdef CabbagePro
+    const String text = Encrypt::decode (file);
+#else
+    const String& text = fileText;
+#endif
+
+    return share (new CsdDocument (file, text, fileText.contains ("<Csound") || fileText.contains ("</Csound")));
+}
+
+CsdDocument::Ptr CsdDocument::create (const File& file, const String& text)
+{
+    return share (new CsdDocument (file, text, text.contains ("<Csound") || text.contains ("</Csound")));
+}
+
+CsdDocument::Ptr CsdDocument::share (CsdDocument* newDocument)
+{
+    Ptr document (newDocument);
+    const ScopedLock sl (getCsdDocumentLock());
+    auto& documents = getSharedCsdDocuments();
+
+    documents.erase (std::remove_if (documents.begin(), documents.end(), [&document] (const std::weak_ptr<const CsdDocument>& shared)
+    {
+        const Ptr existing = shared.lock();
+        return existing == nullptr || existing->file == document->file;
+    }), documents.end());
+
+    documents.push_back (document);
+    return document;
+}
+
+CsdDocument::CsdDocument (const File& csdFile, const String& csdText, bool hasCsoundTags) :
+    file (csdFile),
+    text (csdText),
+    modificationTime (csdFile.getLastModificationTime().toMilliseconds()),
+    fileSize (csdFile.getSize()),
+    csoundTags (hasCsoundTags)
+{
+    lines.addLines (text);
+
+    int cabbageStart = -1, cabbageEnd = -1;
+    bool inBlockComment = false;
+
+    for (int i = 0; i < lines.size(); i++)
+    {
+        const String& line = lines.getReference (i);
+
+        if (cabbageStart < 0 && line.contains ("<Cabbage"))
+            cabbageStart = i;
+
+        if (cabbageStart >= 0 && cabbageEnd < 0)
+        {
+            const String trimmed = line.trim();
+
+            if (trimmed.startsWith ("#define"))
+                addMacroOption (trimmed);
+            //the widget parser is only run on the line that can be the form
+            else if (! form.isValid() && trimmed.startsWith ("form"))
+            {
+                ValueTree temp ("temp");
+                CabbageWidgetData::setWidgetState (temp, line, 0);
+
+                if (CabbageWidgetData::getStringProp (temp, CabbageIdentifierIds::type) == CabbageWidgetTypes::form)
+                    form = temp;
+            }
+
+            if (line.contains ("</Cabbage>"))
+                cabbageEnd = i;
+        }
+        else
+        {
+            if (instrumentsStart < 0 && line.trim() == "<CsInstruments>")
+                instrumentsStart = i;
+
+            if (instrumentsStart >= 0)
+                addHeaderValue (line, inBlockComment);
+        }
+    }
+
+    if (cabbageStart >= 0)
+        cabbageSection = Range<int> (cabbageStart, cabbageEnd < 0 ? lines.size() : cabbageEnd + 1);
+}
+
+void CsdDocument::addMacroOption (const String& line)
+{
+    StringArray tokens;
+    tokens.addTokens (line.replace ("#", "").trim(), " ");
+    const String macroName = tokens[1];
+    tokens.removeRange (0, 2);
+    macroOptions.add ("--omacro:" + macroName + "=" + tokens.joinIntoString (" "));
+}
+
+void CsdDocument::addHeaderValue (const String& line, bool& inBlockComment)
+{
+    String code;
+
+    for (int position = 0;;)
+    {
+        if (inBlockComment)
+        {
+            const int commentEnd = line.indexOf (position, "*/");
+
+            if (commentEnd < 0)
+                break;
+
+            position = commentEnd + 2;
+            inBlockComment = false;
+        }
+
+        const int commentStart = line.indexOf (position, "/*");
+        code << line.substring (position, commentStart < 0 ? line.length() : commentStart);
+
+        if (commentStart < 0)
+            break;
+
+        position = commentStart + 2;
+        inBlockComment = true;
+    }
+
+    code = code.upToFirstOccurrenceOf (";", false, false).upToFirstOccurrenceOf ("//", false, false);
+    const int equals = code.indexOfChar ('=');
+
+    if (equals <= 0)
+        return;
+
+    //only plain assignments such as "nchnls = 2", the first one for each name wins
+    const String name = code.substring (0, equals).trim();
+
+    if (name.isEmpty() || name.containsAnyOf (" \t=<>!") || headerValues.contains (name))
+        return;
+
+    headerValues.set (name, code.substring (equals + 1).trim().getIntValue());
+}
+
+int CsdDocument::getHeaderValue (const String& name, int defaultValue) const
+{
+    if (const var* value = headerValues.getVarPointer (name))
+        return *value;
+
+    return defaultValue;
+}
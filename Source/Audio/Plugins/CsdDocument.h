@@ -0,0 +1,78 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef CSDDOCUMENT_H_INCLUDED
+#define CSDDOCUMENT_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//==================================================================================
+// Everything the plugin needs from a .csd, found in a single pass. The file is read,
+// and decoded for Pro builds, once. The same pass finds the Cabbage section and its
+// form, the Cabbage macros, and the orchestra header assignments. Documents never
+// change after they are built, so they are passed around as shared pointers and a
+// background compile can hold one too. load() keeps one document per file for the
+// whole process until the file changes on disk, so the plugin factory, the processor
+// and the editor all share a single parse.
+class CsdDocument
+{
+public:
+    using Ptr = std::shared_ptr<const CsdDocument>;
+
+    static Ptr load (const File& file);
+    //for text that has just been written to file, such as a csd with its imports expanded
+    static Ptr create (const File& file, const String& text);
+
+    const File& getFile() const noexcept                { return file; }
+    const String& getText() const noexcept              { return text; }
+    const StringArray& getLines() const noexcept        { return lines; }
+
+    //line indices, the section runs from the <Cabbage> line to the </Cabbage> line
+    Range<int> getCabbageSection() const noexcept       { return cabbageSection; }
+    int getInstrumentsStart() const noexcept            { return instrumentsStart; }
+    bool hasCsoundTags() const noexcept                 { return csoundTags; }
+
+    //the form's widget state, invalid when there is no form
+    const ValueTree& getForm() const noexcept           { return form; }
+    //the first orchestra header assignment to name, such as sr or nchnls
+    int getHeaderValue (const String& name, int defaultValue = -1) const;
+    //--omacro options for the #defines in the Cabbage section
+    const StringArray& getMacroOptions() const noexcept { return macroOptions; }
+
+private:
+    CsdDocument (const File& file, const String& text, bool csoundTags);
+    static Ptr share (CsdDocument* newDocument);
+    void addMacroOption (const String& line);
+    void addHeaderValue (const String& line, bool& inBlockComment);
+
+    const File file;
+    const String text;
+    StringArray lines;
+    int64 modificationTime = 0, fileSize = 0;
+    Range<int> cabbageSection;
+    int instrumentsStart = -1;
+    const bool csoundTags;
+    ValueTree form;
+    NamedValueSet headerValues;
+    StringArray macroOptions;
+
+    JUCE_DECLARE_NON_COPYABLE (CsdDocument)
+};
+
+#endif  // CSDDOCUMENT_H_INCLUDED
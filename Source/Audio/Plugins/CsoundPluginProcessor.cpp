@@ -22,6 +22,10 @@
 #include "../../Utilities/CabbageUtilities.h"
 #include "../../Widgets/CabbageWidgetData.h"
 
+#if JUCE_USE_SSE_INTRINSICS
+ #include <emmintrin.h>
+#endif
+
 
 //==============================================================================
 CsoundPluginProcessor::CsoundPluginProcessor (File csdFile, const AudioChannelSet ins, const AudioChannelSet outs)
@@ -36,6 +40,9 @@ CsoundPluginProcessor::CsoundPluginProcessor (File csdFile, const AudioChannelSe
       csdFile (csdFile)
 {
     hostInfo = {};
+#if !defined(Cabbage_IDE_Build)
+    isLogic = PluginHostType().isLogic();
+#endif
 	matchingNumberOfIOChannels = getTotalNumInputChannels() == getTotalNumOutputChannels() ? true : false;
     numCsoundOutputChannels = getBus(false, 0)->getNumberOfChannels();
     CabbageUtilities::debug("Constructor - Requested output channels:", numCsoundOutputChannels);
@@ -43,6 +50,9 @@ CsoundPluginProcessor::CsoundPluginProcessor (File csdFile, const AudioChannelSe
     numCsoundInputChannels = getBus(true, 0)->getNumberOfChannels();
     CabbageUtilities::debug("Constructor - Requested input channels:", numCsoundInputChannels);
 #endif
+    refreshSignalDisplays();
+    //GUI updates run from here on, they're skipped until Csound has compiled
+    guiRefreshScheduler.start (30);
 }
 
 //==============================================================================
@@ -61,6 +71,9 @@ CsoundPluginProcessor::CsoundPluginProcessor(File csdFile, const AudioChannelSet
 	csdFile(csdFile)
 {
     hostInfo = {};
+#if !defined(Cabbage_IDE_Build)
+    isLogic = PluginHostType().isLogic();
+#endif
     numCsoundOutputChannels = getBus(false, 0)->getNumberOfChannels();
 #if ! JucePlugin_IsSynth && ! JucePlugin_IsSynth
 
@@ -70,10 +83,15 @@ CsoundPluginProcessor::CsoundPluginProcessor(File csdFile, const AudioChannelSet
 	matchingNumberOfIOChannels = false;
 	supportsSidechain = true;
     numSideChainChannels = getBus(true, 1)->getNumberOfChannels();
+    refreshSignalDisplays();
+    //GUI updates run from here on, they're skipped until Csound has compiled
+    guiRefreshScheduler.start (30);
 }
 
 CsoundPluginProcessor::~CsoundPluginProcessor()
 {
+    guiRefreshScheduler.stop();
+	recompilePool.removeAllJobs (true, 10000);
 	resetCsound();
 }
 
@@ -87,6 +105,7 @@ void CsoundPluginProcessor::resetCsound()
 	if (csound)
 	{
 #if !defined(Cabbage_Lite)
+        performingCsound = nullptr;
 		csound = nullptr;
 #endif
 		csoundParams = nullptr;
@@ -99,941 +118,2271 @@ void CsoundPluginProcessor::resetCsound()
 bool CsoundPluginProcessor::setupAndCompileCsound(File currentCsdFile, File filePath, int sr, bool isMono, bool debugMode)
 {
     
+    //a reload still in flight was built from older settings
+    cancelBackgroundRecompile();
+
     csdFile = currentCsdFile;
-    
-    StringArray csdLines;
-    csdLines.addLines(csdFile.loadFileAsString());
-    for (auto line : csdLines)
+	csdFilePath = filePath;
+
+    //this path replaces the running instance in place, so the old one goes first
+    csCompileResult = -1;
+    performingCsound = nullptr;
+	csound = nullptr;
+    midiScheduler.clear();
+    releaseSignalDisplays (nullptr);
+    refreshSignalDisplays();
+
+    PreparedCsound prepared = describeHost (isMono);
+    createCsoundInstance (prepared, *CsdDocument::load (currentCsdFile), sr, isMono, debugMode);
+
+    if (prepared.monoSideChain)
+        getBus (true, 1)->setNumberOfChannels (1);
+
+    applyPreparedSettings (prepared);
+	csoundParams = std::move (prepared.params);
+	csound = std::move (prepared.csound);
+    widgetMessages = std::move (prepared.widgetMessages);
+    performingCsound = csound.get();
+	csCompileResult = prepared.compileResult;
+    csoundInstanceChanged();
+    oversamplingFactor = prepared.oversampling;
+    compiledForNonRealtime = prepared.nonRealtime;
+
+	if (csdCompiledWithoutError())
+	{
+		csdKsmps = prepared.ksmps;
+		CSspout = prepared.spout;
+		CSspin = prepared.spin;
+		cs_scale = prepared.scale;
+		csndIndex = prepared.ksmps;
+        controlRate = prepared.kr;
+        numCutKCycles = 0;
+        cutKCyclesReported = false;
+        resolveChannelPointers();
+        resolveMatrixEventSequencerInstruments (csound->GetCsound(), nullptr);
+        sleeping = false;
+        silentSamples = 0;
+        startGuiRefresh();
+
+        if (preferredLatency == -1)
+        {
+            const String mode = String("Cabbage: zero latency mode, running in chunks of ") + String(csdKsmps)
+                                + (hostBlockSize > 0 && (hostBlockSize * oversamplingFactor) % csdKsmps == 0 ? " samples\n" : " samples (block size not aligned)\n");
+            csound->Message(mode.toRawUTF8());
+        }
+        const String version = String("Cabbage version:")+ProjectInfo::versionString+String("\n");
+        csound->Message(version.toRawUTF8());
+
+    }
+	else
+		CabbageUtilities::debug("Csound could not compile your file?");
+
+    return csdCompiledWithoutError();
+
+}
+
+
+//==============================================================================
+//takes what a compile needs to know about the host. Call this on the thread that asks
+//for the compile, createCsoundInstance() only reads the copy
+PreparedCsound CsoundPluginProcessor::describeHost (bool isMono)
+{
+    PreparedCsound prepared;
+    prepared.hostBlockSize = hostBlockSize;
+    prepared.nonRealtime = isNonRealtime();
+    prepared.stateData = getInternalState();
+    prepared.preferredLatency = preferredLatency;
+    prepared.nativeKsmps = nativeKsmps;
+    prepared.matchingNumberOfIOChannels = matchingNumberOfIOChannels;
+    prepared.numSideChainChannels = numSideChainChannels;
+
+    // the host should respect the default inputs and outs, which are determined by the
+    // nhcnls and nchnls_i variables in Csound. But the host is king. If it requested a different
+    // config, we must adhere to it.
+    prepared.numOutputChannels = getBus(false, 0)->getNumberOfChannels();
+    prepared.numInputChannels = numCsoundInputChannels;
+#if ! JucePlugin_IsSynth && ! JucePlugin_IsSynth
+    prepared.numInputChannels = getBus(true, 0)->getNumberOfChannels() + numSideChainChannels;
+#endif
+
+    //this mode is for logic and cubase
+    if (isMono)
+    {
+        prepared.numOutputChannels = 1;
+        prepared.numInputChannels = 1 + (numSideChainChannels > 0 ? 1 : 0);
+        prepared.monoSideChain = supportsSidechain;
+        if (supportsSidechain)
+            prepared.numSideChainChannels = 1;
+    }
+
+    return prepared;
+}
+
+void CsoundPluginProcessor::applyPreparedSettings (const PreparedCsound& prepared)
+{
+    autoSleepTime = prepared.autoSleepTime;
+    offlineKsmps = prepared.offlineKsmps;
+    preferredLatency = prepared.preferredLatency;
+    numCsoundOutputChannels = prepared.numOutputChannels;
+    numCsoundInputChannels = prepared.numInputChannels;
+    numSideChainChannels = prepared.numSideChainChannels;
+    matchingNumberOfIOChannels = prepared.matchingNumberOfIOChannels;
+    nativeKsmps = prepared.nativeKsmps;
+}
+
+//==============================================================================
+//builds and compiles a new instance without touching the one that is running, so
+//this can be called from a background thread. Everything it works out goes into prepared
+void CsoundPluginProcessor::createCsoundInstance (PreparedCsound& prepared, const CsdDocument& document, int sr, bool isMono, bool debugMode)
+{
+    const File& currentCsdFile = document.getFile();
+
     {
-        ValueTree temp("temp");
-        CabbageWidgetData::setWidgetState(temp, line, 0);
+        const ValueTree& temp = document.getForm();
 
-        if (CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::type) == CabbageWidgetTypes::form)
+        if (temp.isValid())
         {
             if(CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::opcodedir).isNotEmpty()) {
-                const String opcodeDir = csdFile.getParentDirectory().getChildFile(
+                const String opcodeDir = currentCsdFile.getParentDirectory().getChildFile(
                         CabbageWidgetData::getStringProp(temp, CabbageIdentifierIds::opcodedir)).getFullPathName();
                 csoundSetOpcodedir(opcodeDir.toUTF8().getAddress());
             }
-            if (CabbageWidgetData::getNumProp(temp, CabbageIdentifierIds::latency) == -1) {
-                preferredLatency = -1;
-            }
+            prepared.preferredLatency = CabbageWidgetData::getNumProp(temp, CabbageIdentifierIds::latency);
+            prepared.autoSleepTime = jmax(0.f, CabbageWidgetData::getNumProp(temp, CabbageIdentifierIds::autosleep));
+            const int oversampling = CabbageWidgetData::getNumProp(temp, CabbageIdentifierIds::oversample);
+            prepared.oversampling = (oversampling == 2 || oversampling == 4 || oversampling == 8) ? oversampling : 1;
+            prepared.offlineKsmps = jmax(0, int(CabbageWidgetData::getNumProp(temp, CabbageIdentifierIds::offlineksmps)));
         }
     }
     
-    CabbageUtilities::debug(csdFile.getFullPathName());
-    
-    // the host should respect the default inputs and outs, which are determined by the
-    // nhcnls and nchnls_i variables in Csound. But the host is king. If it requested a different
-    // config, we must adhere to it.
-    numCsoundOutputChannels = getBus(false, 0)->getNumberOfChannels();
-    CabbageUtilities::debug("SetupAndCompile - Requested output channels:", numCsoundOutputChannels);
+    CabbageUtilities::debug(currentCsdFile.getFullPathName());
+    CabbageUtilities::debug("SetupAndCompile - Requested output channels:", prepared.numOutputChannels);
 #if ! JucePlugin_IsSynth && ! JucePlugin_IsSynth
-    const int inputs = getBus(true, 0)->getNumberOfChannels();
-    numCsoundInputChannels = inputs + numSideChainChannels;
-    CabbageUtilities::debug("SetupAndCompile - Requested input channels:", numCsoundInputChannels);
+    CabbageUtilities::debug("SetupAndCompile - Requested input channels:", prepared.numInputChannels);
 #endif
     //int test = csound->SetGlobalEnv("OPCODE6DIR64", );
     CabbageUtilities::debug("Env var set");
     //csoundSetOpcodedir("/Library/Frameworks/CsoundLib64.framework/Versions/6.0/Resources/Opcodes64");
     //Logger::writeToLog(String::formatted("Resetting csound ...\ncsound = 0x%p", csound.get()));
-	csound.reset (new Csound());
-    
-	csdFilePath = filePath;
+    prepared.csound.reset (new Csound());
+    Csound* const newCsound = prepared.csound.get();
+
 	csdFilePath.setAsCurrentWorkingDirectory();
-	csound->SetHostImplementedMIDIIO(true);
-	csound->SetHostImplementedAudioIO(1, 0);
-	csound->SetHostData(this);
+	newCsound->SetHostImplementedMIDIIO(true);
+	newCsound->SetHostImplementedAudioIO(1, 0);
+	newCsound->SetHostData(this);
 
-    csnd::plugin<StrToFile>((csnd::Csound*) csound->GetCsound(), "strToFile.SSO", "i", "SSO", csnd::thread::i);
-    csnd::plugin<FileToStr>((csnd::Csound*) csound->GetCsound(), "fileToStr.i", "S", "S", csnd::thread::i);
+    csnd::plugin<StrToFile>((csnd::Csound*) newCsound->GetCsound(), "strToFile.SSO", "i", "SSO", csnd::thread::i);
+    csnd::plugin<FileToStr>((csnd::Csound*) newCsound->GetCsound(), "fileToStr.i", "S", "S", csnd::thread::i);
 
-    csnd::plugin<ChannelStateSave>((csnd::Csound*) csound->GetCsound(), "channelStateSave.i", "i", "S", csnd::thread::i);
-    csnd::plugin<ChannelStateSave>((csnd::Csound*) csound->GetCsound(), "channelStateSave.k", "k", "S", csnd::thread::k);
+    csnd::plugin<ChannelStateSave>((csnd::Csound*) newCsound->GetCsound(), "channelStateSave.i", "i", "S", csnd::thread::i);
+    csnd::plugin<ChannelStateSave>((csnd::Csound*) newCsound->GetCsound(), "channelStateSave.k", "k", "S", csnd::thread::k);
 
-    csnd::plugin<ChannelStateRecall>((csnd::Csound*) csound->GetCsound(), "channelStateRecall.i", "i", "S", csnd::thread::i);
-    csnd::plugin<ChannelStateRecall>((csnd::Csound*) csound->GetCsound(), "channelStateRecall.k", "k", "SO", csnd::thread::k);
-    csnd::plugin<ChannelStateRecall>((csnd::Csound*) csound->GetCsound(), "channelStateRecall.k", "k", "SS[]", csnd::thread::k);
+    csnd::plugin<ChannelStateRecall>((csnd::Csound*) newCsound->GetCsound(), "channelStateRecall.i", "i", "S", csnd::thread::i);
+    csnd::plugin<ChannelStateRecall>((csnd::Csound*) newCsound->GetCsound(), "channelStateRecall.k", "k", "SO", csnd::thread::k);
+    csnd::plugin<ChannelStateRecall>((csnd::Csound*) newCsound->GetCsound(), "channelStateRecall.k", "k", "SS[]", csnd::thread::k);
 
     
-    csnd::plugin<StrToArray>((csnd::Csound*) csound->GetCsound(), "strToArray.ii", "S[]", "SS", csnd::thread::i);
-    csnd::plugin<StrRemove>((csnd::Csound*) csound->GetCsound(), "strRemove.ii", "S", "SSo", csnd::thread::i);
+    csnd::plugin<StrToArray>((csnd::Csound*) newCsound->GetCsound(), "strToArray.ii", "S[]", "SS", csnd::thread::i);
+    csnd::plugin<StrRemove>((csnd::Csound*) newCsound->GetCsound(), "strRemove.ii", "S", "SSo", csnd::thread::i);
+
+    csnd::plugin<WriteStateData>((csnd::Csound*) newCsound->GetCsound(), "writeStateData.ss", "i", "iS", csnd::thread::i);
+    csnd::plugin<ReadStateData>((csnd::Csound*) newCsound->GetCsound(), "readStateData.i", "S", "", csnd::thread::i);
+
+    csnd::plugin<GetStateFloatValue>((csnd::Csound*) newCsound->GetCsound(), "getStateValue.s", "i", "S", csnd::thread::i);
+    csnd::plugin<GetStateFloatValue>((csnd::Csound*) newCsound->GetCsound(), "getStateValue.s", "k", "S", csnd::thread::ik);
+    csnd::plugin<GetStateFloatValueArray>((csnd::Csound*) newCsound->GetCsound(), "getStateValue.s", "k[]", "S", csnd::thread::ik);
+    csnd::plugin<GetStateStringValue>((csnd::Csound*) newCsound->GetCsound(), "getStateValue.s", "S", "S", csnd::thread::i);
+    csnd::plugin<GetStateStringValueArray>((csnd::Csound*) newCsound->GetCsound(), "getStateValue.s", "S[]", "S", csnd::thread::ik);
+
+    csnd::plugin<SetStateFloatData>((csnd::Csound*) newCsound->GetCsound(), "setStateValue.s", "k", "Sk", csnd::thread::ik);
+    csnd::plugin<SetStateFloatData>((csnd::Csound*) newCsound->GetCsound(), "setStateValue.s", "i", "Si", csnd::thread::i);
+
+    csnd::plugin<SetStateFloatArrayData>((csnd::Csound*) newCsound->GetCsound(), "setStateValue.s", "i", "Si[]", csnd::thread::i);
+    csnd::plugin<SetStateFloatArrayData>((csnd::Csound*) newCsound->GetCsound(), "setStateValue.s", "k", "Sk[]", csnd::thread::ik);
 
-    csnd::plugin<WriteStateData>((csnd::Csound*) csound->GetCsound(), "writeStateData.ss", "i", "iS", csnd::thread::i);
-    csnd::plugin<ReadStateData>((csnd::Csound*) csound->GetCsound(), "readStateData.i", "S", "", csnd::thread::i);
+    csnd::plugin<SetStateStringData>((csnd::Csound*) newCsound->GetCsound(), "setStateValue.s", "i", "SS", csnd::thread::i);
+    csnd::plugin<SetStateStringData>((csnd::Csound*) newCsound->GetCsound(), "setStateValue.s", "k", "SS", csnd::thread::ik);
 
-    csnd::plugin<GetStateFloatValue>((csnd::Csound*) csound->GetCsound(), "getStateValue.s", "i", "S", csnd::thread::i);
-    csnd::plugin<GetStateFloatValue>((csnd::Csound*) csound->GetCsound(), "getStateValue.s", "k", "S", csnd::thread::ik);
-    csnd::plugin<GetStateFloatValueArray>((csnd::Csound*) csound->GetCsound(), "getStateValue.s", "k[]", "S", csnd::thread::ik);
-    csnd::plugin<GetStateStringValue>((csnd::Csound*) csound->GetCsound(), "getStateValue.s", "S", "S", csnd::thread::i);
-    csnd::plugin<GetStateStringValueArray>((csnd::Csound*) csound->GetCsound(), "getStateValue.s", "S[]", "S", csnd::thread::ik);
+    csnd::plugin<SetStateStringArrayData>((csnd::Csound*) newCsound->GetCsound(), "setStateValue.s", "i", "SS[]", csnd::thread::i);
+    csnd::plugin<SetStateStringArrayData>((csnd::Csound*) newCsound->GetCsound(), "setStateValue.s", "k", "SS[]", csnd::thread::ik);
 
-    csnd::plugin<SetStateFloatData>((csnd::Csound*) csound->GetCsound(), "setStateValue.s", "k", "Sk", csnd::thread::ik);
-    csnd::plugin<SetStateFloatData>((csnd::Csound*) csound->GetCsound(), "setStateValue.s", "i", "Si", csnd::thread::i);
+    csnd::plugin<CabbageSetIdentifiers>((csnd::Csound*) newCsound->GetCsound(), "cabbageSet.i", "", "SS", csnd::thread::i);
+    csnd::plugin<CabbageSetIdentifiers>((csnd::Csound*) newCsound->GetCsound(), "cabbageSet.k", "", "kSS", csnd::thread::k);
 
-    csnd::plugin<SetStateFloatArrayData>((csnd::Csound*) csound->GetCsound(), "setStateValue.s", "i", "Si[]", csnd::thread::i);
-    csnd::plugin<SetStateFloatArrayData>((csnd::Csound*) csound->GetCsound(), "setStateValue.s", "k", "Sk[]", csnd::thread::ik);
+    //cabbageSet pushes widget updates straight into a queue that belongs to this instance
+    prepared.widgetMessages.reset (new CabbageWidgetMessageQueue());
+    newCsound->CreateGlobalVariable("cabbageWidgetMessages", sizeof(CabbageWidgetMessageQueue*));
+    *(CabbageWidgetMessageQueue**) newCsound->QueryGlobalVariable("cabbageWidgetMessages") = prepared.widgetMessages.get();
 
-    csnd::plugin<SetStateStringData>((csnd::Csound*) csound->GetCsound(), "setStateValue.s", "i", "SS", csnd::thread::i);
-    csnd::plugin<SetStateStringData>((csnd::Csound*) csound->GetCsound(), "setStateValue.s", "k", "SS", csnd::thread::ik);
 
-    csnd::plugin<SetStateStringArrayData>((csnd::Csound*) csound->GetCsound(), "setStateValue.s", "i", "SS[]", csnd::thread::i);
-    csnd::plugin<SetStateStringArrayData>((csnd::Csound*) csound->GetCsound(), "setStateValue.s", "k", "SS[]", csnd::thread::ik);
 
+    
 
-
-    
-
-    //csound->CreateGlobalVariable("cabbageData", sizeof(CabbagePersistentData*));
-    //CabbagePersistentData** pd = (CabbagePersistentData**)csound->QueryGlobalVariable("cabbageData");
-    //*pd = new CabbagePersistentData();
-    //auto pdClass = *pd;
-    //pdClass->data = "{}";
+    //newCsound->CreateGlobalVariable("cabbageData", sizeof(CabbagePersistentData*));
+    //CabbagePersistentData** pd = (CabbagePersistentData**)newCsound->QueryGlobalVariable("cabbageData");
+    //*pd = new CabbagePersistentData();
+    //auto pdClass = *pd;
+    //pdClass->data = "{}";
     
-	csound->CreateMessageBuffer(0);
-	csound->SetExternalMidiInOpenCallback(OpenMidiInputDevice);
-	csound->SetExternalMidiReadCallback(ReadMidiData);
-	csound->SetExternalMidiOutOpenCallback(OpenMidiOutputDevice);
-	csound->SetExternalMidiWriteCallback(WriteMidiData);
-	csoundParams = nullptr;
-	csoundParams.reset (new CSOUND_PARAMS());
+	newCsound->CreateMessageBuffer(0);
+	newCsound->SetExternalMidiInOpenCallback(OpenMidiInputDevice);
+	newCsound->SetExternalMidiReadCallback(ReadMidiData);
+	newCsound->SetExternalMidiOutOpenCallback(OpenMidiOutputDevice);
+	newCsound->SetExternalMidiWriteCallback(WriteMidiData);
+	prepared.params.reset (new CSOUND_PARAMS());
+	CSOUND_PARAMS* const csoundParams = prepared.params.get();
 
 	csoundParams->displays = 0;
 
-	csound->SetIsGraphable(true);
-	csound->SetMakeGraphCallback(makeGraphCallback);
-	csound->SetDrawGraphCallback(drawGraphCallback);
-	csound->SetKillGraphCallback(killGraphCallback);
-	csound->SetExitGraphCallback(exitGraphCallback);
-	csound->SetOption((char*)"-n");
-	csound->SetOption((char*)"-d");
-	csound->SetOption((char*)"-b0");
+	newCsound->SetIsGraphable(true);
+	newCsound->SetMakeGraphCallback(makeGraphCallback);
+	newCsound->SetDrawGraphCallback(drawGraphCallback);
+	newCsound->SetKillGraphCallback(killGraphCallback);
+	newCsound->SetExitGraphCallback(exitGraphCallback);
+	newCsound->SetOption((char*)"-n");
+	newCsound->SetOption((char*)"-d");
+	newCsound->SetOption((char*)"-b0");
     
-    addMacros(csdFile.loadFileAsString());
+    addMacros(document, newCsound);
 
 	if (debugMode)
 	{
-		csoundDebuggerInit(csound->GetCsound());
-		csoundSetBreakpointCallback(csound->GetCsound(), breakpointCallback, (void*)this);
-		csoundSetInstrumentBreakpoint(csound->GetCsound(), 1, 413);
+		csoundDebuggerInit(newCsound->GetCsound());
+		csoundSetBreakpointCallback(newCsound->GetCsound(), breakpointCallback, (void*)this);
+		csoundSetInstrumentBreakpoint(newCsound->GetCsound(), 1, 413);
 		csoundParams->ksmps_override = 4410;
 	}
 
 	
-    if(isMono)
-    {
-        //this mode is for logic and cubase
-        numCsoundOutputChannels = 1;
-        numCsoundInputChannels = 1 + (numSideChainChannels > 0 ? 1 : 0);
-        csoundParams->nchnls_override = numCsoundOutputChannels;
-        csoundParams->nchnls_i_override = numCsoundInputChannels;
-        if (supportsSidechain)
-        {
-            getBus(true, 1)->setNumberOfChannels(1);
-            numSideChainChannels = 1;
-        }
-    }
-    else
-    {
-        csoundParams->nchnls_override = numCsoundOutputChannels;
-        csoundParams->nchnls_i_override = numCsoundInputChannels;
-    }
+    //in mono mode describeHost() has already cut the channel counts down, and the sidechain
+    //bus is changed on the message thread once this instance is used
+    csoundParams->nchnls_override = prepared.numOutputChannels;
+    csoundParams->nchnls_i_override = prepared.numInputChannels;
     
     // Update the matchingNumberOfIOChannels flag so the MacOS auval tool doesn't crash when validating
     // different I/O channel configurations.
     if (csoundParams->nchnls_i_override != csoundParams->nchnls_override)
     {
-        matchingNumberOfIOChannels = false;
+        prepared.matchingNumberOfIOChannels = false;
     }
 	
-#ifdef CabbagePro
-	const int requestedSampleRate = CabbageUtilities::getHeaderInfo(Encrypt::decode(csdFile), "sr");
-	const int requestedKsmpsRate = CabbageUtilities::getHeaderInfo(Encrypt::decode(csdFile), "ksmps");
-#else
-	const int requestedKsmpsRate = CabbageUtilities::getHeaderInfo(csdFile.loadFileAsString(), "ksmps");
-	const int requestedSampleRate = CabbageUtilities::getHeaderInfo(csdFile.loadFileAsString(), "sr");
-#endif
+	const int requestedKsmpsRate = document.getHeaderValue("ksmps");
+	const int requestedSampleRate = document.getHeaderValue("sr");
 	
 	if (requestedKsmpsRate == -1)
 		csoundParams->ksmps_override = 32;
 
-	csoundParams->sample_rate_override = requestedSampleRate>0 ? requestedSampleRate : sr;
+	csoundParams->sample_rate_override = (requestedSampleRate>0 ? requestedSampleRate : sr) * prepared.oversampling;
 
-    if(preferredLatency == -1)
-        csoundParams->ksmps_override = 1;
+    //zero latency: run at the orchestra's own ksmps when it divides the host block,
+    //otherwise drop to the largest power of two that does
+    prepared.nativeKsmps = requestedKsmpsRate > 0 ? requestedKsmpsRate : 32;
+    if(prepared.preferredLatency == -1)
+        csoundParams->ksmps_override = getZeroLatencyKsmps(prepared.nativeKsmps, prepared.hostBlockSize * prepared.oversampling);
 
-	csound->SetParams(csoundParams.get());
+    //offline bounces can trade control resolution for speed with the form's offlineksmps()
+    if (prepared.offlineKsmps > 0 && prepared.nonRealtime)
+        csoundParams->ksmps_override = prepared.preferredLatency == -1 ? getZeroLatencyKsmps(prepared.offlineKsmps, prepared.hostBlockSize * prepared.oversampling)
+                                                                       : prepared.offlineKsmps;
+
+	newCsound->SetParams(csoundParams);
     
-    if (csdFile.loadFileAsString().contains("<Csound") || csdFile.loadFileAsString().contains("</Csound"))
+    if (document.hasCsoundTags())
     {
-        compileCsdFile(csdFile);
+        prepared.compileResult = newCsound->Compile (const_cast<char*> (currentCsdFile.getFullPathName().toUTF8().getAddress()));
     }
     else
 	{
 #ifdef CabbagePro
-		compileCsdString(Encrypt::decode(csdFile));
-		csound->Start();
+		prepared.compileResult = newCsound->CompileCsdText (const_cast<char*> (document.getText().toUTF8().getAddress()));
+		newCsound->Start();
 #endif
 }
 
-
-	if (csdCompiledWithoutError())
-	{
-		csdKsmps = csound->GetKsmps();
-		CSspout = csound->GetSpout();
-		CSspin = csound->GetSpin();
-		cs_scale = csound->Get0dBFS();
-		csndIndex = csound->GetKsmps();
-        const String version = String("Cabbage version:")+ProjectInfo::versionString+String("\n");
-        csound->Message(version.toRawUTF8());
-
+    if (prepared.compileResult == 0)
+    {
+        prepared.ksmps = newCsound->GetKsmps();
+        prepared.spout = newCsound->GetSpout();
+        prepared.spin = newCsound->GetSpin();
+        prepared.scale = newCsound->Get0dBFS();
+        prepared.kr = newCsound->GetKr();
     }
-	else
-		CabbageUtilities::debug("Csound could not compile your file?");
-
-    return csdCompiledWithoutError();
-
 }
 
-
-void CsoundPluginProcessor::createFileLogger (File csoundFile)
-{
-    String logFileName = csoundFile.getParentDirectory().getFullPathName() + String ("/") + csoundFile.getFileNameWithoutExtension() + String ("_Log.txt");
-    fileLogger.reset (new FileLogger (File (logFileName), String ("Cabbage Log..")));
-    Logger::setCurrentLogger (fileLogger.get());
-}
 //==============================================================================
-void CsoundPluginProcessor::initAllCsoundChannels (ValueTree cabbageData)
+bool CsoundPluginProcessor::recompileCsoundInBackground (File currentCsdFile, File filePath, ValueTree cabbageData)
 {
-    Logger::writeToLog("initAllCsoundChannels (ValueTree cabbageData) ...");
-    if (!csound)
-    {
-        Logger::writeToLog("csound not initialized");
-        return;
-    }
-    else
-    {
-        Logger::writeToLog(String::formatted("csound = 0x%p", csound.get()));
-        Logger::writeToLog(String::formatted("handle = 0x%p", csound->GetCsound()));
-    }
-    
-    if (!csdCompiledWithoutError())
-    {
-        Logger::writeToLog("csound not compiled");
-        return;
-    }
-    
-    getCsound()->CreateGlobalVariable("cabbageData", sizeof(CabbagePersistentData*));
-    CabbagePersistentData** pd = (CabbagePersistentData**)getCsound()->QueryGlobalVariable("cabbageData");
-    *pd = new CabbagePersistentData();
-    auto pdClass = *pd;
-    pdClass->data = getInternalState().toStdString();
+    //one reload at a time, a newer change is picked up by the next file check
+    if (swapState.load() != swapIdle)
+        return false;
 
+    csdFile = currentCsdFile;
+    csdFilePath = filePath;
+    swapState = swapCompiling;
 
-    for (int i = 0; i < cabbageData.getNumChildren(); i++)
+    const int sr = samplingRate;
+    const bool isMono = hostRequestedMono;
+    const int generation = compileGeneration.load();
+    const CsdDocument::Ptr document = CsdDocument::load (currentCsdFile);
+    //the job owns preparedCsound until it leaves swapCompiling
+    preparedCsound = describeHost (isMono);
+
+    recompilePool.addJob ([this, document, cabbageData, sr, isMono, generation]()
     {
-        const String typeOfWidget = CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::type);
-        if(typeOfWidget == CabbageWidgetTypes::form)
+        createCsoundInstance (preparedCsound, *document, sr, isMono, false);
+
+        if (generation != compileGeneration.load())
+        {
+            //prepareToPlay() or an in place compile has moved on since this was started
+            preparedCsound = PreparedCsound();
+            swapState = swapIdle;
+        }
+        else if (preparedCsound.compileResult == 0 && preparedCsound.oversampling != oversamplingFactor)
+        {
+            //the oversampling filters are set up in prepareToPlay, so this needs a reload
+            preparedCsound.csound->Message ("Cabbage: oversample() changes take effect when the plugin is reloaded\n");
+            preparedCsound = PreparedCsound();
+            swapState = swapIdle;
+        }
+        else if (preparedCsound.compileResult == 0)
+        {
+            //graph and MIDI callbacks ignore this instance until it is swapped in
+            initCsoundChannels (cabbageData, preparedCsound.csound.get(), preparedCsound.stateData);
+            swapState = swapCompiled;
+        }
+        else
         {
-            const int latency = CabbageWidgetData::getNumProp (cabbageData.getChild (i), CabbageIdentifierIds::latency);
-            preferredLatency = latency;
+            //keep running the old instance rather than going silent
+            CabbageUtilities::debug ("Csound could not compile your file?");
+            preparedCsound = PreparedCsound();
+            swapState = swapIdle;
         }
+    });
 
-        if (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::channeltype) == "string")
-        {
-            if (typeOfWidget == CabbageWidgetTypes::json)
-            {
-                
-            }
-            if (typeOfWidget == CabbageWidgetTypes::filebutton)
-            {
-                const String mode = CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::mode);
-                if( mode == "file" || mode == "save" || mode == "directory")
-                {
-                    csound->SetStringChannel (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::channel).getCharPointer(),
-                                          CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::file).toUTF8().getAddress());
-                }
-            }
+    return true;
+}
 
-            else
-            {
-				if (typeOfWidget == CabbageWidgetTypes::combobox)
-				{
-					//if we are dealing with a combobox that reads files from a directory, we need to load them before the GUI opens...
-					if (CabbageWidgetData::getStringProp(cabbageData.getChild(i), "filetype") != "preset"
-						&& CabbageWidgetData::getStringProp(cabbageData.getChild(i), "filetype") != "*.snaps"
-						&& CabbageWidgetData::getStringProp(cabbageData.getChild(i), "filetype") != ".snaps"
-						&& CabbageWidgetData::getStringProp(cabbageData.getChild(i), "filetype") != "snaps")
-					{
-						const String workingDir = CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::workingdir);
-						const String fileType = CabbageWidgetData::getStringProp(cabbageData.getChild(i), "filetype");
-						int numOfFiles;
-						Array<File> folderFiles;
-						StringArray comboItems;
-						CabbageUtilities::searchDirectoryForFiles(cabbageData.getChild(i), workingDir, fileType, folderFiles, comboItems, numOfFiles);
-						const String currentValue = CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::value);
+//audio thread. The message thread takes ownership of the new instance in finishCsoundSwap()
+void CsoundPluginProcessor::swapInPreparedCsound()
+{
+    for (auto* channel : preparedCsound.preparedChannels)
+        channel->commit();
+
+    performingCsound = preparedCsound.csound.get();
+    applyPreparedSettings (preparedCsound);
+    csCompileResult = 0;
+    csdKsmps = preparedCsound.ksmps;
+    CSspout = preparedCsound.spout;
+    CSspin = preparedCsound.spin;
+    cs_scale = preparedCsound.scale;
+    csndIndex = preparedCsound.ksmps;
+    controlRate = preparedCsound.kr;
+    compiledForNonRealtime = preparedCsound.nonRealtime;
+    numCutKCycles = 0;
+    sleeping = false;
+    silentSamples = 0;
+    swapState = swapDone;
+}
 
-						const int index = comboItems.indexOf(currentValue) + 1;
-						const String test = folderFiles[index].getFullPathName();
-						const String channel = CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::channel);
+void CsoundPluginProcessor::setSleeping (bool shouldSleep)
+{
+    sleeping = shouldSleep;
+    silentSamples = 0;
 
-						csound->SetStringChannel(CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::channel).getCharPointer(),
-							folderFiles[index].getFullPathName().replaceCharacters("\\", "/").toUTF8().getAddress());
-						
-					}
-                    else{
-//                        const String test = CabbageWidgetData::getProperty(cabbageData.getChild(i), CabbageIdentifierIds::value);
-//                        const String channel = CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::channel);
-                        csound->SetStringChannel(CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::channel).getCharPointer(),
-                                                 CabbageWidgetData::getProperty(cabbageData.getChild(i), CabbageIdentifierIds::value).toString().toUTF8().getAddress());
-                    }
-				}
-                else if (typeOfWidget == CabbageWidgetTypes::texteditor)
-                {
-                    csound->SetStringChannel(CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::channel).getCharPointer(),
-                                             CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::text).toUTF8().getAddress());
-                }
-            }
+    if (shouldSleep)
+        ++sleepCount;
 
+    if (sleepChannel != nullptr)
+        sleepChannel->set (shouldSleep ? 1 : 0);
 
-        }
-        else
-        {
-            if (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::type) == CabbageWidgetTypes::xypad)
-            {
-                csound->SetChannel (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::xchannel).getCharPointer(),
-                                    CabbageWidgetData::getNumProp (cabbageData.getChild (i), CabbageIdentifierIds::valuex));
-                csound->SetChannel (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::ychannel).getCharPointer(),
-                                    CabbageWidgetData::getNumProp (cabbageData.getChild (i), CabbageIdentifierIds::valuey));
-            }
-            else if (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::type) == CabbageWidgetTypes::hrange
-                     ||CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::type) == CabbageWidgetTypes::vrange)
-            {
-                var channels = CabbageWidgetData::getProperty(cabbageData.getChild(i), CabbageIdentifierIds::channel);
-                if(channels.size()==2)
-                {
-                    const var minValue = CabbageWidgetData::getProperty (cabbageData.getChild (i), CabbageIdentifierIds::minvalue);
-                    csound->SetChannel (channels[0].toString().getCharPointer(), float (minValue));
+    //let the editor pick up the new state, Csound won't be triggering updates while asleep
+    triggerAsyncUpdate();
+}
 
-                    const var maxValue = CabbageWidgetData::getProperty (cabbageData.getChild (i), CabbageIdentifierIds::maxvalue);
-                    csound->SetChannel (channels[0].toString().getCharPointer(), float (maxValue));
-                }
+//held keys keep an instance awake, score driven instruments are left to the output silence check
+void CsoundPluginProcessor::trackHeldMidiNotes (const MidiBuffer& midiMessages)
+{
+    MidiBuffer::Iterator iterator (midiMessages);
+    MidiMessage message;
+    int samplePosition;
+
+    while (iterator.getNextEvent (message, samplePosition))
+    {
+        const int channel = message.getChannel() - 1;
+        if (channel < 0)
+            continue;
 
+        if (message.isNoteOn())
+        {
+            uint8& count = heldMidiNotes[channel][message.getNoteNumber()];
+            if (count < 255)
+            {
+                ++count;
+                ++numHeldMidiNotes;
             }
-            else if (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::type) == CabbageWidgetTypes::cvoutput
-                     ||CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::type) == CabbageWidgetTypes::cvinput)
+        }
+        else if (message.isNoteOff())
+        {
+            uint8& count = heldMidiNotes[channel][message.getNoteNumber()];
+            if (count > 0)
             {
-                //don't set up any channels for these widgets, even though they use the channel() identifier..
+                --count;
+                --numHeldMidiNotes;
             }
-            else
+        }
+        else if (message.isSustainPedalOn() || message.isSustainPedalOff())
+        {
+            sustainPedalDown[channel] = message.isSustainPedalOn();
+        }
+        else if (message.isAllNotesOff() || message.isAllSoundOff())
+        {
+            for (auto& count : heldMidiNotes[channel])
             {
-                const var value = CabbageWidgetData::getProperty (cabbageData.getChild (i), CabbageIdentifierIds::value);
-                csound->SetChannel (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::channel).getCharPointer(),
-                                    float (value));
+                numHeldMidiNotes -= count;
+                count = 0;
             }
-
         }
-
     }
+}
 
+bool CsoundPluginProcessor::hasHeldMidiNotes() const
+{
+    if (numHeldMidiNotes > 0)
+        return true;
 
+    for (auto pedalDown : sustainPedalDown)
+        if (pedalDown)
+            return true;
 
-    if (CabbageUtilities::getTargetPlatform() == CabbageUtilities::TargetPlatformTypes::Win32)
-    {
-        csound->SetChannel ("CSD_PATH", csdFilePath.getParentDirectory().getFullPathName().replace ("\\", "\\\\").toUTF8().getAddress());
-    }
-    else
-    {
-        csound->SetChannel ("CSD_PATH", csdFilePath.getFullPathName().toUTF8().getAddress());
-    }
-
-    csound->SetStringChannel ("LAST_FILE_DROPPED", const_cast<char*> (""));
+    return false;
+}
 
-    csound->SetChannel ("IS_EDITOR_OPEN", 0.0);
-    csdFilePath.setAsCurrentWorkingDirectory();
+void CsoundPluginProcessor::finishCsoundSwap()
+{
+    if (swapState.load() == swapCompiled)
+    {
+        //bus changes and channel lookups belong to this thread. The audio thread commits
+        //the prepared channels in the same block that it switches instances
+        if (preparedCsound.monoSideChain)
+            getBus (true, 1)->setNumberOfChannels (1);
 
+        registerHostChannels();
+        CSOUND* const cs = preparedCsound.csound->GetCsound();
+        preparedCsound.preparedChannels.clearQuick();
+        preparedCsound.preparedChannels.ensureStorageAllocated (channelPointers.size());
 
-    time_t seconds_past_epoch = time(0);
-    csound->SetChannel("SECONDS_SINCE_EPOCH", (intmax_t)seconds_past_epoch);
-    // convert now to string form
-    char* dt = ctime(&seconds_past_epoch);
-    std::stringstream strStream;
-    strStream << dt << endl;
-    csound->SetStringChannel("CURRENT_DATE_TIME", String(strStream.str()).toUTF8().getAddress());
+        for (auto* channel : channelPointers)
+        {
+            channel->prepare (cs);
+            preparedCsound.preparedChannels.add (channel);
+        }
 
+        //named instruments can have different numbers in the new instance
+        resolveMatrixEventSequencerInstruments (cs, csound != nullptr ? csound->GetCsound() : nullptr);
 
-	if((SystemStats::getOperatingSystemType() & SystemStats::OperatingSystemType::Linux) != 0)
-    {
-		csound->SetChannel ("LINUX", 1.0);
-        csound->SetChannel ("Linux", 1.0);
+        swapState = swapReady;
     }
-	if((SystemStats::getOperatingSystemType() & SystemStats::OperatingSystemType::MacOSX) != 0)
+    else if (swapState.load() == swapDone)
     {
-		csound->SetChannel ("MAC", 1.0);
-        csound->SetChannel ("Macos", 1.0);
-        csound->SetChannel ("MACOS", 1.0);
+        //the audio thread is running the new instance now, so this thread can switch over too.
+        //It may still be writing through the old pointers for the rest of this block, so the
+        //outgoing instance is only deleted on the next update
+        std::swap (csound, preparedCsound.csound);
+        std::swap (csoundParams, preparedCsound.params);
+        std::swap (widgetMessages, preparedCsound.widgetMessages);
+        csoundInstanceChanged();
+        CSOUND* const cs = csound->GetCsound();
+        releaseSignalDisplays (cs);
+
+        //channels registered after the others were prepared
+        for (auto* channel : channelPointers)
+            if (!channel->isResolvedFor (cs))
+                channel->resolve (cs);
+
+        signalAnalyser.resolve (cs);
+        //picks up cells set since the instance was prepared
+        resolveMatrixEventSequencerInstruments (cs, cs);
+        cutKCyclesReported = false;
+        startGuiRefresh();
+        reportLatency();
+        swapState = swapRetiring;
     }
-	if((SystemStats::getOperatingSystemType() & SystemStats::OperatingSystemType::Windows) != 0)
+    else if (swapState.load() == swapRetiring)
     {
-		csound->SetChannel ("Windows", 1.0);
-        csound->SetChannel ("WINDOWS", 1.0);
+        preparedCsound = PreparedCsound();
+        swapState = swapIdle;
     }
+}
 
-    //csound->SetChannel ("CHNSET_GESTURES", 0.0);
-    
-#if !defined(Cabbage_IDE_Build)
-    PluginHostType pluginType;
-    if (pluginType.isFruityLoops())
-        csound->SetChannel ("FLStudio", 1.0);
-    else if (pluginType.isAbletonLive())
-        csound->SetChannel ("AbletonLive", 1.0);
-    else if (pluginType.isLogic()){
-        csound->SetChannel ("Logic", 1.0);
-        isLogic = true;
-    }
-    else if (pluginType.isArdour())
-        csound->SetChannel ("Ardour", 1.0);
-    else if (pluginType.isCubase())
-        csound->SetChannel ("Cubase", 1.0);
-    else if (pluginType.isSonar())
-        csound->SetChannel ("Sonar", 1.0);
-    else if (pluginType.isNuendo())
-        csound->SetChannel ("Nuendo", 1.0);
-    else if (pluginType.isReaper())
-        csound->SetChannel ("Reaper", 1.0);
-    else if (pluginType.isRenoise())
-        csound->SetChannel ("Renoise", 1.0);
-    else if (pluginType.isWavelab())
-        csound->SetChannel ("Wavelab", 1.0);
-    else if (pluginType.isMainStage())
-        csound->SetChannel ("Mainstage", 1.0);
-    else if (pluginType.isGarageBand())
-        csound->SetChannel ("Garageband", 1.0);
-    else if (pluginType.isSamplitude())
-        csound->SetChannel ("Samplitude", 1.0);
-    else if (pluginType.isStudioOne())
-        csound->SetChannel ("StudioOne", 1.0);
-    else if (pluginType.isBitwigStudio())
-        csound->SetChannel ("Bitwig", 1.0);
-    else if (pluginType.isTracktion())
-        csound->SetChannel ("Tracktion", 1.0);
-    else if (pluginType.isAdobeAudition())
-        csound->SetChannel ("AdobeAudition", 1.0);
-#endif
-             
-    if (CabbageUtilities::getTarget() != CabbageUtilities::TargetTypes::IDE) {
-        csound->SetChannel("IS_A_PLUGIN", 1.0);
-    }
+bool CsoundPluginProcessor::cancelBackgroundRecompile()
+{
+    //a compile that is already running can't be interrupted, wait for it to see the new generation
+    const bool wasCompiling = swapState.load() == swapCompiling;
+    ++compileGeneration;
+    recompilePool.removeAllJobs (true, 10000);
 
-    if (getPlayHead() != 0 && getPlayHead()->getCurrentPosition (hostInfo))
+    for (;;)
     {
-        csound->SetChannel (CabbageIdentifierIds::hostbpm.toUTF8(), hostInfo.bpm);
-        csound->SetChannel (CabbageIdentifierIds::timeinseconds.toUTF8(), hostInfo.timeInSeconds);
-        csound->SetChannel (CabbageIdentifierIds::isplaying.toUTF8(), hostInfo.isPlaying);
-        csound->SetChannel (CabbageIdentifierIds::isrecording.toUTF8(), hostInfo.isRecording);
-        csound->SetChannel (CabbageIdentifierIds::hostppqpos.toUTF8(), hostInfo.ppqPosition);
-        csound->SetChannel (CabbageIdentifierIds::timeinsamples.toUTF8(), hostInfo.timeInSamples);
-        csound->SetChannel (CabbageIdentifierIds::timeSigDenom.toUTF8(), hostInfo.timeSigDenominator);
-        csound->SetChannel (CabbageIdentifierIds::timeSigNum.toUTF8(), hostInfo.timeSigNumerator);
-    }
-
+        int state = swapState.load();
 
-    csound->PerformKsmps();
+        if (state == swapIdle)
+            return wasCompiling;
 
-    Logger::writeToLog("initAllCsoundChannels (ValueTree cabbageData) - done");
+        if (state == swapCompiling && recompilePool.getNumJobs() == 0)
+        {
+            //the job was removed before it started, so nothing else will move the state on
+            preparedCsound = PreparedCsound();
+            swapState = swapIdle;
+            return true;
+        }
 
+        if (state == swapCompiled || state == swapReady)
+        {
+            //the audio thread claims a ready instance the same way, only one of us gets it
+            if (swapState.compare_exchange_strong (state, swapIdle))
+            {
+                preparedCsound = PreparedCsound();
+                return true;
+            }
+        }
+        else if (state == swapSwapping || state == swapCompiling)
+        {
+            Thread::yield();
+        }
+        else
+        {
+            //already swapped in, just finish the handover
+            finishCsoundSwap();
+        }
+    }
 }
+
+//==============================================================================
+// Reload benchmark. A thread stands in for the host's audio callback, running blocks
+// at roughly real-time pace and timing each one, while the calling thread plays the
+// message thread and reloads the file. An in place compile stops the audio for as long
+// as it takes, a background reload should leave the blocks close to their idle cost.
 //==============================================================================
-void CsoundPluginProcessor::addMacros (String csdText)
+namespace
 {
-    StringArray csdArray;
-    String macroName, macroText;
-
-    csdArray.addLines (csdText);
-//
-//    String width = "--macro:SCREEN_WIDTH="+String(screenWidth);
-//    String height = "--macro:SCREEN_HEIGHT="+String(screenHeight);
-//    csound->SetOption (width.toUTF8().getAddress());
-//    csound->SetOption (height.toUTF8().getAddress());
-    
-    auto inCabbageSection = false;
-
-    for (int i = 0; i < csdArray.size(); i++)
+    struct ReloadBenchmarkAudioThread : public Thread
     {
-        if (!inCabbageSection && csdArray[i].contains ("<Cabbage"))
-            inCabbageSection = true;
+        ReloadBenchmarkAudioThread (AudioProcessor& processorToUse, int blockSize, double blockDurationMs)
+            : Thread ("Cabbage reload benchmark"), processor (processorToUse), buffer (2, blockSize), blockMs (blockDurationMs)
+        {
+        }
 
-        if (inCabbageSection)
+        void run() override
         {
-            if (csdArray[i].trim().substring (0, 7) == "#define")
+            MidiBuffer midi;
+
+            while (!threadShouldExit())
             {
-			    StringArray tokens;
-//              CabbageUtilities::debug(csdArray[i]);
-                tokens.addTokens (csdArray[i].replace ("#", "").trim() , " ");
-//              CabbageUtilities::debug(tokens[0]);
-                macroName = tokens[1];
-                tokens.remove (0);
-                tokens.remove (0);
-                macroText = "\"" + tokens.joinIntoString (" ").replace (" ", "\ ").replace("\"", "\\\"")+"\"";
-                macroText = tokens.joinIntoString(" ");
-                String fullMacro = "--omacro:" + macroName + "=" + macroText;// + "\"";
-                csound->SetOption (fullMacro.toUTF8().getAddress());
+                buffer.clear();
+                const double start = Time::getMillisecondCounterHiRes();
+                processor.processBlock (buffer, midi);
+                const double elapsed = Time::getMillisecondCounterHiRes() - start;
+
+                worstBlockMs = jmax (worstBlockMs, elapsed);
+                totalBlockMs += elapsed;
+                numBlocks++;
+                wait (jmax (1, int (blockMs - elapsed)));
             }
         }
 
-        if (csdArray[i].contains ("</Cabbage>"))
-            i = csdArray.size();
-    }
+        //only while the thread is stopped
+        void resetStatistics()      { worstBlockMs = totalBlockMs = 0; numBlocks = 0; }
+        String describe() const
+        {
+            return "mean " + String (totalBlockMs / jmax (1, numBlocks), 3) + " ms, worst " + String (worstBlockMs, 3)
+                   + " ms over " + String (numBlocks) + " blocks";
+        }
 
+        AudioProcessor& processor;
+        AudioBuffer<float> buffer;
+        const double blockMs;
+        double worstBlockMs = 0, totalBlockMs = 0;
+        int numBlocks = 0;
+    };
 }
 
-//==============================================================================
-void CsoundPluginProcessor::createMatrixEventSequencer(int rows, int cols, String channel)
+StringArray CsoundPluginProcessor::benchmarkReload (File csdFile)
 {
-    MatrixEventSequencer* matrix = new MatrixEventSequencer(channel);
+    StringArray results;
 
-    for (int i = 0 ; i < cols ; i++)
+    if (!csdFile.existsAsFile())
     {
-        matrix->events.add (new StringArray());
+        results.add ("No csd file at " + csdFile.getFullPathName());
+        return results;
+    }
 
-        for ( int y = 0 ; y < rows ; y++)
-        {
-            matrix->events[i]->add(" ");
-        }
+    const int sampleRate = 44100, blockSize = 512, reloads = 10;
+    const double blockMs = 1000.0 * blockSize / sampleRate;
+
+    CsoundPluginProcessor processor (csdFile, AudioChannelSet::stereo(), AudioChannelSet::stereo());
+    //this thread plays the message thread, so swaps are finished by hand
+    processor.guiRefreshScheduler.stop();
+
+    double totalCompileMs = 0, worstCompileMs = 0;
+
+    for (int i = 0; i < reloads; i++)
+    {
+        const double start = Time::getMillisecondCounterHiRes();
+        processor.setupAndCompileCsound (csdFile, csdFile.getParentDirectory(), sampleRate);
+        const double elapsed = Time::getMillisecondCounterHiRes() - start;
+        totalCompileMs += elapsed;
+        worstCompileMs = jmax (worstCompileMs, elapsed);
     }
 
-    matrixEventSequencers.add(matrix);
-	numMatrixEventSequencers = matrixEventSequencers.size();
+    if (!processor.csdCompiledWithoutError())
+    {
+        results.add (csdFile.getFileName() + " doesn't compile");
+        return results;
+    }
 
+    processor.prepareToPlay (sampleRate, blockSize);
 
-}
+    ReloadBenchmarkAudioThread audioThread (processor, blockSize, blockMs);
+    audioThread.startThread (Thread::realtimeAudioPriority);
+    Thread::sleep (1000);
+    audioThread.stopThread (1000);
+    const String idleBlocks = audioThread.describe();
 
-void CsoundPluginProcessor::setMatrixEventSequencerCellData(int col, int row, String channel, String data)
-{
-	if (numMatrixEventSequencers > 0)
-	{
-		for (int i = 0; i < matrixEventSequencers.size(); i++)
-		{
-			if (matrixEventSequencers[i]->channel == channel)
-			{
-				matrixEventSequencers[i]->setEventString(col, row, data);
-			}
-		}
-	}
-}
+    audioThread.resetStatistics();
+    audioThread.startThread (Thread::realtimeAudioPriority);
 
-//==============================================================================
-StringArray CsoundPluginProcessor::getTableStatement (int tableNum)
-{
-    StringArray fdata;
-    fdata.add (String());
+    double totalReloadMs = 0;
+    int completedReloads = 0;
 
-    if (csCompileResult == OK)
+    for (int i = 0; i < reloads; i++)
     {
-        MYFLT* argsPtr, *temp;
-        int noOfArgs = csoundGetTableArgs (csound->GetCsound(), &argsPtr, tableNum);
+        const double start = Time::getMillisecondCounterHiRes();
 
-        if (noOfArgs != -1)
-        {
-            int tableSize = csound->GetTable (temp, tableNum);
-            fdata.add (String (tableNum));
-            fdata.add ("0");
-            fdata.add (String (tableSize));
+        if (!processor.recompileCsoundInBackground (csdFile, csdFile.getParentDirectory(), ValueTree()))
+            break;
 
-            if (noOfArgs == 0)
-                fdata.add (String (1));
-            else
-                for (int i = 0; i < noOfArgs; i++)
-                {
-                    fdata.add (String (argsPtr[i]));
-                }
+        while (processor.swapState.load() != swapIdle && Time::getMillisecondCounterHiRes() - start < 20000)
+        {
+            processor.finishCsoundSwap();
+            Thread::sleep (5);
         }
+
+        totalReloadMs += Time::getMillisecondCounterHiRes() - start;
+        completedReloads++;
     }
 
-    return fdata;
+    audioThread.stopThread (1000);
+
+    results.add (csdFile.getFileName() + ", " + String (blockSize) + " sample blocks at " + String (sampleRate)
+                 + " Hz, " + String (blockMs, 2) + " ms per block");
+    results.add ("In place compile: mean " + String (totalCompileMs / reloads, 2) + " ms, worst " + String (worstCompileMs, 2)
+                 + " ms with no audio");
+    results.add ("Background reload: mean " + String (totalReloadMs / jmax (1, completedReloads), 2) + " ms until swapped in, "
+                 + String (completedReloads) + " reloads");
+    results.add ("Audio blocks, idle: " + idleBlocks);
+    results.add ("Audio blocks, reloading: " + audioThread.describe());
+    return results;
 }
-//==============================================================================
-const Array<float, CriticalSection> CsoundPluginProcessor::getTableFloats (int tableNum)
+
+StringArray CsoundPluginProcessor::checkDoublePrecision (File csdFile)
 {
-    Array<float, CriticalSection> points;
+    StringArray results;
+    TemporaryFile tempCsd (".csd");
 
-    if (csCompileResult == OK)
+    if (!csdFile.existsAsFile())
     {
+        //a filtered, scaled copy of the input. Nothing random, so both instances must agree
+        tempCsd.getFile().replaceWithText ("<CsoundSynthesizer>\n<CsOptions>\n-n -d\n</CsOptions>\n<CsInstruments>\n"
+                                           "ksmps = 32\nnchnls = 2\n0dbfs = 1\n\ninstr 1\n"
+                                           "a1, a2 ins\na1 butlp a1, 2000\na2 butlp a2, 2000\nouts a1 * 0.5, a2 * 0.5\n"
+                                           "endin\n</CsInstruments>\n<CsScore>\ni1 0 z\n</CsScore>\n</CsoundSynthesizer>\n");
+        csdFile = tempCsd.getFile();
+    }
 
-        const int tableSize = csound->TableLength (tableNum);;
-
-        if (tableSize < 0)
-            return points;
+    const int sampleRate = 44100, blockSize = 512, numBlocks = 200;
 
-        std::vector<double> temp (tableSize);
+    CsoundPluginProcessor floatProcessor (csdFile, AudioChannelSet::stereo(), AudioChannelSet::stereo());
+    CsoundPluginProcessor doubleProcessor (csdFile, AudioChannelSet::stereo(), AudioChannelSet::stereo());
+    floatProcessor.guiRefreshScheduler.stop();
+    doubleProcessor.guiRefreshScheduler.stop();
 
-        csound->TableCopyOut (tableNum, &temp[0]);
+    floatProcessor.setupAndCompileCsound (csdFile, csdFile.getParentDirectory(), sampleRate);
+    doubleProcessor.setupAndCompileCsound (csdFile, csdFile.getParentDirectory(), sampleRate);
 
-        if (tableSize > 0)
-            points = Array<float, CriticalSection> (&temp[0], tableSize);
+    if (!floatProcessor.csdCompiledWithoutError() || !doubleProcessor.csdCompiledWithoutError())
+    {
+        results.add (csdFile.getFileName() + " doesn't compile");
+        return results;
     }
 
-    return points;
-}
-
-int CsoundPluginProcessor::checkTable (int tableNum)
-{
-    return  csound->TableLength (tableNum);
-}
+    floatProcessor.prepareToPlay (sampleRate, blockSize);
+    doubleProcessor.prepareToPlay (sampleRate, blockSize);
 
+    AudioBuffer<float> floatBuffer (2, blockSize);
+    AudioBuffer<double> doubleBuffer (2, blockSize);
+    MidiBuffer midi;
+    Random random (1234);
+    double maxDifference = 0, peak = 0;
 
-//==============================================================================
-const String CsoundPluginProcessor::getCsoundOutput()
-{
-    if (csound!=nullptr)
+    for (int block = 0; block < numBlocks; block++)
     {
-        const int messageCnt = csound->GetMessageCnt();
-        csoundOutput = "";
+        //the input is generated as float so both paths start from identical samples
+        for (int channel = 0; channel < 2; channel++)
+        {
+            for (int i = 0; i < blockSize; i++)
+            {
+                const float sample = 0.5f * std::sin (float (2.0 * double_Pi * 440.0 * (block * blockSize + i) / sampleRate))
+                                     + 0.1f * (random.nextFloat() * 2.f - 1.f);
+                floatBuffer.setSample (channel, i, sample);
+                doubleBuffer.setSample (channel, i, sample);
+            }
+        }
 
-        if (messageCnt == 0)
-            return csoundOutput;
+        floatProcessor.processBlock (floatBuffer, midi);
+        midi.clear();
+        doubleProcessor.processBlock (doubleBuffer, midi);
+        midi.clear();
 
-        while (csound->GetMessageCnt() > 0)
+        for (int channel = 0; channel < 2; channel++)
         {
-            csoundOutput += csound->GetFirstMessage();
-            csound->PopFirstMessage();
+            for (int i = 0; i < blockSize; i++)
+            {
+                const double expected = doubleBuffer.getSample (channel, i);
+                maxDifference = jmax (maxDifference, std::abs (double (floatBuffer.getSample (channel, i)) - expected));
+                peak = jmax (peak, std::abs (expected));
+            }
         }
+    }
 
-        Logger::writeToLog (csoundOutput);
+    //float output can't be closer than one float rounding step of the peak level
+    const double tolerance = jmax (1.0e-6, peak * 4.0 * std::numeric_limits<float>::epsilon());
 
-        if (disableLogging == true)
-            this->suspendProcessing (true);
+    results.add (csdFile.getFileName() + ", " + String (numBlocks) + " blocks of " + String (blockSize) + " samples, MYFLT is "
+                 + (sizeof (MYFLT) == sizeof (double) ? "double" : "float"));
+    results.add ("Peak output " + String (peak, 6) + ", max float/double difference " + String (maxDifference, 9));
+    results.add (maxDifference <= tolerance ? "Float and double paths agree" : "Float and double paths differ by more than " + String (tolerance, 9));
+    return results;
+}
 
-        return csoundOutput;
+StringArray CsoundPluginProcessor::checkTableGenerators()
+{
+    //segments that fill the table exactly, stop short of it or run past it, on power of two
+    //and other sizes, normalised and not
+    struct GenCase { int genRoutine, tableSize; const char* arguments; };
+    const GenCase cases[] = {
+        { 7, 1024, "0 512 1 512 0" },
+        { -7, 1024, "0.5 300 -1 200 0.25" },
+        { 7, 1000, "0 600 1 600 0" },
+        { -7, 4096, "0 100 1 1000 -0.5 2996 0" },
+        { 5, 1024, "0.001 512 1 512 0.001" },
+        { -5, 512, "1 256 0.01 128 0.5" },
+        { 5, 1000, "0.01 250 1 250 -1 500 0.5" },
+        { 2, 16, "1 2 3 4 5 6 7 8" },
+        { -2, 8, "0.5 -0.25 1 0 2" },
+        { -2, 4, "1 2 3 4 5 6" }
+    };
+
+    StringArray results;
+    Csound csound;
+    csound.CreateMessageBuffer (0);
+    csound.SetOption ("-n");
+    csound.SetOption ("-d");
+
+    if (csound.CompileOrc ("sr = 44100\nksmps = 32\nnchnls = 2\n0dbfs = 1\n") != 0 || csound.Start() != 0)
+    {
+        results.add ("Csound didn't start");
+        return results;
     }
 
-    return String();
-}
+    for (int i = 0; i < numElementsInArray (cases); i++)
+    {
+        const int tableNumber = 101 + i;
+        csound.InputMessage (("f" + String (tableNumber) + " 0 " + String (cases[i].tableSize) + " "
+                              + String (cases[i].genRoutine) + " " + cases[i].arguments).toRawUTF8());
+    }
 
-//==============================================================================
-const String CsoundPluginProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
+    csound.PerformKsmps();
 
-bool CsoundPluginProcessor::acceptsMidi() const
-{
-#if JucePlugin_WantsMidiInput
-    return true;
-#else
-    return false;
-#endif
-}
+    //GEN05 and GEN07 add up an increment per sample, so allow for that much rounding
+    const double tolerance = sizeof (MYFLT) == sizeof (double) ? 1.0e-9 : 1.0e-4;
+    int numDiffering = 0;
 
-bool CsoundPluginProcessor::producesMidi() const
-{
-#if JucePlugin_ProducesMidiOutput
-    return true;
-#else
-    return false;
-#endif
-}
+    for (int i = 0; i < numElementsInArray (cases); i++)
+    {
+        const GenCase& genCase = cases[i];
+        const String description ("GEN" + String (genCase.genRoutine) + ", " + String (genCase.tableSize) + " points, " + genCase.arguments);
+        MYFLT* csoundTable = nullptr;
 
-double CsoundPluginProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
+        if (csound.GetTable (csoundTable, 101 + i) != genCase.tableSize || csoundTable == nullptr)
+        {
+            results.add (description + ": Csound didn't create the table");
+            numDiffering++;
+            continue;
+        }
 
-int CsoundPluginProcessor::getNumPrograms()
-{
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-    // so this should be at least 1, even if you're not really implementing programs.
-}
+        Array<double> arguments;
 
-int CsoundPluginProcessor::getCurrentProgram()
-{
-    return 0;
-}
+        for (auto& token : StringArray::fromTokens (genCase.arguments, false))
+            arguments.add (token.getDoubleValue());
 
-void CsoundPluginProcessor::setCurrentProgram (int index)
-{
-}
+        HeapBlock<MYFLT> table ((size_t) genCase.tableSize + 1, true);
+        TableEditor::generate (genCase.genRoutine, arguments, table, genCase.tableSize);
 
-const String CsoundPluginProcessor::getProgramName (int index)
-{
-    return String();
+        double maxDifference = 0;
+        int worstIndex = 0;
+
+        //the guard point included
+        for (int n = 0; n <= genCase.tableSize; n++)
+        {
+            const double difference = std::abs (double (table[n]) - double (csoundTable[n]));
+
+            if (difference > maxDifference)
+            {
+                maxDifference = difference;
+                worstIndex = n;
+            }
+        }
+
+        if (maxDifference > tolerance)
+            numDiffering++;
+
+        results.add (description + ": max difference " + String (maxDifference, 9) + " at index " + String (worstIndex)
+                     + " (" + String (double (table[worstIndex]), 9) + " against " + String (double (csoundTable[worstIndex]), 9) + ")");
+    }
+
+    results.add (numDiffering == 0 ? "Table editor and Csound agree"
+                                   : String (numDiffering) + " tables differ from Csound's by more than " + String (tolerance, 9));
+    return results;
 }
 
-void CsoundPluginProcessor::changeProgramName (int index, const String& newName)
+void CsoundPluginProcessor::createFileLogger (File csoundFile)
 {
+    String logFileName = csoundFile.getParentDirectory().getFullPathName() + String ("/") + csoundFile.getFileNameWithoutExtension() + String ("_Log.txt");
+    fileLogger.reset (new FileLogger (File (logFileName), String ("Cabbage Log..")));
+    Logger::setCurrentLogger (fileLogger.get());
 }
-
 //==============================================================================
-void CsoundPluginProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+void CsoundPluginProcessor::initAllCsoundChannels (ValueTree cabbageData)
 {
-#if !defined(Cabbage_IDE_Build)
-    PluginHostType pluginType;
-    if (pluginType.isCubase())
-        hostIsCubase = true;
-#endif
-    
-#if ! JucePlugin_IsSynth
-    const int inputs = getBus(true, 0)->getNumberOfChannels();
-    CabbageUtilities::debug("CsoundPluginProcessor::prepareToPlay - inputs:", inputs);
-    CabbageUtilities::debug("CsoundPluginProcessor::prepareToPlay - Requested input channels:", numCsoundInputChannels);
-#endif
-    const int outputs = getBus(false, 0)->getNumberOfChannels();
-    CabbageUtilities::debug("CsoundPluginProcessor::prepareToPlay - outputs:", outputs);
-    CabbageUtilities::debug("CsoundPluginProcessor::prepareToPlay - Requested output channels:", numCsoundOutputChannels);
-
-    int sideChainChannels = 0;
-    if (supportsSidechain)
+    Logger::writeToLog("initAllCsoundChannels (ValueTree cabbageData) ...");
+    if (!csound)
     {
-        numSideChainChannels = getBus(true, 0)->getNumberOfChannels();
+        Logger::writeToLog("csound not initialized");
+        return;
+    }
+    else
+    {
+        Logger::writeToLog(String::formatted("csound = 0x%p", csound.get()));
+        Logger::writeToLog(String::formatted("handle = 0x%p", csound->GetCsound()));
     }
     
-    
-    if((samplingRate != sampleRate)
-       || hostRequestedMono
-#if ! JucePlugin_IsSynth && ! JucePlugin_IsSynth
-       || numCsoundInputChannels != inputs
-#endif
-       || numCsoundOutputChannels != outputs 
-       || numSideChainChannels != sideChainChannels)
+    if (!csdCompiledWithoutError())
     {
-        //if sampling rate is other than default or has been changed, recompile..
-        samplingRate = sampleRate;
-        //allow mono plugins for Logic only..
-        if(hostRequestedMono == true)
-            setupAndCompileCsound(csdFile, csdFilePath, samplingRate, true);
-        else
-            setupAndCompileCsound(csdFile, csdFilePath, samplingRate);
+        Logger::writeToLog("csound not compiled");
+        return;
     }
+    
+    initCsoundChannels (cabbageData, csound.get(), getInternalState());
 
-    if (preferredLatency == -1)
-        this->setLatencySamples(0);
-    else
-	    this->setLatencySamples(preferredLatency == 0 ? csound->GetKsmps() : preferredLatency);
-}
+    Logger::writeToLog("initAllCsoundChannels (ValueTree cabbageData) - done");
 
-void CsoundPluginProcessor::releaseResources()
-{
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
 }
 
-bool CsoundPluginProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+//writes only to target, so a background reload can call this for an instance that isn't running yet.
+//The form's latency() is picked up when the instance is created
+void CsoundPluginProcessor::initCsoundChannels (ValueTree cabbageData, Csound* target, const String& stateData)
 {
+    target->CreateGlobalVariable("cabbageData", sizeof(CabbagePersistentData*));
+    CabbagePersistentData** pd = (CabbagePersistentData**)target->QueryGlobalVariable("cabbageData");
+    *pd = new CabbagePersistentData();
+    auto pdClass = *pd;
+    pdClass->data = stateData.toStdString();
 
-#if JucePlugin_IsMidiEffectz
-        ignoreUnused (layouts);
-        return true;
-#else
-    
-    const AudioChannelSet& mainInput  = layouts.getMainInputChannelSet();
-    const AudioChannelSet& mainOutput = layouts.getMainOutputChannelSet();
-    
-    CabbageUtilities::debug("MainOutputSize:", mainOutput.size());
-    CabbageUtilities::debug("MainInputSize:", mainInput.size());
-    
-    if(AudioProcessor::wrapperType == wrapperType_AudioUnit)
+
+    for (int i = 0; i < cabbageData.getNumChildren(); i++)
     {
-#if  JucePlugin_IsSynth
-        //synth can only be mono or stereo...
-//        if (mainInput.size() == 0 && mainOutput.size() == 1)
-//            return true;
-//        if (mainInput.size() == 0 && mainOutput.size() == 2)
-//            return true;
-        if (mainInput.size() == 0 && mainOutput.size() == numCsoundOutputChannels)
-            return true;
+        const String typeOfWidget = CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::type);
 
-#else
-#if !defined(Cabbage_IDE_Build) && !defined(Cabbage_Lite)
-        if (PluginHostType().isReaper())
+        if (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::channeltype) == "string")
+        {
+            if (typeOfWidget == CabbageWidgetTypes::json)
+            {
+                
+            }
+            if (typeOfWidget == CabbageWidgetTypes::filebutton)
+            {
+                const String mode = CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::mode);
+                if( mode == "file" || mode == "save" || mode == "directory")
+                {
+                    target->SetStringChannel (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::channel).getCharPointer(),
+                                          CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::file).toUTF8().getAddress());
+                }
+            }
+
+            else
+            {
+				if (typeOfWidget == CabbageWidgetTypes::combobox)
+				{
+					//if we are dealing with a combobox that reads files from a directory, we need to load them before the GUI opens...
+					if (CabbageWidgetData::getStringProp(cabbageData.getChild(i), "filetype") != "preset"
+						&& CabbageWidgetData::getStringProp(cabbageData.getChild(i), "filetype") != "*.snaps"
+						&& CabbageWidgetData::getStringProp(cabbageData.getChild(i), "filetype") != ".snaps"
+						&& CabbageWidgetData::getStringProp(cabbageData.getChild(i), "filetype") != "snaps")
+					{
+						const String workingDir = CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::workingdir);
+						const String fileType = CabbageWidgetData::getStringProp(cabbageData.getChild(i), "filetype");
+						int numOfFiles;
+						Array<File> folderFiles;
+						StringArray comboItems;
+						CabbageUtilities::searchDirectoryForFiles(cabbageData.getChild(i), workingDir, fileType, folderFiles, comboItems, numOfFiles);
+						const String currentValue = CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::value);
+
+						const int index = comboItems.indexOf(currentValue) + 1;
+						const String test = folderFiles[index].getFullPathName();
+						const String channel = CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::channel);
+
+						target->SetStringChannel(CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::channel).getCharPointer(),
+							folderFiles[index].getFullPathName().replaceCharacters("\\", "/").toUTF8().getAddress());
+						
+					}
+                    else{
+//                        const String test = CabbageWidgetData::getProperty(cabbageData.getChild(i), CabbageIdentifierIds::value);
+//                        const String channel = CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::channel);
+                        target->SetStringChannel(CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::channel).getCharPointer(),
+                                                 CabbageWidgetData::getProperty(cabbageData.getChild(i), CabbageIdentifierIds::value).toString().toUTF8().getAddress());
+                    }
+				}
+                else if (typeOfWidget == CabbageWidgetTypes::texteditor)
+                {
+                    target->SetStringChannel(CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::channel).getCharPointer(),
+                                             CabbageWidgetData::getStringProp(cabbageData.getChild(i), CabbageIdentifierIds::text).toUTF8().getAddress());
+                }
+            }
+
+
+        }
+        else
         {
-            if(numSideChainChannels > 0)
+            if (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::type) == CabbageWidgetTypes::xypad)
             {
-                if ((mainInput.size() == numCsoundInputChannels - numSideChainChannels || mainInput.size() == mainOutput.size())
-                    && mainOutput.size() == numCsoundOutputChannels)
+                target->SetChannel (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::xchannel).getCharPointer(),
+                                    CabbageWidgetData::getNumProp (cabbageData.getChild (i), CabbageIdentifierIds::valuex));
+                target->SetChannel (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::ychannel).getCharPointer(),
+                                    CabbageWidgetData::getNumProp (cabbageData.getChild (i), CabbageIdentifierIds::valuey));
+            }
+            else if (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::type) == CabbageWidgetTypes::hrange
+                     ||CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::type) == CabbageWidgetTypes::vrange)
+            {
+                var channels = CabbageWidgetData::getProperty(cabbageData.getChild(i), CabbageIdentifierIds::channel);
+                if(channels.size()==2)
                 {
-                    return true;
+                    const var minValue = CabbageWidgetData::getProperty (cabbageData.getChild (i), CabbageIdentifierIds::minvalue);
+                    target->SetChannel (channels[0].toString().getCharPointer(), float (minValue));
+
+                    const var maxValue = CabbageWidgetData::getProperty (cabbageData.getChild (i), CabbageIdentifierIds::maxvalue);
+                    target->SetChannel (channels[0].toString().getCharPointer(), float (maxValue));
                 }
+
+            }
+            else if (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::type) == CabbageWidgetTypes::cvoutput
+                     ||CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::type) == CabbageWidgetTypes::cvinput)
+            {
+                //don't set up any channels for these widgets, even though they use the channel() identifier..
             }
             else
             {
-                if(mainInput.size() == numCsoundInputChannels && mainOutput.size() == numCsoundOutputChannels)
-                    return true;
+                const var value = CabbageWidgetData::getProperty (cabbageData.getChild (i), CabbageIdentifierIds::value);
+                target->SetChannel (CabbageWidgetData::getStringProp (cabbageData.getChild (i), CabbageIdentifierIds::channel).getCharPointer(),
+                                    float (value));
             }
-            
+
         }
-        else
+
+    }
+
+
+
+    if (CabbageUtilities::getTargetPlatform() == CabbageUtilities::TargetPlatformTypes::Win32)
+    {
+        target->SetChannel ("CSD_PATH", csdFilePath.getParentDirectory().getFullPathName().replace ("\\", "\\\\").toUTF8().getAddress());
+    }
+    else
+    {
+        target->SetChannel ("CSD_PATH", csdFilePath.getFullPathName().toUTF8().getAddress());
+    }
+
+    target->SetStringChannel ("LAST_FILE_DROPPED", const_cast<char*> (""));
+
+    target->SetChannel ("IS_EDITOR_OPEN", 0.0);
+    csdFilePath.setAsCurrentWorkingDirectory();
+
+
+    time_t seconds_past_epoch = time(0);
+    target->SetChannel("SECONDS_SINCE_EPOCH", (intmax_t)seconds_past_epoch);
+    // convert now to string form
+    char* dt = ctime(&seconds_past_epoch);
+    std::stringstream strStream;
+    strStream << dt << endl;
+    target->SetStringChannel("CURRENT_DATE_TIME", String(strStream.str()).toUTF8().getAddress());
+
+
+	if((SystemStats::getOperatingSystemType() & SystemStats::OperatingSystemType::Linux) != 0)
+    {
+		target->SetChannel ("LINUX", 1.0);
+        target->SetChannel ("Linux", 1.0);
+    }
+	if((SystemStats::getOperatingSystemType() & SystemStats::OperatingSystemType::MacOSX) != 0)
+    {
+		target->SetChannel ("MAC", 1.0);
+        target->SetChannel ("Macos", 1.0);
+        target->SetChannel ("MACOS", 1.0);
+    }
+	if((SystemStats::getOperatingSystemType() & SystemStats::OperatingSystemType::Windows) != 0)
+    {
+		target->SetChannel ("Windows", 1.0);
+        target->SetChannel ("WINDOWS", 1.0);
+    }
+
+    //target->SetChannel ("CHNSET_GESTURES", 0.0);
+    
+#if !defined(Cabbage_IDE_Build)
+    PluginHostType pluginType;
+    if (pluginType.isFruityLoops())
+        target->SetChannel ("FLStudio", 1.0);
+    else if (pluginType.isAbletonLive())
+        target->SetChannel ("AbletonLive", 1.0);
+    else if (pluginType.isLogic())
+        target->SetChannel ("Logic", 1.0);
+    else if (pluginType.isArdour())
+        target->SetChannel ("Ardour", 1.0);
+    else if (pluginType.isCubase())
+        target->SetChannel ("Cubase", 1.0);
+    else if (pluginType.isSonar())
+        target->SetChannel ("Sonar", 1.0);
+    else if (pluginType.isNuendo())
+        target->SetChannel ("Nuendo", 1.0);
+    else if (pluginType.isReaper())
+        target->SetChannel ("Reaper", 1.0);
+    else if (pluginType.isRenoise())
+        target->SetChannel ("Renoise", 1.0);
+    else if (pluginType.isWavelab())
+        target->SetChannel ("Wavelab", 1.0);
+    else if (pluginType.isMainStage())
+        target->SetChannel ("Mainstage", 1.0);
+    else if (pluginType.isGarageBand())
+        target->SetChannel ("Garageband", 1.0);
+    else if (pluginType.isSamplitude())
+        target->SetChannel ("Samplitude", 1.0);
+    else if (pluginType.isStudioOne())
+        target->SetChannel ("StudioOne", 1.0);
+    else if (pluginType.isBitwigStudio())
+        target->SetChannel ("Bitwig", 1.0);
+    else if (pluginType.isTracktion())
+        target->SetChannel ("Tracktion", 1.0);
+    else if (pluginType.isAdobeAudition())
+        target->SetChannel ("AdobeAudition", 1.0);
 #endif
-        {   //hack to get passed AU validation in logic
-            
-        if((mainInput.size()> 0 && mainInput.size()<32) && (mainOutput.size()>0 && mainOutput.size()<32))
-            return true;
+             
+    if (CabbageUtilities::getTarget() != CabbageUtilities::TargetTypes::IDE) {
+        target->SetChannel("IS_A_PLUGIN", 1.0);
+    }
+
+    //the play head belongs to the audio thread, a background reload gets host data from its first block
+    AudioPlayHead::CurrentPositionInfo hostPosition = {};
+    if (target == performingCsound.load() && getPlayHead() != 0 && getPlayHead()->getCurrentPosition (hostPosition))
+    {
+        target->SetChannel (CabbageIdentifierIds::hostbpm.toUTF8(), hostPosition.bpm);
+        target->SetChannel (CabbageIdentifierIds::timeinseconds.toUTF8(), hostPosition.timeInSeconds);
+        target->SetChannel (CabbageIdentifierIds::isplaying.toUTF8(), hostPosition.isPlaying);
+        target->SetChannel (CabbageIdentifierIds::isrecording.toUTF8(), hostPosition.isRecording);
+        target->SetChannel (CabbageIdentifierIds::hostppqpos.toUTF8(), hostPosition.ppqPosition);
+        target->SetChannel (CabbageIdentifierIds::timeinsamples.toUTF8(), hostPosition.timeInSamples);
+        target->SetChannel (CabbageIdentifierIds::timeSigDenom.toUTF8(), hostPosition.timeSigDenominator);
+        target->SetChannel (CabbageIdentifierIds::timeSigNum.toUTF8(), hostPosition.timeSigNumerator);
+    }
+
+
+    target->PerformKsmps();
+}
+//==============================================================================
+void CsoundPluginProcessor::addMacros (const CsdDocument& document, Csound* target)
+{
+    for (auto& option : document.getMacroOptions())
+        target->SetOption (option.toUTF8().getAddress());
+}
+
+//==============================================================================
+ChannelPointer* CsoundPluginProcessor::registerChannel (const String& channelName)
+{
+    for (auto* channel : channelPointers)
+    {
+        if (channel->getName() == channelName)
+            return channel;
+    }
+
+    ChannelPointer* channel = channelPointers.add (new ChannelPointer (channelName));
+
+    if (csound != nullptr && csdCompiledWithoutError())
+        channel->resolve (csound->GetCsound());
+
+    return channel;
+}
+
+void CsoundPluginProcessor::registerHostChannels()
+{
+    if (hostChannels[hostBpm] == nullptr)
+    {
+        hostChannels[hostBpm] = registerChannel (CabbageIdentifierIds::hostbpm);
+        hostChannels[timeInSeconds] = registerChannel (CabbageIdentifierIds::timeinseconds);
+        hostChannels[isPlaying] = registerChannel (CabbageIdentifierIds::isplaying);
+        hostChannels[isRecording] = registerChannel (CabbageIdentifierIds::isrecording);
+        hostChannels[hostPpqPos] = registerChannel (CabbageIdentifierIds::hostppqpos);
+        hostChannels[timeInSamples] = registerChannel (CabbageIdentifierIds::timeinsamples);
+        hostChannels[timeSigDenom] = registerChannel (CabbageIdentifierIds::timeSigDenom);
+        hostChannels[timeSigNum] = registerChannel (CabbageIdentifierIds::timeSigNum);
+        chnsetGestures = registerChannel ("CHNSET_GESTURES");
+        sleepChannel = registerChannel ("IS_SLEEPING");
+    }
+}
+
+void CsoundPluginProcessor::resolveChannelPointers()
+{
+    registerHostChannels();
+
+    for (auto* channel : channelPointers)
+        channel->resolve (csound != nullptr ? csound->GetCsound() : nullptr);
+
+    signalAnalyser.resolve (csound != nullptr ? csound->GetCsound() : nullptr);
+}
+
+SmoothedParameter* CsoundPluginProcessor::registerSmoothedParameter (ChannelPointer* channel, float rampTimeInSeconds, bool exponential)
+{
+    //host parameters can't be removed, so a rebuilt parameter picks up the smoother it had
+    //before and the list never grows past one entry per channel
+    for (auto* parameter : smoothedParameters)
+    {
+        if (parameter->getChannel() == channel)
+            return parameter;
+    }
+
+    return smoothedParameters.add (new SmoothedParameter (channel, rampTimeInSeconds, exponential));
+}
+
+void CsoundPluginProcessor::queueParameterChange (SmoothedParameter* parameter, MYFLT value)
+{
+    if (parameter == nullptr)
+        return;
+
+    //nothing drains the queue until Csound is running, so write straight through. Do the
+    //same if the queue is full, or this thread has no lane, rather than losing the change
+    if (csound == nullptr || !csdCompiledWithoutError() || !parameterQueue.push (parameter, value))
+        parameter->getChannel()->set (value);
+}
+
+//==============================================================================
+int CsoundPluginProcessor::getZeroLatencyKsmps (int nativeKsmps, int blockSize)
+{
+    if (blockSize <= 0 || blockSize % nativeKsmps == 0)
+        return nativeKsmps;
+
+    int ksmps = 1;
+    while (ksmps * 2 <= nativeKsmps && blockSize % (ksmps * 2) == 0)
+        ksmps *= 2;
+
+    return ksmps;
+}
+
+//==============================================================================
+void CsoundPluginProcessor::createMatrixEventSequencer(int cols, int rows, String channel, bool vertical)
+{
+    //the editor creates its sequencers each time it opens, so an existing grid for the channel is replaced
+    std::unique_ptr<MatrixEventSequencer> matrix (new MatrixEventSequencer(channel, registerChannel(channel), cols, rows, vertical));
+    std::unique_ptr<MatrixEventSequencer> replaced;
+
+    //only this thread changes the list, so the new one is built here and the audio thread
+    //just waits for the swap. Nothing is allocated or freed while the lock is held
+    OwnedArray<MatrixEventSequencer> updated;
+    updated.ensureStorageAllocated (matrixEventSequencers.size() + 1);
+
+    for (auto* existing : matrixEventSequencers)
+    {
+        if (existing->channel == channel && matrix != nullptr)
+        {
+            replaced.reset (existing);
+            updated.add (matrix.release());
         }
-#endif
-        return false;
+        else
+            updated.add (existing);
     }
 
-#if defined(Cabbage_IDE_Build) && defined(Cabbage_Lite)
-    if(mainInput.size() == numCsoundInputChannels && mainOutput.size() == numCsoundOutputChannels)
-        return true;
-#endif
-    
-    if ((mainInput.size() == numCsoundInputChannels - numSideChainChannels || mainInput.size() == mainOutput.size()) 
-        && mainOutput.size() == numCsoundOutputChannels)
+    if (matrix != nullptr)
+        updated.add (matrix.release());
+
     {
-        return true;
+        const SpinLock::ScopedLockType lock (matrixEventSequencerLock);
+        matrixEventSequencers.swapWith (updated);
     }
-        
 
-//    if(numSideChainChannels==0)
-    if (mainInput.size() == 1 && mainOutput.size() == 1)
+    //the outgoing list shares its grids with the new one, apart from the replaced grid which
+    //is already owned by replaced
+    updated.clear (false);
+}
+
+void CsoundPluginProcessor::setMatrixEventSequencerCellData(int col, int row, String channel, String data)
+{
+    //parse and look up instruments before taking the lock so the audio thread only ever waits for a copy
+    MatrixEventSequencer::Cell cell;
+    MatrixEventSequencer::compileCell(cell, data);
+
+    CSOUND* const cs = csound != nullptr ? csound->GetCsound() : nullptr;
+    if (cell.kind == MatrixEventSequencer::Cell::namedEvent && cs != nullptr)
+        cell.setInstrumentNumber (cs, lookUpInstrument (cs, cell.instrumentName), nullptr);
+
+    const bool isText = cell.kind == MatrixEventSequencer::Cell::scoreText;
+    const bool isTooLong = cell.kind == MatrixEventSequencer::Cell::empty && data.trim().isNotEmpty();
+    bool shouldReport = false;
+
     {
-#if defined(Cabbage_IDE_Build)
-        return true;
-#else
-        if (PluginHostType().isReaper())
+        const SpinLock::ScopedLockType lock (matrixEventSequencerLock);
+
+        for (auto* matrix : matrixEventSequencers)
         {
-            // Return `false` to make Reaper test for layouts other than 1 in and 1 out.
-            return false;
+            if (matrix->channel == channel)
+            {
+                if (MatrixEventSequencer::Cell* target = matrix->getCell(col, row))
+                    *target = cell;
+
+                //each kind of problem is reported once per grid
+                if (isText && !matrix->reportedTextCells)
+                    shouldReport = matrix->reportedTextCells = cs != nullptr;
+                else if (isTooLong && !matrix->reportedLongCells)
+                    shouldReport = matrix->reportedLongCells = cs != nullptr;
+            }
+        }
+    }
+
+    //text cells go through InputMessage() on the audio thread, too long ones are dropped
+    if (shouldReport)
+    {
+        const String problem = isText ? "is not a plain score event, it is sent to Csound as text: " : "is too long and has been ignored: ";
+        csound->Message (("Cabbage: eventsequencer cell " + problem + data.trim() + "\n").toRawUTF8());
+    }
+}
+
+void CsoundPluginProcessor::resolveMatrixEventSequencerInstruments (CSOUND* cs, CSOUND* keep)
+{
+    if (cs == nullptr)
+        return;
+
+    //only this thread writes cells, so they can be read here without the lock while the lookups run
+    Array<int> numbers;
+
+    for (auto* matrix : matrixEventSequencers)
+        for (int i = 0; i < matrix->getNumCells(); i++)
+            if (matrix->getCellAtIndex (i).kind == MatrixEventSequencer::Cell::namedEvent)
+                numbers.add (lookUpInstrument (cs, matrix->getCellAtIndex (i).instrumentName));
+
+    const SpinLock::ScopedLockType lock (matrixEventSequencerLock);
+    int next = 0;
+
+    for (auto* matrix : matrixEventSequencers)
+        for (int i = 0; i < matrix->getNumCells(); i++)
+            if (matrix->getCellAtIndex (i).kind == MatrixEventSequencer::Cell::namedEvent)
+                matrix->getCellAtIndex (i).setInstrumentNumber (cs, numbers[next++], keep);
+}
+
+//Csound warns about names it doesn't know
+int CsoundPluginProcessor::lookUpInstrument (CSOUND* cs, const char* name)
+{
+    const int number = (int) cs->strarg2insno (cs, (void*) name, 1);
+    return number > 0 && number < std::numeric_limits<int>::max() ? number : 0;
+}
+
+//==============================================================================
+StringArray CsoundPluginProcessor::getTableStatement (int tableNum)
+{
+    StringArray fdata;
+    fdata.add (String());
+
+    if (csCompileResult == OK)
+    {
+        MYFLT* argsPtr, *temp;
+        int noOfArgs = csoundGetTableArgs (csound->GetCsound(), &argsPtr, tableNum);
+
+        if (noOfArgs != -1)
+        {
+            int tableSize = csound->GetTable (temp, tableNum);
+            fdata.add (String (tableNum));
+            fdata.add ("0");
+            fdata.add (String (tableSize));
+
+            if (noOfArgs == 0)
+                fdata.add (String (1));
+            else
+                for (int i = 0; i < noOfArgs; i++)
+                {
+                    fdata.add (String (argsPtr[i]));
+                }
+        }
+    }
+
+    return fdata;
+}
+//==============================================================================
+const Array<float, CriticalSection> CsoundPluginProcessor::getTableFloats (int tableNum)
+{
+    Array<float, CriticalSection> points;
+    const TableView table = getTableView (tableNum);
+
+    if (table.isValid())
+    {
+        points.resize (table.size);
+        float* dest = points.getRawDataPointer();
+
+        for (int i = 0; i < table.size; i++)
+            dest[i] = (float) table.data[i];
+    }
+
+    return points;
+}
+
+TableView CsoundPluginProcessor::getTableView (int tableNum)
+{
+    TableView view;
+
+    if (csCompileResult == OK)
+    {
+        MYFLT* data = nullptr;
+        const int tableSize = csound->GetTable (data, tableNum);
+
+        if (tableSize > 0 && data != nullptr)
+        {
+            view.data = data;
+            view.size = tableSize;
+        }
+    }
+
+    return view;
+}
+
+int CsoundPluginProcessor::checkTable (int tableNum)
+{
+    return  csound->TableLength (tableNum);
+}
+
+
+//==============================================================================
+const String CsoundPluginProcessor::getCsoundOutput()
+{
+    if (csound!=nullptr)
+    {
+        const int messageCnt = csound->GetMessageCnt();
+        csoundOutput = "";
+
+        if (messageCnt == 0)
+            return csoundOutput;
+
+        while (csound->GetMessageCnt() > 0)
+        {
+            csoundOutput += csound->GetFirstMessage();
+            csound->PopFirstMessage();
+        }
+
+        Logger::writeToLog (csoundOutput);
+
+        if (disableLogging == true)
+            this->suspendProcessing (true);
+
+        return csoundOutput;
+    }
+
+    return String();
+}
+
+//==============================================================================
+const String CsoundPluginProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+bool CsoundPluginProcessor::acceptsMidi() const
+{
+#if JucePlugin_WantsMidiInput
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool CsoundPluginProcessor::producesMidi() const
+{
+#if JucePlugin_ProducesMidiOutput
+    return true;
+#else
+    return false;
+#endif
+}
+
+double CsoundPluginProcessor::getTailLengthSeconds() const
+{
+    return 0.0;
+}
+
+int CsoundPluginProcessor::getNumPrograms()
+{
+    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
+    // so this should be at least 1, even if you're not really implementing programs.
+}
+
+int CsoundPluginProcessor::getCurrentProgram()
+{
+    return 0;
+}
+
+void CsoundPluginProcessor::setCurrentProgram (int index)
+{
+}
+
+const String CsoundPluginProcessor::getProgramName (int index)
+{
+    return String();
+}
+
+void CsoundPluginProcessor::changeProgramName (int index, const String& newName)
+{
+}
+
+//==============================================================================
+void CsoundPluginProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+#if !defined(Cabbage_IDE_Build)
+    PluginHostType pluginType;
+    if (pluginType.isCubase())
+        hostIsCubase = true;
+#endif
+    
+#if ! JucePlugin_IsSynth
+    const int inputs = getBus(true, 0)->getNumberOfChannels();
+    CabbageUtilities::debug("CsoundPluginProcessor::prepareToPlay - inputs:", inputs);
+    CabbageUtilities::debug("CsoundPluginProcessor::prepareToPlay - Requested input channels:", numCsoundInputChannels);
+#endif
+    const int outputs = getBus(false, 0)->getNumberOfChannels();
+    CabbageUtilities::debug("CsoundPluginProcessor::prepareToPlay - outputs:", outputs);
+    CabbageUtilities::debug("CsoundPluginProcessor::prepareToPlay - Requested output channels:", numCsoundOutputChannels);
+
+    //a reload that hasn't been swapped in yet was built for the old settings. Drop it and compile
+    //the file in place below, it has already been pointed at the new text
+    const bool reloadDropped = cancelBackgroundRecompile();
+
+    //in zero latency mode the k-cycle has to line up with the host block, so a new block size may need a new ksmps
+    const bool zeroLatencyKsmpsChanged = preferredLatency == -1 && hostBlockSize != samplesPerBlock
+                                         && csound != nullptr && csdCompiledWithoutError()
+                                         && getZeroLatencyKsmps(nativeKsmps, samplesPerBlock * oversamplingFactor) != csdKsmps;
+    //switching between realtime and offline rendering picks up the form's offlineksmps()
+    const bool renderModeChanged = offlineKsmps > 0 && csound != nullptr && isNonRealtime() != compiledForNonRealtime;
+    hostBlockSize = samplesPerBlock;
+
+    int sideChainChannels = 0;
+    if (supportsSidechain)
+    {
+        numSideChainChannels = getBus(true, 0)->getNumberOfChannels();
+    }
+    
+    
+    if((samplingRate != sampleRate)
+       || hostRequestedMono
+#if ! JucePlugin_IsSynth && ! JucePlugin_IsSynth
+       || numCsoundInputChannels != inputs
+#endif
+       || numCsoundOutputChannels != outputs 
+       || numSideChainChannels != sideChainChannels
+       || zeroLatencyKsmpsChanged
+       || renderModeChanged
+       || reloadDropped)
+    {
+        //if sampling rate is other than default or has been changed, recompile..
+        samplingRate = sampleRate;
+        //allow mono plugins for Logic only..
+        if(hostRequestedMono == true)
+            setupAndCompileCsound(csdFile, csdFilePath, samplingRate, true);
+        else
+            setupAndCompileCsound(csdFile, csdFilePath, samplingRate);
+    }
+
+    //with oversample() Csound runs between a pair of resampling filters at a multiple of the host rate
+    const int numChannels = jmax (getTotalNumInputChannels(), getTotalNumOutputChannels());
+    oversampler.prepare (oversamplingFactor, numChannels, samplesPerBlock);
+    oversampledFloat.setSize (numChannels, oversamplingFactor > 1 ? samplesPerBlock * oversamplingFactor : 0);
+    oversampledDouble.setSize (numChannels, oversamplingFactor > 1 && isUsingDoublePrecision() ? samplesPerBlock * oversamplingFactor : 0);
+    oversampledMidi.ensureSize (4096);
+
+    //a reload is crossfaded in over one block at the rate Csound runs at
+    const int crossfadeSamples = samplesPerBlock * oversamplingFactor;
+    for (auto& crossfade : crossfadeFloat)
+        crossfade.setSize (numChannels, isUsingDoublePrecision() ? 0 : crossfadeSamples);
+    for (auto& crossfade : crossfadeDouble)
+        crossfade.setSize (numChannels, isUsingDoublePrecision() ? crossfadeSamples : 0);
+    oversampledMidiOutput.ensureSize (4096);
+
+    sideChainInputCapacity = getTotalNumInputChannels();
+    sideChainFloatInputs.calloc (jmax (1, sideChainInputCapacity));
+    sideChainDoubleInputs.calloc (jmax (1, sideChainInputCapacity));
+
+    reportLatency();
+}
+
+void CsoundPluginProcessor::reportLatency()
+{
+    if (preferredLatency == -1)
+        this->setLatencySamples(oversampler.getLatencyInSamples());
+    else
+	    this->setLatencySamples((preferredLatency == 0 ? csound->GetKsmps() / oversamplingFactor : preferredLatency)
+                                + oversampler.getLatencyInSamples());
+}
+
+void CsoundPluginProcessor::releaseResources()
+{
+    // When playback stops, you can use this as an opportunity to free up any
+    // spare memory, etc.
+}
+
+bool CsoundPluginProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+
+#if JucePlugin_IsMidiEffectz
+        ignoreUnused (layouts);
+        return true;
+#else
+    
+    const AudioChannelSet& mainInput  = layouts.getMainInputChannelSet();
+    const AudioChannelSet& mainOutput = layouts.getMainOutputChannelSet();
+    
+    CabbageUtilities::debug("MainOutputSize:", mainOutput.size());
+    CabbageUtilities::debug("MainInputSize:", mainInput.size());
+    
+    if(AudioProcessor::wrapperType == wrapperType_AudioUnit)
+    {
+#if  JucePlugin_IsSynth
+        //synth can only be mono or stereo...
+//        if (mainInput.size() == 0 && mainOutput.size() == 1)
+//            return true;
+//        if (mainInput.size() == 0 && mainOutput.size() == 2)
+//            return true;
+        if (mainInput.size() == 0 && mainOutput.size() == numCsoundOutputChannels)
+            return true;
+
+#else
+#if !defined(Cabbage_IDE_Build) && !defined(Cabbage_Lite)
+        if (PluginHostType().isReaper())
+        {
+            if(numSideChainChannels > 0)
+            {
+                if ((mainInput.size() == numCsoundInputChannels - numSideChainChannels || mainInput.size() == mainOutput.size())
+                    && mainOutput.size() == numCsoundOutputChannels)
+                {
+                    return true;
+                }
+            }
+            else
+            {
+                if(mainInput.size() == numCsoundInputChannels && mainOutput.size() == numCsoundOutputChannels)
+                    return true;
+            }
+            
+        }
+        else
+#endif
+        {   //hack to get passed AU validation in logic
+            
+        if((mainInput.size()> 0 && mainInput.size()<32) && (mainOutput.size()>0 && mainOutput.size()<32))
+            return true;
+        }
+#endif
+        return false;
+    }
+
+#if defined(Cabbage_IDE_Build) && defined(Cabbage_Lite)
+    if(mainInput.size() == numCsoundInputChannels && mainOutput.size() == numCsoundOutputChannels)
+        return true;
+#endif
+    
+    if ((mainInput.size() == numCsoundInputChannels - numSideChainChannels || mainInput.size() == mainOutput.size()) 
+        && mainOutput.size() == numCsoundOutputChannels)
+    {
+        return true;
+    }
+        
+
+//    if(numSideChainChannels==0)
+    if (mainInput.size() == 1 && mainOutput.size() == 1)
+    {
+#if defined(Cabbage_IDE_Build)
+        return true;
+#else
+        if (PluginHostType().isReaper())
+        {
+            // Return `false` to make Reaper test for layouts other than 1 in and 1 out.
+            return false;
+        }
+        else
+        {
+            return true;
+        }
+#endif
+    }
+        
+
+    return false;
+    
+#endif
+
+}
+
+//==========================================================================
+void CsoundPluginProcessor::triggerCsoundEvents()
+{
+    //the message thread only holds this lock to swap a grid or copy in a cell
+    const SpinLock::ScopedLockType lock (matrixEventSequencerLock);
+
+    for (auto* matrix : matrixEventSequencers)
+        matrix->dispatch(*performingCsound.load());
+}
+
+void CsoundPluginProcessor::handleAsyncUpdate()
+{
+    //only used for state changes such as going to sleep, regular updates come from the frame clock
+    guiRefreshScheduler.runFrame();
+}
+
+void CsoundPluginProcessor::refreshGui()
+{
+    //runs even when the current file didn't compile, so a background recompile can still be swapped in
+    finishCsoundSwap();
+    refreshSignalDisplays();
+
+    if (!cutKCyclesReported && numCutKCycles.load() > 0 && csound != nullptr)
+    {
+        csound->Message ("Cabbage: the host sent a block that doesn't line up with ksmps, the k-cycle at its end was cut short\n");
+        cutKCyclesReported = true;
+    }
+
+    if (csound == nullptr || !csdCompiledWithoutError())
+        return;
+
+    //nobody is watching the widgets while the host bounces offline, but automation and
+    //widget changes still have to reach Csound
+    if (!isNonRealtime())
+    {
+        //widgets hear about a frame's worth of channel changes once each
+        CabbageWidgetData::PropertyTransaction transaction;
+        getChannelDataFromCsound();
+    }
+
+    sendChannelDataToCsound();
+}
+
+void CsoundPluginProcessor::startGuiRefresh()
+{
+    int framesPerSecond = guiFrameRate > 0 ? guiFrameRate : 30;
+
+    //an explicit guirefresh() is a number of k-cycles, so it can only slow the frame clock down
+    if (guiRefreshRate > 0 && controlRate > 0)
+        framesPerSecond = jmin (framesPerSecond, int (controlRate / (oversamplingFactor * guiRefreshRate)));
+
+    guiRefreshScheduler.start (jlimit (1, 120, framesPerSecond));
+}
+
+void CsoundPluginProcessor::sendHostDataToCsound()
+{
+//    if (CabbageUtilities::getTarget() != CabbageUtilities::TargetTypes::IDE)
+//    {
+        if (AudioPlayHead* const ph = getPlayHead())
+        {
+            AudioPlayHead::CurrentPositionInfo hostPlayHeadInfo = {};
+            
+            if (ph->getCurrentPosition (hostPlayHeadInfo))
+            {
+                //channel pointers are resolved after each compile, so no name lookups here
+                hostChannels[hostBpm]->set (hostPlayHeadInfo.bpm);
+                hostChannels[timeInSeconds]->set (hostPlayHeadInfo.timeInSeconds);
+                hostChannels[isPlaying]->set (hostPlayHeadInfo.isPlaying);
+                hostChannels[isRecording]->set (hostPlayHeadInfo.isRecording);
+                hostChannels[hostPpqPos]->set (hostPlayHeadInfo.ppqPosition);
+                hostChannels[timeInSamples]->set (hostPlayHeadInfo.timeInSamples);
+                hostChannels[timeSigDenom]->set (hostPlayHeadInfo.timeSigDenominator);
+                hostChannels[timeSigNum]->set (hostPlayHeadInfo.timeSigNumerator);
+            }
+        }
+//    }
+}
+
+void CsoundPluginProcessor::performCsoundKsmps()
+{
+    Csound& performing = *performingCsound.load();
+	parameterQueue.process (controlRate);
+	tableEditor.applyPendingEdits (performing);
+	result = performing.PerformKsmps();
+
+	if (result == 0)
+	{
+		//trigger any Csound score event on each k-boundary
+		triggerCsoundEvents();
+
+		//when bouncing offline host data is written once per block instead, and nobody is watching the displays
+		if (!isNonRealtime())
+		{
+			sendHostDataToCsound();
+			signalAnalyser.pushSamples (csdKsmps);
+		}
+
+		disableLogging = false;
+	}
+	else
+	{
+		disableLogging = true;
+		return; //return as soon as Csound has stopped
+	}
+}
+
+//==============================================================================
+// Csound's spin/spout buffers are interleaved while JUCE hands us planar buffers.
+// These kernels move a whole ksmps slice per channel in one pass, folding the 0dBFS
+// scaling into the copy. Input is multiplied by 0dBFS and output divided by it, as
+// processCsoundIOBuffers() did, so the samples are the same as before. Stereo frames
+// go through the SSE2 kernels below when MYFLT is double, two or four frames at a
+// time; other channel counts, float builds of Csound and any leftover frames use the
+// scalar loops. When 0dBFS is 1 and the host runs in Csound's precision, a mono slice
+// is a plain copy.
+//==============================================================================
+#if JUCE_USE_SSE_INTRINSICS
+static int interleaveStereoSSE (double* dest, const float* left, const float* right, int numSamples, double scale)
+{
+    const __m128d s = _mm_set1_pd (scale);
+    const int numVectorised = numSamples & ~3;
+
+    for (int i = 0; i < numVectorised; i += 4)
+    {
+        const __m128 l = _mm_loadu_ps (left + i);
+        const __m128 r = _mm_loadu_ps (right + i);
+        const __m128d l01 = _mm_mul_pd (_mm_cvtps_pd (l), s);
+        const __m128d r01 = _mm_mul_pd (_mm_cvtps_pd (r), s);
+        const __m128d l23 = _mm_mul_pd (_mm_cvtps_pd (_mm_movehl_ps (l, l)), s);
+        const __m128d r23 = _mm_mul_pd (_mm_cvtps_pd (_mm_movehl_ps (r, r)), s);
+        _mm_storeu_pd (dest + i * 2, _mm_unpacklo_pd (l01, r01));
+        _mm_storeu_pd (dest + i * 2 + 2, _mm_unpackhi_pd (l01, r01));
+        _mm_storeu_pd (dest + i * 2 + 4, _mm_unpacklo_pd (l23, r23));
+        _mm_storeu_pd (dest + i * 2 + 6, _mm_unpackhi_pd (l23, r23));
+    }
+
+    return numVectorised;
+}
+
+static int interleaveStereoSSE (double* dest, const double* left, const double* right, int numSamples, double scale)
+{
+    const __m128d s = _mm_set1_pd (scale);
+    const int numVectorised = numSamples & ~1;
+
+    for (int i = 0; i < numVectorised; i += 2)
+    {
+        const __m128d l = _mm_mul_pd (_mm_loadu_pd (left + i), s);
+        const __m128d r = _mm_mul_pd (_mm_loadu_pd (right + i), s);
+        _mm_storeu_pd (dest + i * 2, _mm_unpacklo_pd (l, r));
+        _mm_storeu_pd (dest + i * 2 + 2, _mm_unpackhi_pd (l, r));
+    }
+
+    return numVectorised;
+}
+
+static int deinterleaveStereoSSE (float* left, float* right, const double* source, int numSamples, double scale)
+{
+    const __m128d s = _mm_set1_pd (scale);
+    const int numVectorised = numSamples & ~3;
+
+    for (int i = 0; i < numVectorised; i += 4)
+    {
+        const __m128d frame0 = _mm_loadu_pd (source + i * 2);
+        const __m128d frame1 = _mm_loadu_pd (source + i * 2 + 2);
+        const __m128d frame2 = _mm_loadu_pd (source + i * 2 + 4);
+        const __m128d frame3 = _mm_loadu_pd (source + i * 2 + 6);
+        const __m128 l01 = _mm_cvtpd_ps (_mm_div_pd (_mm_unpacklo_pd (frame0, frame1), s));
+        const __m128 r01 = _mm_cvtpd_ps (_mm_div_pd (_mm_unpackhi_pd (frame0, frame1), s));
+        const __m128 l23 = _mm_cvtpd_ps (_mm_div_pd (_mm_unpacklo_pd (frame2, frame3), s));
+        const __m128 r23 = _mm_cvtpd_ps (_mm_div_pd (_mm_unpackhi_pd (frame2, frame3), s));
+        _mm_storeu_ps (left + i, _mm_movelh_ps (l01, l23));
+        _mm_storeu_ps (right + i, _mm_movelh_ps (r01, r23));
+    }
+
+    return numVectorised;
+}
+
+static int deinterleaveStereoSSE (double* left, double* right, const double* source, int numSamples, double scale)
+{
+    const __m128d s = _mm_set1_pd (scale);
+    const int numVectorised = numSamples & ~1;
+
+    for (int i = 0; i < numVectorised; i += 2)
+    {
+        const __m128d frame0 = _mm_loadu_pd (source + i * 2);
+        const __m128d frame1 = _mm_loadu_pd (source + i * 2 + 2);
+        _mm_storeu_pd (left + i, _mm_div_pd (_mm_unpacklo_pd (frame0, frame1), s));
+        _mm_storeu_pd (right + i, _mm_div_pd (_mm_unpackhi_pd (frame0, frame1), s));
+    }
+
+    return numVectorised;
+}
+#endif
+
+//picked when there is no SIMD kernel for these sample types. Returns the number of frames done
+template< typename Dest, typename Source >
+static int interleaveStereoSSE (Dest*, const Source*, const Source*, int, MYFLT)      { return 0; }
+
+template< typename Dest, typename Source >
+static int deinterleaveStereoSSE (Dest*, Dest*, const Source*, int, MYFLT)            { return 0; }
+
+template< bool Scaled, typename Type >
+static void interleaveChannel (MYFLT* dest, int stride, const Type* source, int numSamples, MYFLT scale)
+{
+    if (source == nullptr)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            dest[i * stride] = 0;
+    }
+    else
+    {
+        for (int i = 0; i < numSamples; ++i)
+            dest[i * stride] = Scaled ? MYFLT (source[i]) * scale : MYFLT (source[i]);
+    }
+}
+
+template< bool Scaled, typename Type >
+static void interleaveStereo (MYFLT* dest, const Type* left, const Type* right, int numSamples, MYFLT scale)
+{
+    for (int i = interleaveStereoSSE (dest, left, right, numSamples, Scaled ? scale : MYFLT (1)); i < numSamples; ++i)
+    {
+        dest[i * 2] = Scaled ? MYFLT (left[i]) * scale : MYFLT (left[i]);
+        dest[i * 2 + 1] = Scaled ? MYFLT (right[i]) * scale : MYFLT (right[i]);
+    }
+}
+
+template< bool Scaled, typename Type >
+static void deinterleaveChannel (Type* dest, const MYFLT* source, int stride, int numSamples, MYFLT scale)
+{
+    for (int i = 0; i < numSamples; ++i)
+        dest[i] = Scaled ? Type (source[i * stride] / scale) : Type (source[i * stride]);
+}
+
+template< bool Scaled, typename Type >
+static void deinterleaveStereo (Type* left, Type* right, const MYFLT* source, int numSamples, MYFLT scale)
+{
+    for (int i = deinterleaveStereoSSE (left, right, source, numSamples, Scaled ? scale : MYFLT (1)); i < numSamples; ++i)
+    {
+        left[i] = Scaled ? Type (source[i * 2] / scale) : Type (source[i * 2]);
+        right[i] = Scaled ? Type (source[i * 2 + 1] / scale) : Type (source[i * 2 + 1]);
+    }
+}
+
+//a mono slice in the host's own sample type is a block copy. Returns false when the
+//sample types differ and the kernels above have to convert
+static bool copyWithoutConversion (MYFLT* dest, const MYFLT* source, int numSamples)
+{
+    FloatVectorOperations::copy (dest, source, numSamples);
+    return true;
+}
+
+template< typename Type >
+static bool copyWithoutConversion (MYFLT*, const Type*, int)    { return false; }
+
+template< typename Type >
+static bool copyWithoutConversion (Type*, const MYFLT*, int)    { return false; }
+
+//copies a slice of host channels into Csound's interleaved frames, picking the cheapest kernel
+template< typename Type >
+static void writeInterleaved (MYFLT* frame, const Type* const* channels, int numChannels, int startSample, int numSamples, MYFLT cs_scale)
+{
+    const bool unityScale = cs_scale == 1;
+
+    if (numChannels == 1 && unityScale && channels[0] != nullptr
+        && copyWithoutConversion (frame, channels[0] + startSample, numSamples))
+        return;
+
+    if (numChannels == 2 && channels[0] != nullptr && channels[1] != nullptr)
+    {
+        if (unityScale)
+            interleaveStereo<false> (frame, channels[0] + startSample, channels[1] + startSample, numSamples, cs_scale);
+        else
+            interleaveStereo<true> (frame, channels[0] + startSample, channels[1] + startSample, numSamples, cs_scale);
+        return;
+    }
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        const Type* source = channels[channel] != nullptr ? channels[channel] + startSample : nullptr;
+
+        if (unityScale)
+            interleaveChannel<false> (frame + channel, numChannels, source, numSamples, cs_scale);
+        else
+            interleaveChannel<true> (frame + channel, numChannels, source, numSamples, cs_scale);
+    }
+}
+
+template< typename Type >
+static void readInterleaved (Type* const* channels, int numChannels, int startSample, int numSamples, const MYFLT* frame, MYFLT cs_scale)
+{
+    const bool unityScale = cs_scale == 1;
+
+    if (numChannels == 1 && unityScale && copyWithoutConversion (channels[0] + startSample, frame, numSamples))
+        return;
+
+    if (numChannels == 2)
+    {
+        if (unityScale)
+            deinterleaveStereo<false> (channels[0] + startSample, channels[1] + startSample, frame, numSamples, cs_scale);
+        else
+            deinterleaveStereo<true> (channels[0] + startSample, channels[1] + startSample, frame, numSamples, cs_scale);
+        return;
+    }
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        if (unityScale)
+            deinterleaveChannel<false> (channels[channel] + startSample, frame + channel, numChannels, numSamples, cs_scale);
+        else
+            deinterleaveChannel<true> (channels[channel] + startSample, frame + channel, numChannels, numSamples, cs_scale);
+    }
+}
+
+template< typename Type >
+void CsoundPluginProcessor::writeCsoundInputBlock (const Type* const* channels, int numChannels, int startSample, int numSamples, bool padToKsmps)
+{
+    writeInterleaved (CSspin + csndIndex * numChannels, channels, numChannels, startSample, numSamples, cs_scale);
+
+    if (padToKsmps)
+        FloatVectorOperations::clear (CSspin + (csndIndex + numSamples) * numChannels, (csdKsmps - csndIndex - numSamples) * numChannels);
+}
+
+template< typename Type >
+void CsoundPluginProcessor::readCsoundOutputBlock (Type* const* channels, int numChannels, int startSample, int numSamples)
+{
+    readInterleaved (channels, numChannels, startSample, numSamples, CSspout + csndIndex * numChannels, cs_scale);
+}
+
+//==============================================================================
+// Times the slice kernels against the transfer they replaced. legacyProcessCsoundIOBuffers()
+// is processCsoundIOBuffers() as it was, less the zero latency branch that called
+// performKsmps(): one sample of one channel per call, with the buffer type tested at run
+// time and each channel's pointer stepped by reference. Each case moves a host block in
+// and out of Csound's interleaved buffers in ksmps sized slices.
+//==============================================================================
+enum LegacyBufferType
+{
+    legacyOutput = 0,
+    legacyInput
+};
+
+template< typename Type >
+static void legacyProcessCsoundIOBuffers (int bufferType, Type*& buffer, MYFLT* spin, const MYFLT* spout, int pos, MYFLT cs_scale)
+{
+    if (bufferType == legacyOutput)
+    {
+        Type*& current_sample = buffer;
+        *current_sample = (spout[pos] / cs_scale);
+        ++current_sample;
+    }
+    else //input
+    {
+        if (buffer != nullptr)
+        {
+            Type*& current_sample = buffer;
+            MYFLT newSamp = *current_sample * cs_scale;
+            spin[pos] = newSamp;
+            current_sample++;
+        }
+        else
+            spin[pos] = 0;
+    }
+}
+
+template< typename Type >
+static double timeBlockTransfer (bool useSlices, int numChannels, int ksmps, MYFLT scale, int blocks)
+{
+    const int blockSize = 512;
+    AudioBuffer<Type> buffer (numChannels, blockSize);
+    HeapBlock<MYFLT> spin (ksmps * numChannels, true), spout (ksmps * numChannels, true);
+
+    for (int channel = 0; channel < numChannels; channel++)
+        for (int i = 0; i < blockSize; i++)
+            buffer.setSample (channel, i, Type (std::sin (i * 0.01 * (channel + 1))));
+
+    HeapBlock<Type*> inputBuffer (numChannels), outputBuffer (numChannels);
+    const double start = Time::getMillisecondCounterHiRes();
+
+    for (int block = 0; block < blocks; block++)
+    {
+        for (int channel = 0; channel < numChannels; channel++)
+            inputBuffer[channel] = outputBuffer[channel] = buffer.getWritePointer (channel);
+
+        for (int i = 0; i < blockSize; i += ksmps)
+        {
+            const int samples = jmin (ksmps, blockSize - i);
+
+            if (useSlices)
+            {
+                writeInterleaved (spin.get(), buffer.getArrayOfReadPointers(), numChannels, i, samples, scale);
+                readInterleaved (buffer.getArrayOfWritePointers(), numChannels, i, samples, spout.get(), scale);
+            }
+            else
+            {
+                for (int csndIndex = 0; csndIndex < samples; csndIndex++)
+                {
+                    int pos = csndIndex * numChannels;
+                    for (int channel = 0; channel < numChannels; channel++)
+                    {
+                        legacyProcessCsoundIOBuffers (legacyInput, inputBuffer[channel], spin.get(), spout.get(), pos, scale);
+                        pos++;
+                    }
+
+                    pos = csndIndex * numChannels;
+                    for (int channel = 0; channel < numChannels; channel++)
+                    {
+                        legacyProcessCsoundIOBuffers (legacyOutput, outputBuffer[channel], spin.get(), spout.get(), pos, scale);
+                        pos++;
+                    }
+                }
+            }
+        }
+
+        //keep the output different from the input so neither loop can be folded away
+        spout[block % (ksmps * numChannels)] += spin[0];
+    }
+
+    return Time::getMillisecondCounterHiRes() - start;
+}
+
+StringArray CsoundPluginProcessor::benchmarkBlockTransfer()
+{
+    StringArray results;
+    const int blocks = 20000;
+
+    for (auto numChannels : { 1, 2, 8 })
+    {
+        for (auto scale : { MYFLT (1), MYFLT (32768) })
+        {
+            const double perSampleFloat = timeBlockTransfer<float> (false, numChannels, 32, scale, blocks);
+            const double slicedFloat = timeBlockTransfer<float> (true, numChannels, 32, scale, blocks);
+            const double perSampleDouble = timeBlockTransfer<double> (false, numChannels, 32, scale, blocks);
+            const double slicedDouble = timeBlockTransfer<double> (true, numChannels, 32, scale, blocks);
+
+            results.add (String (numChannels) + " channels, 0dbfs " + String (scale, 0) + ": float "
+                         + String (perSampleFloat / blocks * 1000.0, 3) + " -> " + String (slicedFloat / blocks * 1000.0, 3)
+                         + " us per block, double " + String (perSampleDouble / blocks * 1000.0, 3) + " -> "
+                         + String (slicedDouble / blocks * 1000.0, 3) + " us per block");
+        }
+    }
+
+    return results;
+}
+
+void CsoundPluginProcessor::processBlock(AudioBuffer< float >& buffer, MidiBuffer& midiMessages)
+{
+    if (oversampler.getFactor() > 1)
+        processOversampled(buffer, oversampledFloat, midiMessages);
+    else
+	    processSamples(buffer, midiMessages);
+}
+
+void CsoundPluginProcessor::processBlock(AudioBuffer< double >& buffer, MidiBuffer& midiMessages)
+{
+    if (oversampler.getFactor() > 1)
+        processOversampled(buffer, oversampledDouble, midiMessages);
+    else
+	    processSamples(buffer, midiMessages);
+}
+
+template< typename Type >
+void CsoundPluginProcessor::processOversampled(AudioBuffer< Type >& buffer, AudioBuffer< Type >& oversampledBuffer, MidiBuffer& midiMessages)
+{
+    const int factor = oversampler.getFactor();
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = jmin (buffer.getNumChannels(), oversampledBuffer.getNumChannels());
+    const int maxChunk = oversampledBuffer.getNumSamples() / factor;
+
+    if (maxChunk == 0)
+    {
+        buffer.clear();
+        return;
+    }
+
+    oversampledMidiOutput.clear();
+
+    //hosts may pass blocks larger than promised, so work through the block in chunks the buffer can hold
+    for (int start = 0; start < numSamples; start += maxChunk)
+    {
+        const int chunk = jmin (maxChunk, numSamples - start);
+        AudioBuffer< Type > block (oversampledBuffer.getArrayOfWritePointers(), numChannels, chunk * factor);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            oversampler.upsample (buffer.getReadPointer (channel, start), block.getWritePointer (channel), channel, chunk);
+
+        oversampledMidi.clear();
+        MidiBuffer::Iterator iterator (midiMessages);
+        const uint8* data;
+        int numBytes, position;
+
+        while (iterator.getNextEvent (data, numBytes, position))
+        {
+            if (position >= start && position < start + chunk)
+                oversampledMidi.addEvent (data, numBytes, (position - start) * factor);
+        }
+
+        processSamples (block, oversampledMidi);
+
+        for (int channel = 0; channel < jmin (numChannels, getTotalNumOutputChannels()); ++channel)
+            oversampler.downsample (block.getReadPointer (channel), buffer.getWritePointer (channel, start), channel, chunk);
+
+#if JucePlugin_ProducesMidiOutput
+        oversampledMidiOutput.addEvents (oversampledMidi, 0, -1, start);
+#endif
+    }
+
+#if JucePlugin_ProducesMidiOutput
+    midiMessages.swapWith (oversampledMidiOutput);
+#endif
+}
+
+template< typename Type >
+void CsoundPluginProcessor::processSamples(AudioBuffer< Type >& buffer, MidiBuffer& midiMessages)
+{
+	ScopedNoDenormals noDenormals;
+    const int numSamples = buffer.getNumSamples();
+
+	//if no inputs are used clear buffer in case it's not empty..
+	if (getTotalNumInputChannels() == 0)
+		buffer.clear();
+
+	keyboardState.processNextMidiBuffer(midiMessages, 0, numSamples, true);
+
+    //a background recompile is swapped in between blocks. For that one block both instances
+    //run on the same input and the outgoing one is crossfaded into the new one. The state is
+    //claimed with a compare and swap, cancelBackgroundRecompile() may be taking the instance away
+    AudioBuffer< Type >* outgoing = nullptr;
+    bool fadeIn = false;
+    int state = swapState.load();
+    if (state == swapReady && swapState.compare_exchange_strong (state, swapSwapping))
+    {
+        AudioBuffer< Type >* crossfade = getCrossfadeBuffers (Type());
+
+        if (csdCompiledWithoutError() && !sleeping.load()
+            && crossfade[0].getNumSamples() >= numSamples && crossfade[0].getNumChannels() >= buffer.getNumChannels())
+        {
+            //the outgoing instance works on a copy of the input, which is put back for the new one
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                crossfade[0].copyFrom (channel, 0, buffer, channel, 0, numSamples);
+
+            performBlock (buffer, midiMessages);
+            //MIDI the old instance hasn't read yet is scheduled again for the new one
+            midiScheduler.clear();
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            {
+                crossfade[1].copyFrom (channel, 0, buffer, channel, 0, numSamples);
+                buffer.copyFrom (channel, 0, crossfade[0], channel, 0, numSamples);
+            }
+
+            outgoing = &crossfade[1];
         }
         else
         {
-            return true;
+            //nothing audible to fade from, or a block larger than the host promised
+            fadeIn = true;
         }
-#endif
-    }
-        
-
-    return false;
-    
-#endif
 
-}
+        swapInPreparedCsound();
+    }
 
-//==========================================================================
-void CsoundPluginProcessor::triggerCsoundEvents()
-{
+    //after the outgoing instance has run, so the block's parameter changes reach the new one
+    parameterQueue.beginBlock (numSamples, samplingRate * oversamplingFactor);
 
-}
+	if (csdCompiledWithoutError())
+	{
+        //auto sleep: once input and output have been silent for the tail time with no MIDI
+        //notes sounding, Csound stops performing until input or MIDI arrives
+        const Type silenceThreshold = Type (1.0e-5);
+        bool inputIsSilent = true;
+        if (autoSleepTime > 0)
+        {
+            for (int channel = 0; channel < getTotalNumInputChannels() && inputIsSilent; ++channel)
+                inputIsSilent = buffer.getMagnitude (channel, 0, numSamples) < silenceThreshold;
 
-void CsoundPluginProcessor::handleAsyncUpdate()
-{
-    getChannelDataFromCsound();
-    sendChannelDataToCsound();
-}
+            trackHeldMidiNotes (midiMessages);
 
-void CsoundPluginProcessor::sendHostDataToCsound()
-{
-//    if (CabbageUtilities::getTarget() != CabbageUtilities::TargetTypes::IDE)
-//    {
-        if (AudioPlayHead* const ph = getPlayHead())
-        {
-            AudioPlayHead::CurrentPositionInfo hostPlayHeadInfo = {};
-            
-            if (ph->getCurrentPosition (hostPlayHeadInfo))
+            if (sleeping.load())
             {
-                csound->SetChannel (CabbageIdentifierIds::hostbpm.toUTF8(), hostPlayHeadInfo.bpm);
-                csound->SetChannel (CabbageIdentifierIds::timeinseconds.toUTF8(), hostPlayHeadInfo.timeInSeconds);
-                csound->SetChannel (CabbageIdentifierIds::isplaying.toUTF8(), hostPlayHeadInfo.isPlaying);
-                csound->SetChannel (CabbageIdentifierIds::isrecording.toUTF8(), hostPlayHeadInfo.isRecording);
-                csound->SetChannel (CabbageIdentifierIds::hostppqpos.toUTF8(), hostPlayHeadInfo.ppqPosition);
-                csound->SetChannel (CabbageIdentifierIds::timeinsamples.toUTF8(), hostPlayHeadInfo.timeInSamples);
-                csound->SetChannel (CabbageIdentifierIds::timeSigDenom.toUTF8(), hostPlayHeadInfo.timeSigDenominator);
-                csound->SetChannel (CabbageIdentifierIds::timeSigNum.toUTF8(), hostPlayHeadInfo.timeSigNumerator);
+                if (inputIsSilent && midiMessages.isEmpty())
+                {
+                    buffer.clear();
+                    parameterQueue.scheduleUpTo (numSamples);
+                    parameterQueue.process (controlRate);
+                    return;
+                }
+
+                setSleeping (false);
             }
         }
-//    }
-}
 
-void CsoundPluginProcessor::performCsoundKsmps()
-{
-	result = csound->PerformKsmps();
+        if (isNonRealtime())
+            sendHostDataToCsound();
 
-	if (result == 0)
-	{
-		//slow down calls to these functions, no need for them to be firing at k-rate
-		if (guiCycles > guiRefreshRate)
-		{
-			guiCycles = 0;
-			triggerAsyncUpdate();
-		}
-		else
-			++guiCycles;
+        performBlock (buffer, midiMessages);
 
-		//trigger any Csound score event on each k-boundary
-		triggerCsoundEvents();
-		sendHostDataToCsound();
+        if (autoSleepTime > 0)
+        {
+            bool isIdle = inputIsSilent && midiMessages.isEmpty();
+            for (int channel = 0; channel < getTotalNumOutputChannels() && isIdle; ++channel)
+                isIdle = buffer.getMagnitude (channel, 0, numSamples) < silenceThreshold;
 
-		disableLogging = false;
-	}
-	else
-	{
-		disableLogging = true;
-		return; //return as soon as Csound has stopped
-	}
-}
+            silentSamples = isIdle && !hasHeldMidiNotes() ? silentSamples + numSamples : 0;
 
-template< typename Type >
-void CsoundPluginProcessor::processCsoundIOBuffers(int bufferType, Type*& buffer, int pos)
-{
-	if (bufferType == BufferType::inputOutput)
-	{
-		Type*& current_sample = buffer;
-		MYFLT sample = *current_sample * cs_scale;
-		CSspin[pos] = sample;
-        //if we want 0 latency, we have to fill Csound spin buffer before we call performKsmps()
-        if (preferredLatency == -1)
-            performCsoundKsmps();
-		*current_sample = (CSspout[pos] / cs_scale);
-		++current_sample;
-	}
-	else if (bufferType == BufferType::output)
-	{
-		Type*& current_sample = buffer;
-		*current_sample = (CSspout[pos] / cs_scale);
-		++current_sample;
-	}
-	else //input
-	{
-        if(buffer != nullptr)
+            if (silentSamples >= int64 (autoSleepTime * samplingRate * oversamplingFactor))
+                setSleeping (true);
+        }
+    }//if not compiled just mute output
+    else
+    {
+        for (int channel = 0; channel < getTotalNumOutputChannels(); ++channel)
         {
-			Type*& current_sample = buffer;
-            MYFLT newSamp = *current_sample * cs_scale;
-            CSspin[pos] = newSamp;
-            current_sample++;
+            buffer.clear (channel, 0, buffer.getNumSamples());
         }
-        else
-            CSspin[pos] = 0;
-	}
-}
+    }
 
-template< typename Type >
-void CsoundPluginProcessor::processCsoundIOSideChainBuffers(int bufferType, Type* buffer, int pos)
-{
-    if (buffer != nullptr)
+    if (outgoing != nullptr)
+    {
+        buffer.applyGainRamp (0, numSamples, Type (0), Type (1));
+
+        for (int channel = 0; channel < getTotalNumOutputChannels(); ++channel)
+            buffer.addFromWithRamp (channel, 0, outgoing->getReadPointer (channel), numSamples, Type (1), Type (0));
+    }
+    else if (fadeIn)
     {
-        Type* current_sample = buffer;
-        MYFLT newSamp = *current_sample * cs_scale;
-        CSspin[pos] = newSamp;
-        current_sample++;
+        buffer.applyGainRamp (0, numSamples, Type (0), Type (1));
     }
-    else
-        CSspin[pos] = 0;
-}
 
-void CsoundPluginProcessor::processBlock(AudioBuffer< float >& buffer, MidiBuffer& midiMessages)
-{
-	processSamples(buffer, midiMessages);
-}
+#if JucePlugin_ProducesMidiOutput
 
-void CsoundPluginProcessor::processBlock(AudioBuffer< double >& buffer, MidiBuffer& midiMessages)
-{
-	processSamples(buffer, midiMessages);
+	if (!midiOutputBuffer.isEmpty())
+	{
+		midiMessages.clear();
+		midiMessages.swapWith(midiOutputBuffer);
+	}
+	else
+		midiMessages.clear();
+
+#endif
 }
 
 template< typename Type >
-void CsoundPluginProcessor::processSamples(AudioBuffer< Type >& buffer, MidiBuffer& midiMessages)
+void CsoundPluginProcessor::performBlock (AudioBuffer< Type >& buffer, MidiBuffer& midiMessages)
 {
-	ScopedNoDenormals noDenormals;
 	auto mainOutput = getBusBuffer(buffer, false, 0);
 #if !JucePlugin_IsSynth
 	auto mainInput = getBusBuffer(buffer, true, 0);
@@ -1055,129 +2404,103 @@ void CsoundPluginProcessor::processSamples(AudioBuffer< Type >& buffer, MidiBuff
 #endif
     const int numSamples = buffer.getNumSamples();
 
+    //a swap can change the channel counts between two calls in the same block
 	const int outputChannelCount = (numCsoundOutputChannels > getTotalNumOutputChannels() ? getTotalNumOutputChannels() : numCsoundOutputChannels);
 	const int inputChannelCount = (numCsoundInputChannels > getTotalNumInputChannels() ? getTotalNumInputChannels() : numCsoundInputChannels);
 
-	//if no inputs are used clear buffer in case it's not empty..
-	if (getTotalNumInputChannels() == 0)
-		buffer.clear();
-
-	keyboardState.processNextMidiBuffer(midiMessages, 0, numSamples, true);
-    
-    //events need to be added at the correct time...
-	//midiBuffer.addEvents(midiMessages, 0, numSamples, 0);
-    
-    int samplePos = 0;
-    MidiMessage message;
-    MidiBuffer::Iterator iter (midiMessages);
+    //host events are already sorted by time, so a single iterator walks them across all k-cycles
+    MidiBuffer::Iterator midiIterator (midiMessages);
+    midiScheduler.beginBlock();
 
-	if (csdCompiledWithoutError())
+	//mute unused channels
+	for (int channelsToClear = outputChannelCount; channelsToClear < getTotalNumOutputChannels(); ++channelsToClear)
 	{
-		//mute unused channels
-		for (int channelsToClear = outputChannelCount; channelsToClear < getTotalNumOutputChannels(); ++channelsToClear)
-		{
-			buffer.clear(channelsToClear, 0, buffer.getNumSamples());
-		}
+		buffer.clear(channelsToClear, 0, buffer.getNumSamples());
+	}
 
-		for (int i = 0; i < numSamples; i++, ++csndIndex)
-		{
-			if (csndIndex == csdKsmps)
-			{
-                //don't call performKsmps here if we want 0 latency
-                if(preferredLatency != -1)
-				    performCsoundKsmps();
-				csndIndex = 0;
-			}
-            
-            while(iter.getNextEvent (message, samplePos))
-            {
-                //if current sample position matches time code for MIDI event, add it to buffer...
-                if(samplePos == i)
-                    midiBuffer.addEvent(message, samplePos);
-            }
-            
-            //reset the iterator each time, so that we can step through the events again to see if they should be added
-            iter.setNextSamplePosition(0);
-	
 #if !JucePlugin_IsSynth
-            //if using Logic process inputs and outputs separately - otherwise its mono to stereo features break...
-			if (matchingNumberOfIOChannels && !isLogic)
-			{
-				pos = csndIndex * outputChannelCount;
-				for (int channel = 0; channel < outputChannelCount; channel++)
-				{
-					processCsoundIOBuffers(BufferType::inputOutput, outputBuffer[channel], pos);
-					pos++;
-				}
-			}
-			else if (!supportsSidechain)
-			{
-				pos = csndIndex * inputChannelCount;
-				for (int channel = 0; channel < inputChannelCount; channel++)
-				{
-					processCsoundIOBuffers(BufferType::input, inputBuffer[channel], pos);
-					pos++;
-				}
-
-				pos = csndIndex * outputChannelCount;
-				for (int channel = 0; channel < outputChannelCount; channel++)
-				{
-					processCsoundIOBuffers(BufferType::output, outputBuffer[channel], pos);
-					pos++;
-				}
-			}
-			else {
-				//sidechain processing
-				pos = csndIndex * inputChannelCount;
-				for (int channel = 0; channel < inputChannelCount; channel++)
-				{
-					if(channel< numSideChainChannels)
-						processCsoundIOBuffers(BufferType::input, inputBuffer[channel], pos);
-                    else{
-                        if(hostIsCubase)
-                            processCsoundIOSideChainBuffers(BufferType::input, sideChainCubase[channel-numSideChainChannels], pos);
-                        else
-                            processCsoundIOBuffers(BufferType::input, sideChainBuffer[channel-numSideChainChannels], pos);
-                    }
-					pos++;
-				}
+    //sidechain inputs are gathered from two buses, so collect the channel pointers once per block.
+    //The pointer table is sized from the bus layout in prepareToPlay()
+    const Type** sideChainInputs = getSideChainInputs (Type());
+    jassert (inputChannelCount <= sideChainInputCapacity);
+    const int sideChainInputCount = jmin (inputChannelCount, sideChainInputCapacity);
 
-				pos = csndIndex * outputChannelCount;
-				for (int channel = 0; channel < outputChannelCount; channel++)
-				{
-					processCsoundIOBuffers(BufferType::output, outputBuffer[channel], pos);
-					pos++;
-				}
-			}
-#else
-            pos = csndIndex * outputChannelCount;
-            for (int channel = 0; channel < outputChannelCount; channel++)
-            {
-                processCsoundIOBuffers(BufferType::output, outputBuffer[channel], pos);
-                pos++;
-            }
-#endif
-		}
-    }//if not compiled just mute output
-    else
+    if (supportsSidechain && !(matchingNumberOfIOChannels && !isLogic))
     {
-        for (int channel = 0; channel < getTotalNumOutputChannels(); ++channel)
+        for (int channel = 0; channel < sideChainInputCount; channel++)
         {
-            buffer.clear (channel, 0, buffer.getNumSamples());
+            if (channel < numSideChainChannels)
+                sideChainInputs[channel] = inputBuffer[channel];
+            else
+                sideChainInputs[channel] = hostIsCubase ? sideChainCubase[channel - numSideChainChannels]
+                                                        : sideChainBuffer[channel - numSideChainChannels];
         }
     }
+#endif
 
-#if JucePlugin_ProducesMidiOutput
+    const bool zeroLatency = preferredLatency == -1;
 
-	if (!midiOutputBuffer.isEmpty())
+	for (int i = 0; i < numSamples; )
 	{
-		midiMessages.clear();
-		midiMessages.swapWith(midiOutputBuffer);
-	}
-	else
-		midiMessages.clear();
+		if (csndIndex == csdKsmps)
+		{
+            //don't call performKsmps here if we want 0 latency
+            if(!zeroLatency)
+			    performCsoundKsmps();
+			csndIndex = 0;
+		}
 
+        //never run past the end of the current k-cycle or the host block
+        const int samplesToProcess = jmin (csdKsmps - csndIndex, numSamples - i);
+        //zero latency needs every block to end on a k-cycle boundary. A block that doesn't, as
+        //hosts send at loop points, has its last k-cycle run early on silence padded input. The
+        //rest of that k-cycle is dropped and the next block starts a fresh one, so the instance
+        //stays at zero latency and only Csound's clock moves on by the samples cut
+        const bool endsMidCycle = zeroLatency && i + samplesToProcess == numSamples && csndIndex + samplesToProcess < csdKsmps;
+        //if we want 0 latency, we have to fill Csound spin buffer before we call performKsmps()
+        const bool performBeforeOutput = zeroLatency && (csndIndex + samplesToProcess == csdKsmps || endsMidCycle);
+
+        //events need to be added at the correct time...
+        midiScheduler.scheduleUpTo (midiIterator, i + samplesToProcess);
+        parameterQueue.scheduleUpTo (i + samplesToProcess);
+
+#if !JucePlugin_IsSynth
+        //if using Logic process inputs and outputs separately - otherwise its mono to stereo features break...
+		if (matchingNumberOfIOChannels && !isLogic)
+		{
+            writeCsoundInputBlock (outputBuffer, outputChannelCount, i, samplesToProcess, endsMidCycle);
+            if (performBeforeOutput)
+                performCsoundKsmps();
+            readCsoundOutputBlock (outputBuffer, outputChannelCount, i, samplesToProcess);
+		}
+		else if (!supportsSidechain)
+		{
+            writeCsoundInputBlock (inputBuffer, inputChannelCount, i, samplesToProcess, endsMidCycle);
+            if (performBeforeOutput)
+                performCsoundKsmps();
+            readCsoundOutputBlock (outputBuffer, outputChannelCount, i, samplesToProcess);
+		}
+		else {
+			//sidechain processing
+            writeCsoundInputBlock (sideChainInputs, sideChainInputCount, i, samplesToProcess, endsMidCycle);
+            if (performBeforeOutput)
+                performCsoundKsmps();
+            readCsoundOutputBlock (outputBuffer, outputChannelCount, i, samplesToProcess);
+		}
+#else
+        if (performBeforeOutput)
+            performCsoundKsmps();
+        readCsoundOutputBlock (outputBuffer, outputChannelCount, i, samplesToProcess);
 #endif
+        csndIndex += samplesToProcess;
+        i += samplesToProcess;
+
+        if (endsMidCycle)
+        {
+            csndIndex = csdKsmps;
+            ++numCutKCycles;
+        }
+	}
 }
 
 //==============================================================================
@@ -1223,33 +2546,27 @@ void CsoundPluginProcessor::breakpointCallback (CSOUND* csound, debug_bkpt_info_
 }
 
 //==============================================================================
-CsoundPluginProcessor::SignalDisplay* CsoundPluginProcessor::getSignalArray (String variableName, String displayType)
+SignalDisplay* CsoundPluginProcessor::getSignalArray (String variableName, String displayType)
 {
-    for (int i = 0; i < signalArrays.size(); i++)
-    {
-        const String test = signalArrays[i]->caption;
-        if (signalArrays[i]->caption.isNotEmpty() && signalArrays[i]->caption.contains (variableName))
-        {
-            const String varName = signalArrays[i]->variableName;
-            if (displayType.isEmpty()){
-                return signalArrays[i];
-            }
-
-            else if (displayType == "waveform" && !signalArrays[i]->caption.contains ("fft")){
-                return signalArrays[i];
-            }
+    refreshSignalDisplays();
 
-            else if (displayType == "lissajous" && !signalArrays[i]->caption.contains ("fft")){
-                return signalArrays[i];
-            }
+    //newest first, a display that outgrew its slot is registered again further along
+    for (int i = maxSignalDisplays; --i >= 0;)
+    {
+        SignalDisplay* display = signalSlots[i].load();
 
-            else if (displayType != "waveform" && signalArrays[i]->caption.contains ("fft")){
-                return signalArrays[i];
-            }
+        if (display != nullptr && display->caption.isNotEmpty() && display->caption.contains (variableName))
+        {
+            if (displayType.isEmpty())
+                return display;
+            else if ((displayType == "waveform" || displayType == "lissajous") && !display->isSpectrum)
+                return display;
+            else if (displayType != "waveform" && displayType != "lissajous" && display->isSpectrum)
+                return display;
         }
     }
 
-    return new SignalDisplay ("", -1, 0, 0, 0, 0);
+    return nullptr;
 }
 //==============================================================================
 bool CsoundPluginProcessor::hasEditor() const
@@ -1286,7 +2603,7 @@ int CsoundPluginProcessor::OpenMidiInputDevice (CSOUND* csound, void** userData,
 //==============================================================================
 // Reads MIDI input data from host, gets called every time there is MIDI input to our plugin
 //==============================================================================
-int CsoundPluginProcessor::ReadMidiData (CSOUND* /*csound*/, void* userData,
+int CsoundPluginProcessor::ReadMidiData (CSOUND* csound, void* userData,
                                          unsigned char* mbuf, int nbytes)
 {
     CsoundPluginProcessor* midiData = static_cast<CsoundPluginProcessor*>(userData);
@@ -1297,41 +2614,11 @@ int CsoundPluginProcessor::ReadMidiData (CSOUND* /*csound*/, void* userData,
         return 0;
     }
 
-    int cnt = 0;
-
-    
-    if (!midiData->midiBuffer.isEmpty() && cnt <= (nbytes - 3))
-    {
-        MidiMessage message (0xf4, 0, 0, 0);
-        MidiBuffer::Iterator i (midiData->midiBuffer);
-        int messageFrameRelativeTothisProcess;
-
-        while (i.getNextEvent (message, messageFrameRelativeTothisProcess))
-        {
-            
-            const uint8* data = message.getRawData();
-            *mbuf++ = *data++;
-
-            if(message.isChannelPressure() || message.isProgramChange())
-            {
-                *mbuf++ = *data++;
-                cnt += 2;
-            }
-            else
-            {
-                *mbuf++ = *data++;
-                *mbuf++ = *data++;
-                cnt  += 3;
-            }
-        }
-
-        midiData->midiBuffer.clear();
-        
-    }
-
-    
-    return cnt;
+    //an instance being compiled in the background doesn't get the host's MIDI
+    if (!midiData->isPerformingInstance (csound))
+        return 0;
 
+    return midiData->midiScheduler.read (mbuf, nbytes);
 }
 
 //==============================================================================
@@ -1348,7 +2635,7 @@ int CsoundPluginProcessor::OpenMidiOutputDevice (CSOUND* csound, void** userData
 // Write MIDI data to plugin's MIDI output. Each time Csound outputs a midi message this
 // method should be called. Note: you must have -Q set in your CsOptions
 //==============================================================================
-int CsoundPluginProcessor::WriteMidiData (CSOUND* /*csound*/, void* _userData,
+int CsoundPluginProcessor::WriteMidiData (CSOUND* csound, void* _userData,
                                           const unsigned char* mbuf, int nbytes)
 {
     CsoundPluginProcessor* userData = static_cast<CsoundPluginProcessor*>(_userData);
@@ -1359,6 +2646,9 @@ int CsoundPluginProcessor::WriteMidiData (CSOUND* /*csound*/, void* _userData,
         return 0;
     }
 
+    if (!userData->isPerformingInstance (csound))
+        return nbytes;
+
     MidiMessage message (mbuf, nbytes, 0);
     userData->midiOutputBuffer.addEvent (message, 0);
     return nbytes;
@@ -1371,44 +2661,130 @@ int CsoundPluginProcessor::WriteMidiData (CSOUND* /*csound*/, void* _userData,
 void CsoundPluginProcessor::makeGraphCallback (CSOUND* csound, WINDAT* windat, const char* name)
 {
     CsoundPluginProcessor* ud = static_cast<CsoundPluginProcessor*>(csoundGetHostData (csound));
-    SignalDisplay* display = new SignalDisplay (String (windat->caption), (int)windat->windid, windat->oabsmax, windat->min, windat->max, windat->npts);
 
-    bool addDisplay = true;
+    //ids are ours to hand out, 0 leaves the window undrawn
+    windat->windid = 0;
+
+    if (strstr (windat->caption, "ftable") != nullptr)
+        return;
+
+    const int numPoints = jmin ((int) windat->npts, (int) maxSignalDisplayPoints);
+
+    //a display an earlier instance had for the same window is taken over, unless the message
+    //thread has started releasing it
+    for (int i = maxSignalDisplays; --i >= 0;)
+    {
+        SignalDisplay* display = ud->signalSlots[i].load();
+
+        if (display != nullptr && !display->fromAudioChannel && display->hasCaption (windat->caption) && display->hasRoomFor (numPoints))
+        {
+            CSOUND* previousOwner = display->claimedBy.load();
+
+            if (previousOwner != nullptr && display->claimedBy.compare_exchange_strong (previousOwner, csound))
+            {
+                windat->windid = (uintptr_t) (i + 1);
+                return;
+            }
+        }
+    }
+
+    SignalDisplay* display = nullptr;
+
+    for (auto& spare : ud->spareSignalDisplays)
+        if ((display = spare.exchange (nullptr)) != nullptr)
+            break;
+
+    //the message thread tops the spares up on its next frame, until then the window isn't drawn
+    if (display == nullptr)
+        return;
+
+    display->claim (windat->caption, windat->oabsmax, windat->min, windat->max, numPoints, csound);
 
-    for (int i = 0; i < ud->signalArrays.size(); i++)
+    for (int i = 0; i < maxSignalDisplays; i++)
     {
-        if (ud->signalArrays[i]->caption == windat->caption)
-            addDisplay  = false;
+        SignalDisplay* empty = nullptr;
+        display->windid = i + 1;
+
+        if (ud->signalSlots[i].compare_exchange_strong (empty, display))
+        {
+            windat->windid = (uintptr_t) (i + 1);
+            ++ud->signalArraysVersion;
+            return;
+        }
     }
 
-    if (addDisplay && !String(windat->caption).contains("ftable"))
+    //every slot is taken, so hand the spare back
+    for (auto& spare : ud->spareSignalDisplays)
     {
-        const String captionName = String(windat->caption).substring(String(windat->caption).indexOf("signal ")+7);
-        const int posColon = String(captionName).indexOf(":");
-        const int posComma = String(captionName).indexOf(",");
-        String variableName = "";
-        if(posComma != -1)
-            variableName = captionName.substring(0, posComma);
-        else
-            variableName = captionName.substring(0, posColon);
+        SignalDisplay* empty = nullptr;
 
-        display->variableName = variableName;
-        ud->signalArrays.add (display);
-        ud->updateSignalDisplay.set(variableName, false);
+        if (spare.compare_exchange_strong (empty, display))
+            return;
     }
 }
 
 void CsoundPluginProcessor::drawGraphCallback (CSOUND* csound, WINDAT* windat)
 {
     CsoundPluginProcessor* ud = static_cast<CsoundPluginProcessor*> (csoundGetHostData (csound));
-    Array<float, CriticalSection> tablePoints;
-    //only take all samples if dealing with fft, waveforms and lissajous curves can be drawn with less samples
-    tablePoints = Array<float, CriticalSection> (&windat->fdata[0], windat->npts);
-    ud->getSignalArray (windat->caption)->setPoints (tablePoints);
-    const String test = ud->getSignalArray (windat->caption)->variableName;
-    if(ud->getSignalArray (windat->caption)->variableName.isNotEmpty())
-        ud->updateSignalDisplay.set(ud->getSignalArray (windat->caption)->variableName, true);
-    
+    //displays aren't refreshed while bouncing offline, so skip the copy. Only the performing
+    //instance draws, an instance still being initialised on the reload thread would be a second writer
+    if (ud->isNonRealtime() || !ud->isPerformingInstance (csound))
+        return;
+
+    if (windat->windid == 0)
+        return;
+
+    //our slot is only emptied once this instance has been replaced
+    if (SignalDisplay* display = ud->signalSlots[windat->windid - 1].load())
+        display->publishFrame (windat->fdata, (int) windat->npts);
+}
+
+void CsoundPluginProcessor::refreshSignalDisplays()
+{
+    for (auto& slot : signalSlots)
+        if (SignalDisplay* display = slot.load())
+            if (display->needsAdopting())
+                display->adopt();
+
+    for (auto& spare : spareSignalDisplays)
+    {
+        if (spare.load() == nullptr)
+        {
+            SignalDisplay* display = new SignalDisplay ((int) maxSignalDisplayPoints);
+            signalDisplayStore.add (display);
+            spare = display;
+        }
+    }
+}
+
+void CsoundPluginProcessor::releaseSignalDisplays (CSOUND* keepFor)
+{
+    //anything still looking at the displays released last time has long since finished
+    retiredSignalDisplays.clear();
+    bool released = false;
+
+    //audio channel taps belong to the analyser, which keeps them for the processor's lifetime
+    for (auto& slot : signalSlots)
+    {
+        SignalDisplay* display = slot.load();
+
+        if (display == nullptr || display->fromAudioChannel)
+            continue;
+
+        //the running instance may be taking the display over at the same moment, only one of us wins
+        CSOUND* owner = display->claimedBy.load();
+
+        if (owner != keepFor && display->claimedBy.compare_exchange_strong (owner, nullptr))
+        {
+            slot = nullptr;
+            retiredSignalDisplays.add (display);
+            signalDisplayStore.removeObject (display);
+            released = true;
+        }
+    }
+
+    if (released)
+        ++signalArraysVersion;
 }
 
 void CsoundPluginProcessor::killGraphCallback (CSOUND* csound, WINDAT* windat)
@@ -1421,7 +2797,48 @@ int CsoundPluginProcessor::exitGraphCallback (CSOUND* csound)
     return 0;
 }
 
+//===========================================================================================
+// audio channel analysis...
+//===========================================================================================
+SignalDisplay* CsoundPluginProcessor::addSignalTap (const String& channelName, bool isSpectrum, int updateIntervalMs, float peakHoldSeconds)
+{
+    const String caption = "audiochannel " + channelName + (isSpectrum ? " fft" : "");
+
+    for (auto& slot : signalSlots)
+    {
+        SignalDisplay* display = slot.load();
+
+        if (display != nullptr && display->fromAudioChannel && display->caption == caption)
+            return display;
+    }
+
+    if (!signalAnalyser.canAddTap())
+        return nullptr;
 
+    SignalDisplay::Ptr display = new SignalDisplay (caption, 0, 1.f, -1, 1, SignalAnalyser::numDisplayPoints);
+    //set before it's published, display opcodes skip audio channel taps
+    display->fromAudioChannel = true;
+    bool placed = false;
+
+    for (auto& slot : signalSlots)
+    {
+        SignalDisplay* empty = nullptr;
 
+        if (slot.compare_exchange_strong (empty, display.get()))
+        {
+            placed = true;
+            break;
+        }
+    }
 
+    if (!placed)
+        return nullptr;
 
+    signalDisplayStore.add (display);
+    ++signalArraysVersion;
+    display->variableName = channelName;
+    //the channel name is the user's, so don't go by the caption
+    display->isSpectrum = isSpectrum;
+    signalAnalyser.addTap (channelName, display.get(), updateIntervalMs, peakHoldSeconds, csound != nullptr ? csound->GetCsound() : nullptr);
+    return display.get();
+}
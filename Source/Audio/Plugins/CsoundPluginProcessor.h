@@ -28,9 +28,20 @@
 #include "../../Opcodes/opcodes.hpp"
 #include "../../Utilities/CabbageUtilities.h"
 #include "CabbageCsoundBreakpointData.h"
-#ifdef CabbagePro
-#include "../../Utilities/encrypt.h"
-#endif
+#include "CsdDocument.h"
+#include "TableView.h"
+#include "TableChangeTracker.h"
+#include "MidiEventScheduler.h"
+#include "ChannelPointer.h"
+#include "MatrixEventSequencer.h"
+#include "SmoothedParameter.h"
+#include "ParameterEventQueue.h"
+#include "Oversampler.h"
+#include "GuiRefreshScheduler.h"
+#include "SignalDisplay.h"
+#include "SignalAnalyser.h"
+#include "TableEditor.h"
+#include "PreparedCsound.h"
 
 
 //==============================================================================
@@ -50,14 +61,30 @@ public:
 	bool supportsSidechain = false;
 	bool matchingNumberOfIOChannels = true;
 	void resetCsound();
+
 	//==============================================================================
 	//pass the path to the temp file, along with the path to the original csd file so we can set correct working dir
 	bool setupAndCompileCsound(File csdFile, File filePath, int sr = 44100, bool isMono = false, bool debugMode = false);
+    //compiles a new instance on a worker thread, initialises its channels from cabbageData and
+    //swaps it in between audio blocks. Returns false if a reload is already in progress
+    bool recompileCsoundInBackground (File csdFile, File filePath, ValueTree cabbageData);
+    //times background reloads of csdFile against compiling it in place, one line per result
+    static StringArray benchmarkReload (File csdFile);
+    //renders the same input through the float and double processBlock paths and reports how far
+    //apart the outputs are. Uses a built in effect if csdFile doesn't exist
+    static StringArray checkDoublePrecision (File csdFile);
+    //generates GEN02, GEN05 and GEN07 tables with the table editor and with Csound itself and
+    //reports the largest difference for each, one line per table
+    static StringArray checkTableGenerators();
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
 
 	void performCsoundKsmps();
+    //ksmps used when latency(-1) is requested; the native ksmps if it divides the host block
+    static int getZeroLatencyKsmps (int nativeKsmps, int blockSize);
+    //times the block transfer kernels against a sample-by-sample copy, one line per case
+    static StringArray benchmarkBlockTransfer();
 	int result = -1;
 
 
@@ -65,20 +92,25 @@ public:
 	virtual void processBlock(AudioBuffer< double >&, MidiBuffer&) override;
 	template< typename Type >
 	void processSamples(AudioBuffer< Type >&, MidiBuffer&);
-	//bool supportsDoublePrecisionProcessing() const override { return true; }
+    //runs the performing instance over one block, processSamples() adds swapping and auto sleep
+    template< typename Type >
+    void performBlock (AudioBuffer< Type >& buffer, MidiBuffer& midiMessages);
+    //runs processSamples at the oversampled rate, see oversample()
+    template< typename Type >
+    void processOversampled(AudioBuffer< Type >& buffer, AudioBuffer< Type >& oversampledBuffer, MidiBuffer& midiMessages);
+    //Csound is usually built with MYFLT as double, in which case hosts that can run in
+    //double precision skip the float conversions altogether
+	bool supportsDoublePrecisionProcessing() const override { return sizeof (MYFLT) == sizeof (double); }
 
     virtual void processBlockBypassed (AudioBuffer< float > &buffer, MidiBuffer &midiMessages) override {}
 
-	enum BufferType {
-		inputOutput,
-		output,
-		input
-	};
-
-	template< typename Type >
-	void processCsoundIOBuffers(int bufferType, Type*& buffer, int pos);
+    //block transfer between JUCE's planar buffers and Csound's interleaved spin/spout.
+    //Each call moves one ksmps aligned slice, starting at the current csndIndex. padToKsmps
+    //silences the rest of the k-cycle's input, for a k-cycle that is run before it is full
+    template< typename Type >
+    void writeCsoundInputBlock(const Type* const* channels, int numChannels, int startSample, int numSamples, bool padToKsmps = false);
     template< typename Type >
-    void processCsoundIOSideChainBuffers(int bufferType, Type* buffer, int pos);
+    void readCsoundOutputBlock(Type* const* channels, int numChannels, int startSample, int numSamples);
 
 	int numSideChainChannels = 0;
     //==============================================================================
@@ -133,32 +165,41 @@ public:
 
     int getChnsetGestureMode()
     {
-       return csound->GetChannel("CHNSET_GESTURES");
+       return chnsetGestures != nullptr ? int (chnsetGestures->get()) : 0;
     }
+
+    //auto sleep, see the form's autosleep() identifier
+    bool isAutoSleepEnabled() const { return autoSleepTime > 0; }
+    bool isSleeping() const { return sleeping.load(); }
+    //number of times this instance has gone to sleep
+    int getSleepCount() const { return sleepCount.load(); }
+    //widget updates sent from the orchestra with cabbageSet, null until an instance exists
+    CabbageWidgetMessageQueue* getWidgetMessageQueue() { return widgetMessages.get(); }
     StringArray getTableStatement (int tableNum);
     const Array<float, CriticalSection> getTableFloats (int tableNum);
-    int checkTable (int tableNum);
-    AudioPlayHead::CurrentPositionInfo hostInfo = {};
 
-    class MatrixEventSequencer
-    {
-    public:
-        String channel = "";
-        OwnedArray<StringArray> events;
-        int position = 0;
-        void setEventString(int col, int row, String data)
-        {
-            events[col]->set(row, data);
-        }
-
-        explicit MatrixEventSequencer(String csoundChannel):channel(csoundChannel){}
-        ~MatrixEventSequencer(){ events.clear();}
+    TableView getTableView (int tableNum);
 
-    };
+    int checkTable (int tableNum);
+    AudioPlayHead::CurrentPositionInfo hostInfo = {};
 
-	int numMatrixEventSequencers = 0;
-    void createMatrixEventSequencer(int rows, int cols, String channel);
-    void setMatrixEventSequencerCellData(int row, int col, String channel, String data);
+    //returns a registry owned channel that stays valid for the lifetime of the processor.
+    //Call this from the message thread, never from the audio thread.
+    ChannelPointer* registerChannel (const String& channelName);
+    void registerHostChannels();
+    void resolveChannelPointers();
+
+    //registers a parameter that writes to channel, call from the message thread only
+    //parameters sharing a channel share its smoother, the first one registered sets the ramp
+    SmoothedParameter* registerSmoothedParameter (ChannelPointer* channel, float rampTimeInSeconds, bool exponential);
+    //safe to call from any thread, the value reaches Csound at the next k-boundary
+    void queueParameterChange (SmoothedParameter* parameter, MYFLT value);
+
+    void createMatrixEventSequencer(int cols, int rows, String channel, bool vertical);
+    void setMatrixEventSequencerCellData(int col, int row, String channel, String data);
+    //message thread, looks up the instruments named in sequencer cells in cs
+    void resolveMatrixEventSequencerInstruments (CSOUND* cs, CSOUND* keep);
+    static int lookUpInstrument (CSOUND* cs, const char* name);
     //=============================================================================
     //Implement these to init, send and receive channel data to Csound. Typically used when
     //a component is updated and its value is sent to Csound, or when a Csound channel
@@ -169,9 +210,14 @@ public:
     virtual void sendChannelDataToCsound() {};
     void sendHostDataToCsound();
     virtual void getChannelDataFromCsound() {};
+    //called on the message thread whenever csound points at a new instance, after an in place
+    //compile or a background swap. Anything cached against the old CSOUND* must be dropped here,
+    //a new instance can be allocated at the same address
+    virtual void csoundInstanceChanged() {};
     virtual void initAllCsoundChannels (ValueTree cabbageData);
+    void initCsoundChannels (ValueTree cabbageData, Csound* target, const String& stateData);
     //=============================================================================
-    void addMacros (String csdText);
+    void addMacros (const CsdDocument& document, Csound* target);
     const String getCsoundOutput();
 
     void compileCsdFile (File csoundFile)
@@ -191,6 +237,8 @@ public:
 
 
 
+    //message thread. After a background reload this is still the outgoing instance until
+    //finishCsoundSwap() has seen the audio thread switch over, and it stays alive until then
     Csound* getCsound()
     {
         return csound.get();
@@ -201,60 +249,53 @@ public:
         return csound->GetCsound();
     }
 
+    //legacy guirefresh(), a number of k-cycles. When set it caps the GUI frame rate at kr/rate
     void setGUIRefreshRate (int rate)
     {
         guiRefreshRate = rate;
     }
 
+    //guiframerate(), GUI updates per second. 0 uses the default
+    void setGUIFrameRate (int framesPerSecond)
+    {
+        guiFrameRate = framesPerSecond;
+    }
+
+    const GuiRefreshScheduler::Statistics& getGuiFrameStatistics() const { return guiRefreshScheduler.getStatistics(); }
+
     MidiKeyboardState keyboardState;
     bool hostIsCubase = false;
 
-    //==================================================================================
-    class SignalDisplay
-    {
-    public:
-        float yScale = 0.f;
-        int windid = 0, min = 0, max = 0, size = 0;
-        String caption = {}, variableName = {};
-
-        SignalDisplay (String _caption, int _id, float _scale, int _min, int _max, int _size):
-            yScale (_scale),
-            windid (_id),
-            min (_min),
-            max (_max),
-            size (_size),
-            caption (_caption)
-        {}
-
-        ~SignalDisplay()
-        {
-            points.clear();
-        }
-
-        Array<float, CriticalSection> getPoints()
-        {
-            return points;
-        }
-
-        void setPoints (Array <float, CriticalSection > tablePoints)
-        {
-            points.swapWith (tablePoints);
-        }
-
-    private:
-        Array <float, CriticalSection > points;
-    };
+    //signaldisplays with audiochannel() are fed by the analyser instead of a display opcode
+    SignalDisplay* addSignalTap (const String& channelName, bool isSpectrum, int updateIntervalMs, float peakHoldSeconds);
 
-    bool shouldUpdateSignalDisplay(String signalDisplayName)
-    {
-        bool returnVal = bool(updateSignalDisplay.getWithDefault(signalDisplayName, false));
-        updateSignalDisplay.set(signalDisplayName, false);
-        return returnVal;
-    };
+    TableEditor& getTableEditor()               { return tableEditor; }
 
     OwnedArray<MatrixEventSequencer> matrixEventSequencers;
-    OwnedArray <SignalDisplay, CriticalSection> signalArrays;   //holds values from FFT function table created using dispfft
-    CsoundPluginProcessor::SignalDisplay* getSignalArray (String variableName, String displayType = "");
+    //held by the audio thread while stepping and by the message thread while editing
+    SpinLock matrixEventSequencerLock;
+    //one slot per display window Csound creates, windid holds the slot number + 1. Csound's
+    //threads read and fill the slots with atomic operations only. They fill a slot with one of
+    //the spares, which the message thread allocates and tops up, so a display opcode never
+    //allocates or locks. When an instance is replaced, the slots only it claimed are emptied
+    //and reused by later displays. Displays over maxSignalDisplayPoints show their first points
+    enum { maxSignalDisplays = 64, numSpareSignalDisplays = 8, maxSignalDisplayPoints = 8192 };
+    std::atomic<SignalDisplay*> signalSlots[maxSignalDisplays] = {};
+    std::atomic<SignalDisplay*> spareSignalDisplays[numSpareSignalDisplays] = {};
+    //message thread only. Keeps every display in a slot or a spare alive, and the ones released
+    //at the last swap, in case Csound's thread was still looking at them
+    ReferenceCountedArray<SignalDisplay> signalDisplayStore, retiredSignalDisplays;
+    //message thread, adopts displays Csound has claimed and replaces the spares it took
+    void refreshSignalDisplays();
+    SignalDisplay* getSignalArray (String variableName, String displayType = "");
+    //changes whenever a display is added or released, widgets look their displays up again then
+    int getSignalArraysVersion() const      { return signalArraysVersion.load(); }
+    //declared after the displays it writes to, so it stops first
+    SignalAnalyser signalAnalyser;
+    std::atomic<int> signalArraysVersion { 0 };
+    //message thread, empties the display slots keepFor didn't claim once nothing else can draw to them
+    void releaseSignalDisplays (CSOUND* keepFor);
+    TableEditor tableEditor;
 
     String getInternalState()
     {
@@ -269,16 +310,18 @@ public:
 private:
     //==============================================================================
     MidiBuffer midiOutputBuffer;
-    int guiCycles = 0;
-    int guiRefreshRate = 128;
-    MidiBuffer midiBuffer = {};
+    int guiRefreshRate = 0;
+    int guiFrameRate = 0;
+    void refreshGui();
+    friend class GuiRefreshScheduler;
+    void startGuiRefresh();
+    MidiEventScheduler midiScheduler;
     String csoundOutput = {};
     std::unique_ptr<CSOUND_PARAMS> csoundParams;
-    int csCompileResult = -1;
+    std::atomic<int> csCompileResult { -1 };
     int numCsoundOutputChannels = 0;
     int numCsoundInputChannels = 0;
     int pos = 0;
-    NamedValueSet updateSignalDisplay;
     MYFLT cs_scale = 0.0;
     bool testLogicForMono = true;
     MYFLT *CSspin = nullptr;
@@ -287,12 +330,94 @@ private:
     int csndIndex = 0;
     int csdKsmps = 0;
     File csdFile = {}, csdFilePath = {};
+    //cabbageSet messages from the running instance, declared first so that it outlives it
+    std::unique_ptr<CabbageWidgetMessageQueue> widgetMessages;
+    //owned and used by the message thread
     std::unique_ptr<Csound> csound;
+    //the instance the audio thread performs, switched by swapInPreparedCsound() ahead of csound.
+    //Callbacks check against it so an instance that isn't running yet stays quiet
+    std::atomic<Csound*> performingCsound { nullptr };
+    bool isPerformingInstance (CSOUND* cs) const
+    {
+        Csound* const performing = performingCsound.load();
+        return performing != nullptr && performing->GetCsound() == cs;
+    }
     std::unique_ptr<FileLogger> fileLogger;
     int busIndex = 0;
     bool disableLogging = false;
 	int preferredLatency = 32;
+    OwnedArray<ChannelPointer> channelPointers;
+    enum HostChannels
+    {
+        hostBpm, timeInSeconds, isPlaying, isRecording, hostPpqPos, timeInSamples, timeSigDenom, timeSigNum, numHostChannels
+    };
+    ChannelPointer* hostChannels[numHostChannels] = { nullptr };
+    ChannelPointer* chnsetGestures = nullptr;
+    ChannelPointer* sleepChannel = nullptr;
+    OwnedArray<SmoothedParameter> smoothedParameters;
+    ParameterEventQueue parameterQueue;
+    double controlRate = 0;
+
+    PreparedCsound describeHost (bool isMono);
+    void createCsoundInstance (PreparedCsound& prepared, const CsdDocument& document, int sr, bool isMono, bool debugMode);
+    void applyPreparedSettings (const PreparedCsound& prepared);
+    void swapInPreparedCsound();
+    void finishCsoundSwap();
+    //drops a reload that hasn't been swapped in yet. Returns true if one was dropped
+    bool cancelBackgroundRecompile();
+    //states are advanced by the worker (compiling), the message thread (compiled, done,
+    //retiring) and the audio thread (ready, swapping)
+    enum SwapState
+    {
+        swapIdle, swapCompiling, swapCompiled, swapReady, swapSwapping, swapDone, swapRetiring
+    };
+    std::atomic<int> swapState { swapIdle };
+    //bumped whenever a reload is cancelled, a job that finds it changed throws its instance away
+    std::atomic<int> compileGeneration { 0 };
+    PreparedCsound preparedCsound;
+    void setSleeping (bool shouldSleep);
+    float autoSleepTime = 0;
+    int64 silentSamples = 0;
+    //keys and sustain pedals held down by the host, per MIDI channel. Release tails are left
+    //to the output silence check
+    void trackHeldMidiNotes (const MidiBuffer& midiMessages);
+    bool hasHeldMidiNotes() const;
+    uint8 heldMidiNotes[16][128] = {};
+    bool sustainPedalDown[16] = {};
+    int numHeldMidiNotes = 0;
+    std::atomic<bool> sleeping { false };
+    std::atomic<int> sleepCount { 0 };
+    //oversample(), the factor the running instance was compiled for
+    int oversamplingFactor = 1;
+    //offlineksmps(), and whether the running instance was compiled for an offline render
+    int offlineKsmps = 0;
+    bool compiledForNonRealtime = false;
+    Oversampler oversampler;
+    AudioBuffer<float> oversampledFloat;
+    AudioBuffer<double> oversampledDouble;
+    //the block a reload is swapped in, the input as the host passed it and the outgoing instance's output
+    AudioBuffer<float> crossfadeFloat[2];
+    AudioBuffer<double> crossfadeDouble[2];
+    AudioBuffer<float>* getCrossfadeBuffers (float)     { return crossfadeFloat; }
+    AudioBuffer<double>* getCrossfadeBuffers (double)   { return crossfadeDouble; }
+    MidiBuffer oversampledMidi, oversampledMidiOutput;
+    int hostBlockSize = 0;
+    int nativeKsmps = 32;
+    //k-cycles a latency(-1) instance has cut short because a host block ended part way through
+    //them. The message thread mentions it once per compile
+    std::atomic<int> numCutKCycles { 0 };
+    bool cutKCyclesReported = false;
+    void reportLatency();
+    //sidechain processing gathers its inputs from two buses, one pointer per input channel
+    HeapBlock<const float*> sideChainFloatInputs;
+    HeapBlock<const double*> sideChainDoubleInputs;
+    int sideChainInputCapacity = 0;
+    const float** getSideChainInputs (float)      { return sideChainFloatInputs.get(); }
+    const double** getSideChainInputs (double)    { return sideChainDoubleInputs.get(); }
     String internalStateData = {};
+    GuiRefreshScheduler guiRefreshScheduler { *this };
+    //declared last so a running compile finishes before anything it uses is destroyed
+    ThreadPool recompilePool { 1 };
 
 
 
@@ -0,0 +1,45 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#include "GuiRefreshScheduler.h"
+#include "CsoundPluginProcessor.h"
+
+//==============================================================================
+void GuiRefreshScheduler::start (int framesPerSecond)
+{
+    if (framesPerSecond != stats.frameRate || !isTimerRunning())
+    {
+        stats = Statistics();
+        stats.frameRate = framesPerSecond;
+        startTimerHz (framesPerSecond);
+    }
+}
+
+void GuiRefreshScheduler::runFrame()
+{
+    const double frameStart = Time::getMillisecondCounterHiRes();
+    owner.refreshGui();
+    const double frameMs = Time::getMillisecondCounterHiRes() - frameStart;
+
+    stats.lastFrameMs = frameMs;
+    stats.worstFrameMs = jmax (stats.worstFrameMs, frameMs);
+    //smoothed over roughly the last second at 30fps
+    stats.averageFrameMs = stats.numFrames == 0 ? frameMs : stats.averageFrameMs + (frameMs - stats.averageFrameMs) * 0.03;
+    ++stats.numFrames;
+}
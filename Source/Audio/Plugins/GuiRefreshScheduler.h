@@ -0,0 +1,60 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef GUIREFRESHSCHEDULER_H_INCLUDED
+#define GUIREFRESHSCHEDULER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+class CsoundPluginProcessor;
+
+//==================================================================================
+// Runs GUI updates on the message thread at a fixed frame rate, so their cost follows
+// the display rather than sr/ksmps. Each frame exchanges every pending channel and
+// identchannel change with Csound in one batch, and the time it takes is recorded.
+class GuiRefreshScheduler : private Timer
+{
+public:
+    struct Statistics
+    {
+        int frameRate = 0;
+        int64 numFrames = 0;
+        double lastFrameMs = 0;
+        double averageFrameMs = 0;
+        double worstFrameMs = 0;
+    };
+
+    explicit GuiRefreshScheduler (CsoundPluginProcessor& processor) : owner (processor) {}
+
+    void start (int framesPerSecond);
+
+    void stop() { stopTimer(); }
+
+    void runFrame();
+
+    const Statistics& getStatistics() const { return stats; }
+
+private:
+    void timerCallback() override { runFrame(); }
+
+    CsoundPluginProcessor& owner;
+    Statistics stats;
+};
+
+#endif  // GUIREFRESHSCHEDULER_H_INCLUDED
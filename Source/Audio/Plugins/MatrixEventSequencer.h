@@ -0,0 +1,182 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef MATRIXEVENTSEQUENCER_H_INCLUDED
+#define MATRIXEVENTSEQUENCER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <csound.hpp>
+#include "ChannelPointer.h"
+
+//==================================================================================
+// An eventsequencer grid whose cells are compiled on the message thread, so stepping
+// it from the audio thread needs no Strings or allocation. Plain i and f statements
+// become numeric p-field arrays that are sent with ScoreEvent(). Anything else, such
+// as named instruments or macros, is kept as text for InputMessage(). Cells are
+// indexed [column][row], and the step position is read through a channel pointer.
+class MatrixEventSequencer
+{
+public:
+    enum
+    {
+        maxPFields = 32, maxTextLength = 256, maxNameLength = 64
+    };
+
+    //i statements with a quoted instrument name are sent as score events too. The name is
+    //looked up on the message thread for each instance that can play the cell, the running
+    //one and the one a background recompile is about to swap in
+    struct Cell
+    {
+        enum Kind
+        {
+            empty, scoreEvent, namedEvent, scoreText
+        };
+
+        int kind = empty;
+        char type = 0;
+        int numPFields = 0;
+        MYFLT pFields[maxPFields];
+        char text[maxTextLength];
+        char instrumentName[maxNameLength];
+        CSOUND* resolvedFor[2];
+        int instrumentNumbers[2];
+
+        //message thread, keeps the number resolved for keep if there is one
+        void setInstrumentNumber (CSOUND* cs, int number, CSOUND* keep)
+        {
+            const int slot = resolvedFor[0] == cs ? 0 : resolvedFor[1] == cs ? 1 : resolvedFor[0] == keep ? 1 : 0;
+            resolvedFor[slot] = cs;
+            instrumentNumbers[slot] = number;
+        }
+
+        //0 if the name wasn't found in cs, or hasn't been looked up there yet
+        int getInstrumentNumber (CSOUND* cs) const
+        {
+            return resolvedFor[0] == cs ? instrumentNumbers[0] : resolvedFor[1] == cs ? instrumentNumbers[1] : 0;
+        }
+    };
+
+    MatrixEventSequencer (const String& csoundChannel, ChannelPointer* stepChannel, int columns, int rows, bool isVertical)
+        : channel (csoundChannel), step (stepChannel), numColumns (columns), numRows (rows), vertical (isVertical)
+    {
+        cells.calloc (size_t (jmax (1, numColumns * numRows)));
+    }
+
+    //message thread, the caller holds the processor's sequencer lock while the cell is copied in
+    static void compileCell (Cell& cell, const String& data)
+    {
+        cell.kind = Cell::empty;
+        const String statement = data.trim();
+
+        if (statement.isEmpty())
+            return;
+
+        StringArray tokens;
+        tokens.addTokens (statement, " \t", "\"");
+        tokens.removeEmptyStrings();
+
+        const juce_wchar type = tokens[0][0];
+        tokens.set (0, tokens[0].substring (1));
+        tokens.removeEmptyStrings();
+
+        const String name = tokens[0].isQuotedString() ? tokens[0].unquoted() : String();
+        const bool isNamed = type == 'i' && name.isNotEmpty() && name.containsOnly ("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_")
+                             && name.getNumBytesAsUTF8() < maxNameLength;
+
+        bool isNumeric = (type == 'i' || type == 'f') && tokens.size() <= maxPFields
+                         && !statement.containsAnyOf ("\n;[]$") && (isNamed || !statement.containsChar ('"'));
+
+        for (int i = isNamed ? 1 : 0; i < tokens.size() && isNumeric; i++)
+        {
+            isNumeric = tokens[i].containsOnly ("0123456789.-+eE");
+            cell.pFields[i] = (MYFLT) tokens[i].getDoubleValue();
+        }
+
+        if (isNumeric)
+        {
+            cell.kind = isNamed ? Cell::namedEvent : Cell::scoreEvent;
+            cell.type = (char) type;
+            cell.numPFields = tokens.size();
+
+            if (isNamed)
+            {
+                name.copyToUTF8 (cell.instrumentName, maxNameLength);
+                cell.resolvedFor[0] = cell.resolvedFor[1] = nullptr;
+                cell.pFields[0] = 0;
+            }
+        }
+        else if (statement.getNumBytesAsUTF8() < maxTextLength)
+        {
+            cell.kind = Cell::scoreText;
+            statement.copyToUTF8 (cell.text, maxTextLength);
+        }
+    }
+
+    Cell* getCell (int col, int row)
+    {
+        return isPositiveAndBelow (col, numColumns) && isPositiveAndBelow (row, numRows) ? cells + (col * numRows + row) : nullptr;
+    }
+
+    int getNumCells() const             { return numColumns * numRows; }
+    Cell& getCellAtIndex (int index)    { return cells[index]; }
+
+    //audio thread, fires the cells of the current step whenever the step channel changes
+    void dispatch (Csound& cs)
+    {
+        const int newPosition = int (step->get());
+
+        if (newPosition == position)
+            return;
+
+        position = newPosition;
+
+        for (int i = 0; i < (vertical ? numColumns : numRows); i++)
+        {
+            if (Cell* cell = vertical ? getCell (i, position) : getCell (position, i))
+            {
+                if (cell->kind == Cell::scoreEvent)
+                    cs.ScoreEvent (cell->type, cell->pFields, cell->numPFields);
+                else if (cell->kind == Cell::namedEvent)
+                {
+                    //a name this instance doesn't know was reported when it was looked up
+                    if (const int instrument = cell->getInstrumentNumber (cs.GetCsound()))
+                    {
+                        cell->pFields[0] = (MYFLT) instrument;
+                        cs.ScoreEvent (cell->type, cell->pFields, cell->numPFields);
+                    }
+                }
+                else if (cell->kind == Cell::scoreText)
+                    cs.InputMessage (cell->text);
+            }
+        }
+    }
+
+    const String channel;
+    //message thread, so each kind of problem cell is only reported once per grid
+    bool reportedTextCells = false, reportedLongCells = false;
+
+private:
+    ChannelPointer* const step;
+    const int numColumns, numRows;
+    const bool vertical;
+    int position = 0;
+    HeapBlock<Cell> cells;
+};
+
+#endif  // MATRIXEVENTSEQUENCER_H_INCLUDED
@@ -0,0 +1,133 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef MIDIEVENTSCHEDULER_H_INCLUDED
+#define MIDIEVENTSCHEDULER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//==================================================================================
+// Hands host MIDI over to Csound at ksmps boundaries. processSamples() walks the host
+// buffer once per block with a single iterator, and each slice's events are copied,
+// length prefixed, into a preallocated byte ring that ReadMidiData() drains. Nothing
+// in here allocates, so it is safe to use from the audio thread.
+class MidiEventScheduler
+{
+public:
+    MidiEventScheduler()
+    {
+        ring.calloc (ringSize);
+    }
+
+    void beginBlock()
+    {
+        pendingData = nullptr;
+    }
+
+    void clear()
+    {
+        pendingData = nullptr;
+        readPos = writePos = numBytesStored = 0;
+    }
+
+    //queue every event from the iterator whose time stamp falls before endSample
+    void scheduleUpTo (MidiBuffer::Iterator& iter, int endSample)
+    {
+        for (;;)
+        {
+            if (pendingData == nullptr && ! iter.getNextEvent (pendingData, pendingSize, pendingPosition))
+            {
+                pendingData = nullptr;
+                return;
+            }
+
+            if (pendingPosition >= endSample)
+                return;
+
+            push (pendingData, pendingSize);
+            pendingData = nullptr;
+        }
+    }
+
+    //copy as many whole messages as will fit into dest, returns the number of bytes written
+    int read (unsigned char* dest, int maxBytes)
+    {
+        int bytesWritten = 0;
+
+        while (numBytesStored > 0)
+        {
+            const int messageSize = ring[readPos];
+
+            if (messageSize > maxBytes - bytesWritten)
+            {
+                //a message that can never fit would block the queue, so drop it
+                if (messageSize > maxBytes)
+                    advance (messageSize + 1);
+                else
+                    break;
+            }
+            else
+            {
+                for (int i = 1; i <= messageSize; i++)
+                    dest[bytesWritten++] = ring[(readPos + i) & ringMask];
+
+                advance (messageSize + 1);
+            }
+        }
+
+        return bytesWritten;
+    }
+
+    bool isEmpty() const
+    {
+        return numBytesStored == 0;
+    }
+
+private:
+    static constexpr int ringSize = 1 << 16;
+    static constexpr int ringMask = ringSize - 1;
+
+    void push (const uint8* data, int numBytes)
+    {
+        //drop rather than allocate if the orchestra is not keeping up
+        if (numBytes <= 0 || numBytes > 255 || numBytesStored + numBytes + 1 > ringSize)
+            return;
+
+        ring[writePos] = (uint8) numBytes;
+
+        for (int i = 0; i < numBytes; i++)
+            ring[(writePos + 1 + i) & ringMask] = data[i];
+
+        writePos = (writePos + numBytes + 1) & ringMask;
+        numBytesStored += numBytes + 1;
+    }
+
+    void advance (int numBytes)
+    {
+        readPos = (readPos + numBytes) & ringMask;
+        numBytesStored -= numBytes;
+    }
+
+    HeapBlock<uint8> ring;
+    int readPos = 0, writePos = 0, numBytesStored = 0;
+    const uint8* pendingData = nullptr;
+    int pendingSize = 0, pendingPosition = 0;
+};
+
+#endif  // MIDIEVENTSCHEDULER_H_INCLUDED
@@ -0,0 +1,198 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef OVERSAMPLER_H_INCLUDED
+#define OVERSAMPLER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//=============================================================================
+//Cascaded 2x polyphase half-band FIR stages for the form's oversample() identifier.
+//Every other tap of a half-band filter is zero, so each phase only runs the taps it
+//needs. The first stage does the real anti-aliasing work, later ones can be shorter
+//as the signal is already band limited by then. Call prepare() off the audio thread.
+class Oversampler
+{
+public:
+    void prepare (int newFactor, int numChannels, int maxBlockSize)
+    {
+        factor = (newFactor == 2 || newFactor == 4 || newFactor == 8) ? newFactor : 1;
+        stages.clear();
+
+        for (int rate = 1; rate < factor; rate *= 2)
+            stages.add (new Stage (rate == 1 ? 16 : 8, numChannels, maxBlockSize * rate));
+
+        scratchA.allocate (size_t (maxBlockSize * factor), true);
+        scratchB.allocate (size_t (maxBlockSize * factor), true);
+    }
+
+    void reset()
+    {
+        for (auto* stage : stages)
+            stage->reset();
+    }
+
+    int getFactor() const { return factor; }
+
+    //round trip delay at the host rate
+    int getLatencyInSamples() const
+    {
+        int latency = 0, rate = 1;
+        for (auto* stage : stages)
+        {
+            latency += 2 * stage->halfLength / rate;
+            rate *= 2;
+        }
+        return latency;
+    }
+
+    template< typename Type >
+    void upsample (const Type* input, Type* output, int channel, int numSamples)
+    {
+        double* in = scratchA.getData();
+        double* out = scratchB.getData();
+
+        for (int i = 0; i < numSamples; ++i)
+            in[i] = double (input[i]);
+
+        for (auto* stage : stages)
+        {
+            stage->upsample (channel, in, out, numSamples);
+            std::swap (in, out);
+            numSamples *= 2;
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+            output[i] = Type (in[i]);
+    }
+
+    //numSamples is the number of samples at the host rate
+    template< typename Type >
+    void downsample (const Type* input, Type* output, int channel, int numSamples)
+    {
+        double* in = scratchA.getData();
+        double* out = scratchB.getData();
+        int numInputSamples = numSamples * factor;
+
+        for (int i = 0; i < numInputSamples; ++i)
+            in[i] = double (input[i]);
+
+        for (int i = stages.size(); --i >= 0;)
+        {
+            numInputSamples /= 2;
+            stages[i]->downsample (channel, in, out, numInputSamples);
+            std::swap (in, out);
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+            output[i] = Type (in[i]);
+    }
+
+private:
+    struct Stage
+    {
+        Stage (int halfLengthToUse, int numChannelsToUse, int maxInputSize)
+            : halfLength (halfLengthToUse), numTaps (2 * halfLengthToUse),
+              upStride (numTaps - 1 + maxInputSize), downStride (2 * numTaps - 1 + 2 * maxInputSize)
+        {
+            //Blackman-Harris windowed sinc, only the odd taps either side of the centre
+            //are stored, the centre tap is 0.5 and every other even tap is zero
+            coefficients.allocate (size_t (numTaps), true);
+            const double pi = MathConstants<double>::pi;
+            const int length = 2 * numTaps;
+            double sum = 0;
+
+            for (int k = 0; k < numTaps; ++k)
+            {
+                const int t = 2 * k + 1 - numTaps;
+                const double x = double (t + numTaps) / length;
+                const double window = 0.35875 - 0.48829 * std::cos (2 * pi * x)
+                                      + 0.14128 * std::cos (4 * pi * x) - 0.01168 * std::cos (6 * pi * x);
+                coefficients[k] = std::sin (pi * t / 2) / (pi * t) * window;
+                sum += coefficients[k];
+            }
+
+            for (int k = 0; k < numTaps; ++k)
+                coefficients[k] *= 0.5 / sum;
+
+            upHistory.allocate (size_t (upStride * numChannelsToUse), true);
+            downHistory.allocate (size_t (downStride * numChannelsToUse), true);
+            numChannels = numChannelsToUse;
+        }
+
+        void reset()
+        {
+            upHistory.clear (size_t (upStride * numChannels));
+            downHistory.clear (size_t (downStride * numChannels));
+        }
+
+        //numSamples in, 2 * numSamples out
+        void upsample (int channel, const double* input, double* output, int numSamples)
+        {
+            const int history = numTaps - 1;
+            double* x = upHistory + channel * upStride;
+            memcpy (x + history, input, sizeof (double) * size_t (numSamples));
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                const double* current = x + history + n;
+                double sum = 0;
+
+                for (int k = 0; k < numTaps; ++k)
+                    sum += coefficients[k] * current[-k];
+
+                output[2 * n] = current[-halfLength];
+                output[2 * n + 1] = 2.0 * sum;
+            }
+
+            memmove (x, x + numSamples, sizeof (double) * size_t (history));
+        }
+
+        //2 * numSamples in, numSamples out
+        void downsample (int channel, const double* input, double* output, int numSamples)
+        {
+            const int history = 2 * numTaps - 1;
+            double* z = downHistory + channel * downStride;
+            memcpy (z + history, input, sizeof (double) * size_t (2 * numSamples));
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                const double* current = z + history + 2 * n;
+                double sum = 0.5 * current[-numTaps];
+
+                for (int k = 0; k < numTaps; ++k)
+                    sum += coefficients[k] * current[-2 * k - 1];
+
+                output[n] = sum;
+            }
+
+            memmove (z, z + 2 * numSamples, sizeof (double) * size_t (history));
+        }
+
+        const int halfLength, numTaps, upStride, downStride;
+        int numChannels = 0;
+        HeapBlock<double> coefficients, upHistory, downHistory;
+    };
+
+    int factor = 1;
+    OwnedArray<Stage> stages;
+    HeapBlock<double> scratchA, scratchB;
+};
+
+#endif  // OVERSAMPLER_H_INCLUDED
@@ -0,0 +1,227 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef PARAMETEREVENTQUEUE_H_INCLUDED
+#define PARAMETEREVENTQUEUE_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <csound.hpp>
+#include "SmoothedParameter.h"
+
+//=============================================================================
+//Parameter changes from the host or the editor are queued here and applied by the
+//audio thread at the k-cycle they were stamped for. Hosts call setValue() from the
+//audio thread for automation, from the message thread when the editor moves a
+//control, and some from a thread of their own, so each writer thread claims a lane
+//of its own on its first write. Every lane has one producer and one consumer, and
+//neither side takes a lock or waits. Once all lanes are taken, or a lane is full,
+//push() returns false and the caller writes the channel directly.
+//
+//Writes can't be timed exactly, so they are placed one block late. A write that
+//arrives a quarter of the way through the time it takes to play a block is applied
+//a quarter of the way into the next block. Writes made on the audio thread happen
+//between blocks and apply from the start of the next one. The lanes are merged in
+//timestamp order, and a lane's own timestamps never go backwards.
+class ParameterEventQueue
+{
+public:
+    ParameterEventQueue()
+    {
+        for (int i = 0; i < numLanes; i++)
+            lanes.add (new Lane());
+    }
+
+    bool push (SmoothedParameter* parameter, MYFLT value)
+    {
+        Lane* lane = getLaneForThisThread();
+
+        if (lane == nullptr)
+            return false;
+
+        int start1, size1, start2, size2;
+        lane->fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 + size2 < 1)
+            return false;
+
+        lane->lastTimestamp = jmax (lane->lastTimestamp, getTimestamp());
+        lane->events[size1 > 0 ? start1 : start2] = { parameter, value, lane->lastTimestamp };
+        lane->fifo.finishedWrite (1);
+        return true;
+    }
+
+    //audio thread, once per block before any k-cycle is run
+    void beginBlock (int numSamples, double sampleRate)
+    {
+        blockStart += blockSize;
+        blockSize = numSamples;
+        audioThread = Thread::getCurrentThreadId();
+
+        const int next = 1 - currentTiming.load();
+        timings[next] = { blockStart, blockSize, Time::getHighResolutionTicks(), sampleRate / Time::getHighResolutionTicksPerSecond() };
+        currentTiming = next;
+    }
+
+    //audio thread. The next call to process() applies events stamped before endSample,
+    //a position in the current block
+    void scheduleUpTo (int endSample)
+    {
+        applyBefore = blockStart + endSample;
+    }
+
+    //audio thread, once per k-cycle
+    void process (double kr)
+    {
+        for (;;)
+        {
+            Lane* earliest = nullptr;
+            const Event* earliestEvent = nullptr;
+
+            for (auto* lane : lanes)
+            {
+                if (const Event* event = lane->peek())
+                {
+                    if (event->timestamp < applyBefore && (earliestEvent == nullptr || event->timestamp < earliestEvent->timestamp))
+                    {
+                        earliest = lane;
+                        earliestEvent = event;
+                    }
+                }
+            }
+
+            if (earliest == nullptr)
+                break;
+
+            dispatch (*earliestEvent, kr);
+            earliest->fifo.finishedRead (1);
+        }
+
+        SmoothedParameter** link = &activeRamps;
+        while (*link != nullptr)
+        {
+            SmoothedParameter* parameter = *link;
+            parameter->advance();
+
+            if (parameter->isRamping())
+                link = &parameter->nextActive;
+            else
+            {
+                *link = parameter->nextActive;
+                parameter->isActive = false;
+                parameter->nextActive = nullptr;
+            }
+        }
+    }
+
+private:
+    struct Event
+    {
+        SmoothedParameter* parameter;
+        MYFLT value;
+        int64 timestamp;
+    };
+
+    enum { numLanes = 16, laneSize = 256 };
+
+    struct Lane
+    {
+        Lane() : fifo (laneSize) {}
+
+        //the event at the front of the lane, if there is one
+        const Event* peek() const
+        {
+            int start1, size1, start2, size2;
+            fifo.prepareToRead (1, start1, size1, start2, size2);
+
+            if (size1 + size2 < 1)
+                return nullptr;
+
+            return &events[size1 > 0 ? start1 : start2];
+        }
+
+        std::atomic<Thread::ThreadID> owner { nullptr };
+        AbstractFifo fifo;
+        Event events[laneSize];
+        int64 lastTimestamp = 0;   //written by the owner only
+    };
+
+    //a block's position and when it started, for writers to place their events by
+    struct Timing
+    {
+        int64 blockStart;
+        int blockSize;
+        int64 startTicks;
+        double samplesPerTick;
+    };
+
+    Lane* getLaneForThisThread()
+    {
+        const Thread::ThreadID thisThread = Thread::getCurrentThreadId();
+
+        for (auto* lane : lanes)
+            if (lane->owner.load() == thisThread)
+                return lane;
+
+        for (auto* lane : lanes)
+        {
+            Thread::ThreadID unclaimed = nullptr;
+
+            if (lane->owner.compare_exchange_strong (unclaimed, thisThread))
+                return lane;
+        }
+
+        return nullptr;
+    }
+
+    //the position in the next block that matches how far the current block's playing
+    //time has got. A timing being rewritten while it is read only moves the event
+    //within that block
+    int64 getTimestamp() const
+    {
+        const Timing& timing = timings[currentTiming.load()];
+        const int64 nextBlockStart = timing.blockStart + timing.blockSize;
+
+        if (Thread::getCurrentThreadId() == audioThread.load() || timing.blockSize <= 0)
+            return nextBlockStart;
+
+        const int64 elapsed = int64 ((Time::getHighResolutionTicks() - timing.startTicks) * timing.samplesPerTick);
+        return nextBlockStart + jlimit (int64 (0), int64 (timing.blockSize - 1), elapsed);
+    }
+
+    void dispatch (const Event& event, double kr)
+    {
+        if (event.parameter->setTarget (event.value, kr) && !event.parameter->isActive)
+        {
+            event.parameter->isActive = true;
+            event.parameter->nextActive = activeRamps;
+            activeRamps = event.parameter;
+        }
+    }
+
+    OwnedArray<Lane> lanes;
+    Timing timings[2] = { { 0, 0, 0, 0.0 }, { 0, 0, 0, 0.0 } };
+    std::atomic<int> currentTiming { 0 };
+    std::atomic<Thread::ThreadID> audioThread { nullptr };
+    //audio thread only
+    int64 blockStart = 0, applyBefore = 0;
+    int blockSize = 0;
+    SmoothedParameter* activeRamps = nullptr;
+};
+
+#endif  // PARAMETEREVENTQUEUE_H_INCLUDED
@@ -0,0 +1,62 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef PREPAREDCSOUND_H_INCLUDED
+#define PREPAREDCSOUND_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <csound.hpp>
+#include "../../Opcodes/opcodes.hpp"
+#include "ChannelPointer.h"
+
+//==============================================================================
+//a compiled instance and the values the audio thread caches from it. Nothing outside
+//it is written while an instance is built, the settings are applied when it is swapped in
+struct PreparedCsound
+{
+    //each instance pushes to its own queue, so there is only ever one producer
+    std::unique_ptr<CabbageWidgetMessageQueue> widgetMessages;
+    std::unique_ptr<Csound> csound;
+    std::unique_ptr<CSOUND_PARAMS> params;
+    int compileResult = -1;
+    MYFLT* spin = nullptr;
+    MYFLT* spout = nullptr;
+    MYFLT scale = 1;
+    int ksmps = 0;
+    double kr = 0;
+    int oversampling = 1;
+    bool nonRealtime = false;
+    //host state, taken on the thread that asked for the compile
+    int hostBlockSize = 0;
+    String stateData;
+    //settings for the processor, from the form and the host's bus layout
+    float autoSleepTime = 0;
+    int offlineKsmps = 0;
+    int preferredLatency = 32;
+    int numOutputChannels = 0;
+    int numInputChannels = 0;
+    int numSideChainChannels = 0;
+    bool matchingNumberOfIOChannels = true;
+    bool monoSideChain = false;
+    int nativeKsmps = 32;
+    //channels looked up in the new instance, committed by the audio thread with the swap
+    Array<ChannelPointer*> preparedChannels;
+};
+
+#endif  // PREPAREDCSOUND_H_INCLUDED
@@ -0,0 +1,259 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#include "SignalAnalyser.h"
+
+//==============================================================================
+SignalAnalyser::SignalAnalyser() : Thread ("Cabbage signal analysis")
+{
+    //taps are only ever appended, so with their storage reserved other threads can walk them without a lock
+    taps.ensureStorageAllocated (maxTaps);
+}
+
+SignalAnalyser::~SignalAnalyser()
+{
+    stopThread (1000);
+}
+
+void SignalAnalyser::addTap (const String& channelName, SignalDisplay* display, int updateIntervalMs, float peakHoldSeconds, CSOUND* cs)
+{
+    jassert (canAddTap());
+
+    Tap* tap = taps.add (new Tap (channelName, display, updateIntervalMs, peakHoldSeconds));
+    tap->resolve (cs);
+    numActiveTaps = taps.size();
+
+    if (!isThreadRunning())
+        startThread (3);
+}
+
+void SignalAnalyser::resolve (CSOUND* cs)
+{
+    for (auto* tap : taps)
+        tap->resolve (cs);
+}
+
+void SignalAnalyser::run()
+{
+    while (!threadShouldExit())
+    {
+        const double now = Time::getMillisecondCounterHiRes();
+        const int numTapsToServe = numActiveTaps.load();
+
+        for (int i = 0; i < numTapsToServe; i++)
+        {
+            Tap* tap = taps.getUnchecked (i);
+            tap->drain();
+
+            if (now >= tap->nextFrameTime)
+            {
+                tap->analyse ((now - tap->lastFrameTime) * 0.001);
+                tap->lastFrameTime = now;
+                tap->nextFrameTime = now + tap->intervalMs;
+            }
+        }
+
+        //the rings are emptied more often than frames are made, so they can stay small
+        wait (10);
+    }
+}
+
+//in-place radix-2 transform, size must be a power of two
+void SignalAnalyser::performFFT (float* real, float* imag, int size) noexcept
+{
+    for (int i = 1, j = 0; i < size; i++)
+    {
+        int bit = size >> 1;
+
+        for (; (j & bit) != 0; bit >>= 1)
+            j ^= bit;
+
+        j ^= bit;
+
+        if (i < j)
+        {
+            std::swap (real[i], real[j]);
+            std::swap (imag[i], imag[j]);
+        }
+    }
+
+    for (int length = 2; length <= size; length <<= 1)
+    {
+        const int half = length / 2;
+        const double angle = -MathConstants<double>::twoPi / length;
+        const double stepReal = std::cos (angle), stepImag = std::sin (angle);
+
+        for (int start = 0; start < size; start += length)
+        {
+            double twiddleReal = 1.0, twiddleImag = 0.0;
+
+            for (int k = 0; k < half; k++)
+            {
+                const int a = start + k, b = a + half;
+                const float productReal = float (real[b] * twiddleReal - imag[b] * twiddleImag);
+                const float productImag = float (real[b] * twiddleImag + imag[b] * twiddleReal);
+
+                real[b] = real[a] - productReal;
+                imag[b] = imag[a] - productImag;
+                real[a] += productReal;
+                imag[a] += productImag;
+
+                const double nextReal = twiddleReal * stepReal - twiddleImag * stepImag;
+                twiddleImag = twiddleReal * stepImag + twiddleImag * stepReal;
+                twiddleReal = nextReal;
+            }
+        }
+    }
+}
+
+//==============================================================================
+SignalAnalyser::Tap::Tap (const String& channelName, SignalDisplay* target, int updateIntervalMs, float holdSeconds)
+    : channel (channelName),
+      display (target),
+      frameSize (target->isSpectrum ? numDisplayPoints * 2 : numDisplayPoints * 4),
+      intervalMs (jmax (10, updateIntervalMs)),
+      peakHoldSeconds (holdSeconds),
+      fifo (8192),
+      ring (8192, true),
+      history (frameSize, true),
+      window (frameSize),
+      real (frameSize, true),
+      imag (frameSize, true),
+      output (numDisplayPoints, true),
+      heldValues (numDisplayPoints, true),
+      heldAges (numDisplayPoints, true)
+{
+    //Hann window, with the 4/N folded in so that a full scale sine reads as 1
+    for (int i = 0; i < frameSize; i++)
+        window[i] = float ((0.5 - 0.5 * std::cos (MathConstants<double>::twoPi * i / frameSize)) * 4.0 / frameSize);
+}
+
+void SignalAnalyser::Tap::resolve (CSOUND* cs)
+{
+    MYFLT* data = nullptr;
+
+    if (cs == nullptr || csoundGetChannelPtr (cs, &data, channel.toUTF8().getAddress(), CSOUND_AUDIO_CHANNEL | CSOUND_OUTPUT_CHANNEL) != 0)
+        data = nullptr;
+
+    gain = cs != nullptr ? float (1.0 / csoundGet0dBFS (cs)) : 1.f;
+    samples = data;
+}
+
+void SignalAnalyser::Tap::push (int numSamples) noexcept
+{
+    const MYFLT* source = samples.load();
+
+    if (source == nullptr)
+        return;
+
+    //if the analysis thread ever falls this far behind, samples are dropped until it catches up
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+    const float scale = gain.load();
+
+    for (int i = 0; i < size1; i++)
+        ring[start1 + i] = float (source[i]) * scale;
+
+    for (int i = 0; i < size2; i++)
+        ring[start2 + i] = float (source[size1 + i]) * scale;
+
+    fifo.finishedWrite (size1 + size2);
+}
+
+void SignalAnalyser::Tap::drain()
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1 + size2; i++)
+    {
+        history[historyPosition] = i < size1 ? ring[start1 + i] : ring[start2 + i - size1];
+        historyPosition = (historyPosition + 1) % frameSize;
+    }
+
+    fifo.finishedRead (size1 + size2);
+}
+
+void SignalAnalyser::Tap::analyse (double secondsSinceLastFrame)
+{
+    //oldest sample first
+    for (int i = 0; i < frameSize; i++)
+        real[i] = history[(historyPosition + i) % frameSize];
+
+    if (display->isSpectrum)
+        analyseSpectrum (secondsSinceLastFrame);
+    else
+        analyseWaveform();
+}
+
+void SignalAnalyser::Tap::analyseSpectrum (double secondsSinceLastFrame)
+{
+    for (int i = 0; i < frameSize; i++)
+    {
+        real[i] *= window[i];
+        imag[i] = 0;
+    }
+
+    performFFT (real, imag, frameSize);
+
+    for (int bin = 0; bin < numDisplayPoints; bin++)
+    {
+        const float magnitude = std::sqrt (real[bin] * real[bin] + imag[bin] * imag[bin]);
+
+        if (peakHoldSeconds > 0)
+        {
+            //a peak stays up for the hold time unless something louder comes along
+            heldAges[bin] += float (secondsSinceLastFrame);
+
+            if (magnitude >= heldValues[bin] || heldAges[bin] > peakHoldSeconds)
+            {
+                heldValues[bin] = magnitude;
+                heldAges[bin] = 0;
+            }
+
+            output[bin] = heldValues[bin];
+        }
+        else
+            output[bin] = magnitude;
+    }
+
+    display->publishFrame (output.getData(), numDisplayPoints);
+}
+
+void SignalAnalyser::Tap::analyseWaveform()
+{
+    //each point keeps the sample furthest from zero in its stretch, so peaks survive the decimation
+    const int decimation = frameSize / numDisplayPoints;
+
+    for (int point = 0; point < numDisplayPoints; point++)
+    {
+        const float* stretch = real + point * decimation;
+        float peak = stretch[0];
+
+        for (int i = 1; i < decimation; i++)
+        {
+            if (std::abs (stretch[i]) > std::abs (peak))
+                peak = stretch[i];
+        }
+
+        output[point] = peak;
+    }
+
+    display->publishFrame (output.getData(), numDisplayPoints);
+}
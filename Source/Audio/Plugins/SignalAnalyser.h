@@ -0,0 +1,89 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef SIGNALANALYSER_H_INCLUDED
+#define SIGNALANALYSER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <csound.hpp>
+#include "SignalDisplay.h"
+
+//==================================================================================
+// Analysis for signaldisplay widgets that watch a Csound audio channel through
+// audiochannel() rather than a display opcode. Csound's thread only copies each
+// k-cycle of the channel into a ring buffer. A background thread drains the rings and,
+// at each display's update rate, windows and transforms the newest samples for spectra
+// or decimates them for scopes. Results go out through a SignalDisplay, the same way
+// display and dispfft frames do.
+class SignalAnalyser : private Thread
+{
+public:
+    enum { maxTaps = 16, numDisplayPoints = 512 };
+
+    SignalAnalyser();
+    ~SignalAnalyser();
+
+    //message thread. The display has to outlive the analyser
+    bool canAddTap() const                      { return taps.size() < maxTaps; }
+    void addTap (const String& channelName, SignalDisplay* display, int updateIntervalMs, float peakHoldSeconds, CSOUND* cs);
+    void resolve (CSOUND* cs);
+
+    //Csound's thread, once per k-cycle
+    void pushSamples (int numSamples) noexcept
+    {
+        const int numTapsToFill = numActiveTaps.load();
+
+        for (int i = 0; i < numTapsToFill; i++)
+            taps.getUnchecked (i)->push (numSamples);
+    }
+
+private:
+    struct Tap
+    {
+        Tap (const String& channelName, SignalDisplay* target, int updateIntervalMs, float peakHoldSeconds);
+
+        void resolve (CSOUND* cs);
+        void push (int numSamples) noexcept;
+        void drain();
+        void analyse (double secondsSinceLastFrame);
+        void analyseSpectrum (double secondsSinceLastFrame);
+        void analyseWaveform();
+
+        const String channel;
+        SignalDisplay* const display;
+        const int frameSize, intervalMs;
+        const float peakHoldSeconds;
+        std::atomic<MYFLT*> samples { nullptr };
+        std::atomic<float> gain { 1.f };
+        AbstractFifo fifo;
+        HeapBlock<float> ring, history, window, real, imag, output, heldValues, heldAges;
+        int historyPosition = 0;
+        double nextFrameTime = 0, lastFrameTime = 0;
+    };
+
+    void run() override;
+    static void performFFT (float* real, float* imag, int size) noexcept;
+
+    OwnedArray<Tap> taps;
+    std::atomic<int> numActiveTaps { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (SignalAnalyser)
+};
+
+#endif  // SIGNALANALYSER_H_INCLUDED
@@ -0,0 +1,143 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef SIGNALDISPLAY_H_INCLUDED
+#define SIGNALDISPLAY_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <csound.hpp>
+
+//==================================================================================
+// Frames from one display opcode, or from an audio channel the SignalAnalyser watches.
+// The thread producing them writes each frame into a preallocated triple buffer and
+// hands it over with a single exchange, the message thread picks up the newest
+// complete one the same way, so neither side locks or allocates. Widgets hold a
+// reference, so a display released by the processor stays valid until they look again.
+// Displays for Csound's display opcodes are allocated ahead on the message thread and
+// claimed by Csound's thread, which only copies the window's caption and layout in.
+class SignalDisplay : public ReferenceCountedObject
+{
+public:
+    using Ptr = ReferenceCountedObjectPtr<SignalDisplay>;
+    enum { maxCaptionLength = 256 };
+
+    struct Frame
+    {
+        const float* data = nullptr;
+        int size = 0;
+        int number = 0;     //0 until Csound has drawn something
+
+        float operator[] (int index) const noexcept     { return isPositiveAndBelow (index, size) ? data[index] : 0.f; }
+    };
+
+    float yScale = 0.f;
+    int windid = 0, min = 0, max = 0, size = 0;
+    //message thread only, filled in by adopt() for displays Csound's thread claimed
+    String caption = {}, variableName = {};
+    bool isSpectrum = false;
+    bool fromAudioChannel = false;
+    //the last instance whose display opcode was given this slot, null once released
+    std::atomic<CSOUND*> claimedBy { nullptr };
+
+    SignalDisplay (String _caption, int _id, float _scale, int _min, int _max, int _size):
+        yScale (_scale),
+        windid (_id),
+        min (_min),
+        max (_max),
+        size (_size),
+        caption (_caption),
+        isSpectrum (_caption.contains ("fft")),
+        capacity (jmax (1, _size)),
+        points ((size_t) (3 * capacity), true)
+    {
+        _caption.copyToUTF8 (captionText, maxCaptionLength);
+    }
+
+    //a spare for a display opcode to claim, with room for capacityToUse points
+    explicit SignalDisplay (int capacityToUse):
+        capacity (jmax (1, capacityToUse)),
+        points ((size_t) (3 * capacity), true)
+    {}
+
+    //Csound's thread, before the display is published in a slot. Windows with more
+    //points than the display has room for show the first ones
+    void claim (const char* windowCaption, float scale, int minimum, int maximum, int numPoints, CSOUND* cs) noexcept
+    {
+        strncpy (captionText, windowCaption, maxCaptionLength - 1);
+        captionText[maxCaptionLength - 1] = 0;
+        yScale = scale;
+        min = minimum;
+        max = maximum;
+        size = jmin (numPoints, capacity);
+        claimedBy = cs;
+    }
+
+    bool hasCaption (const char* windowCaption) const noexcept    { return strncmp (captionText, windowCaption, maxCaptionLength - 1) == 0; }
+    bool hasRoomFor (int numPoints) const noexcept                { return size >= numPoints; }
+    //message thread, true until adopt() has been called for a claimed display
+    bool needsAdopting() const noexcept                            { return caption.isEmpty() && captionText[0] != 0; }
+
+    //message thread, sets up the names widgets look displays up by
+    void adopt()
+    {
+        caption = String (CharPointer_UTF8 (captionText));
+        const String captionName = caption.substring (caption.indexOf ("signal ") + 7);
+        const int posColon = captionName.indexOf (":");
+        const int posComma = captionName.indexOf (",");
+        variableName = captionName.substring (0, posComma != -1 ? posComma : posColon);
+        isSpectrum = caption.contains ("fft");
+    }
+
+    //producing thread only
+    template <typename SampleType>
+    void publishFrame (const SampleType* values, int numValues) noexcept
+    {
+        const int numPoints = jlimit (0, size, numValues);
+        float* frame = points + writeIndex * getFrameCapacity();
+
+        for (int i = 0; i < numPoints; i++)
+            frame[i] = (float) values[i];
+
+        pointCounts[writeIndex] = numPoints;
+        frameNumbers[writeIndex] = ++numFramesPublished;
+        writeIndex = latestIndex.exchange (writeIndex | newFrameFlag) & indexMask;
+    }
+
+    //message thread only, the frame's data stays put until the next call
+    Frame getLatestFrame() noexcept
+    {
+        if ((latestIndex.load() & newFrameFlag) != 0)
+            readIndex = latestIndex.exchange (readIndex) & indexMask;
+
+        return { points + readIndex * getFrameCapacity(), pointCounts[readIndex], frameNumbers[readIndex] };
+    }
+
+private:
+    enum { indexMask = 3, newFrameFlag = 4 };
+    int getFrameCapacity() const noexcept       { return capacity; }
+
+    const int capacity;
+    char captionText[maxCaptionLength] = {};
+    HeapBlock<float> points;
+    int pointCounts[3] = {}, frameNumbers[3] = {};
+    int numFramesPublished = 0, writeIndex = 0, readIndex = 1;
+    std::atomic<int> latestIndex { 2 };
+};
+
+#endif  // SIGNALDISPLAY_H_INCLUDED
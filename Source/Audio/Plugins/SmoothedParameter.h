@@ -0,0 +1,97 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef SMOOTHEDPARAMETER_H_INCLUDED
+#define SMOOTHEDPARAMETER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <csound.hpp>
+#include "ChannelPointer.h"
+
+//=============================================================================
+//A parameter that writes to a channel, optionally ramping from its current value
+//to each new target over a fixed time. Only the audio thread calls setTarget()
+//and advance(), isRamping() can be called from any thread.
+class SmoothedParameter
+{
+public:
+    SmoothedParameter (ChannelPointer* channelToUse, float rampTimeInSeconds, bool useExponentialRamp)
+        : channel (channelToUse), rampTime (jmax (0.f, rampTimeInSeconds)), exponential (useExponentialRamp) {}
+
+    //returns true if the parameter has started ramping
+    bool setTarget (MYFLT newTarget, double kr)
+    {
+        const int steps = roundToInt (rampTime * kr);
+
+        if (steps <= 1)
+        {
+            current = target = newTarget;
+            stepsRemaining = 0;
+            ramping = false;
+            channel->set (current);
+            return false;
+        }
+
+        if (stepsRemaining == 0)
+            current = channel->get();
+
+        target = newTarget;
+        stepsRemaining = steps;
+        ramping = true;
+        useFactor = exponential && current * target > 0;
+
+        if (useFactor)
+            factor = std::pow (target / current, MYFLT (1) / steps);
+        else
+            increment = (target - current) / steps;
+
+        return true;
+    }
+
+    void advance()
+    {
+        if (--stepsRemaining <= 0)
+        {
+            stepsRemaining = 0;
+            current = target;
+            ramping = false;
+        }
+        else
+            current = useFactor ? current * factor : current + increment;
+
+        channel->set (current);
+    }
+
+    bool isRamping() const { return ramping.load(); }
+    ChannelPointer* getChannel() const { return channel; }
+
+private:
+    friend class ParameterEventQueue;
+    ChannelPointer* const channel;
+    const float rampTime;
+    const bool exponential;
+    MYFLT current = 0, target = 0, increment = 0, factor = 1;
+    int stepsRemaining = 0;
+    std::atomic<bool> ramping { false };
+    bool useFactor = false;
+    bool isActive = false;
+    SmoothedParameter* nextActive = nullptr;
+};
+
+#endif  // SMOOTHEDPARAMETER_H_INCLUDED
@@ -0,0 +1,73 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#include "TableChangeTracker.h"
+
+//==============================================================================
+SparseSet<int> TableChangeTracker::update (const TableView& view)
+{
+    SparseSet<int> changed;
+    const int numBlocks = (view.size + blockSize - 1) / blockSize;
+
+    if (view.data != lastData || view.size != lastSize)
+    {
+        blockChecksums.malloc ((size_t) jmax (1, numBlocks));
+
+        for (int block = 0; block < numBlocks; block++)
+            blockChecksums[block] = checksum (view.data + block * blockSize, jmin ((int) blockSize, view.size - block * blockSize));
+
+        lastData = view.data;
+        lastSize = view.size;
+
+        if (view.size > 0)
+            changed.addRange ({ 0, view.size });
+    }
+    else
+    {
+        for (int block = 0; block < numBlocks; block++)
+        {
+            const int start = block * blockSize;
+            const int numSamples = jmin ((int) blockSize, view.size - start);
+            const uint64 sum = checksum (view.data + start, numSamples);
+
+            if (sum != blockChecksums[block])
+            {
+                blockChecksums[block] = sum;
+                changed.addRange ({ start, start + numSamples });
+            }
+        }
+    }
+
+    if (! changed.isEmpty())
+        version++;
+
+    return changed;
+}
+
+uint64 TableChangeTracker::checksum (const MYFLT* data, int numSamples) noexcept
+{
+    //FNV-1a over the raw sample bytes
+    uint64 hash = 14695981039346656037ULL;
+    const uint8* bytes = reinterpret_cast<const uint8*> (data);
+
+    for (size_t i = 0; i < (size_t) numSamples * sizeof (MYFLT); i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+    return hash;
+}
@@ -0,0 +1,49 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef TABLECHANGETRACKER_H_INCLUDED
+#define TABLECHANGETRACKER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <csound.hpp>
+#include "TableView.h"
+
+//==================================================================================
+// Tells a widget which parts of a table changed since it last looked. A checksum is
+// kept for every block of blockSize samples, so after an update the widget only
+// re-reads and repaints the blocks whose contents differ. A table that moved or
+// changed length is reported as changed throughout.
+class TableChangeTracker
+{
+public:
+    enum { blockSize = 1024 };
+
+    SparseSet<int> update (const TableView& view);
+    //bumped each time update() finds a change
+    int getVersion() const noexcept     { return version; }
+
+private:
+    static uint64 checksum (const MYFLT* data, int numSamples) noexcept;
+
+    HeapBlock<uint64> blockChecksums;
+    const MYFLT* lastData = nullptr;
+    int lastSize = 0, version = 0;
+};
+
+#endif  // TABLECHANGETRACKER_H_INCLUDED
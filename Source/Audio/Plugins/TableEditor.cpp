@@ -0,0 +1,219 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#include "TableEditor.h"
+
+//==============================================================================
+TableEditor::TableEditor() : Thread ("Cabbage table editor")
+{
+    //slots are only ever appended, so with their storage reserved Csound's thread can walk them without a lock
+    slots.ensureStorageAllocated (maxTables);
+}
+
+TableEditor::~TableEditor()
+{
+    stopThread (1000);
+}
+
+bool TableEditor::requestEdit (int tableNumber, int genRoutine, int tableSize, const Array<double>& arguments)
+{
+    const int gen = std::abs (genRoutine);
+
+    if ((gen != 2 && gen != 5 && gen != 7) || tableSize <= 0 || arguments.isEmpty())
+        return false;
+
+    const ScopedLock sl (lock);
+    Slot* slot = nullptr;
+
+    for (auto* existing : slots)
+    {
+        if (existing->tableNumber == tableNumber)
+            slot = existing;
+    }
+
+    if (slot == nullptr)
+    {
+        if (slots.size() >= maxTables)
+            return false;
+
+        slot = slots.add (new Slot (tableNumber, tableSize, arguments.size()));
+        numActiveSlots = slots.size();
+    }
+    else if (slot->tableSize != tableSize || slot->numArguments != arguments.size())
+        return false;
+
+    slot->genRoutine = genRoutine;
+    slot->arguments = arguments;
+    slot->hasRequest = true;
+
+    if (!isThreadRunning())
+        startThread();
+
+    notify();
+    return true;
+}
+
+bool TableEditor::getGeneratedTable (int tableNumber, Array<float, CriticalSection>& values, int& version)
+{
+    const ScopedLock sl (lock);
+
+    for (auto* slot : slots)
+    {
+        if (slot->tableNumber == tableNumber && slot->version != version)
+        {
+            values = slot->generated;
+            version = slot->version;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TableEditor::run()
+{
+    while (!threadShouldExit())
+    {
+        bool generatedAny = false;
+
+        for (int i = 0; i < numActiveSlots.load(); i++)
+        {
+            Slot* slot = slots.getUnchecked (i);
+            int genRoutine;
+
+            {
+                const ScopedLock sl (lock);
+
+                if (!slot->hasRequest)
+                    continue;
+
+                genRoutine = slot->genRoutine;
+                argumentsBeingGenerated.swapWith (slot->arguments);
+                slot->hasRequest = false;
+            }
+
+            MYFLT* frame = slot->getFrame (slot->writeIndex);
+            generate (genRoutine, argumentsBeingGenerated, frame, slot->tableSize);
+
+            for (int arg = 0; arg < slot->numArguments; arg++)
+                frame[slot->tableSize + 1 + arg] = (MYFLT) argumentsBeingGenerated.getUnchecked (arg);
+
+            slot->writeIndex = slot->latestIndex.exchange (slot->writeIndex | newFrameFlag) & indexMask;
+
+            {
+                const ScopedLock sl (lock);
+                slot->generated.resize (slot->tableSize);
+
+                for (int n = 0; n < slot->tableSize; n++)
+                    slot->generated.setUnchecked (n, (float) frame[n]);
+
+                slot->version++;
+            }
+
+            generatedAny = true;
+        }
+
+        if (generatedAny)
+            sendChangeMessage();
+        else
+            wait (-1);
+    }
+}
+
+//the same segments Csound's GEN02, GEN05 and GEN07 produce, guard point included,
+//normalised unless the GEN number is negative
+void TableEditor::generate (int genRoutine, const Array<double>& arguments, MYFLT* table, int tableSize) noexcept
+{
+    const int gen = std::abs (genRoutine);
+    int index = 0;
+
+    if (gen == 2)
+    {
+        for (; index < tableSize; index++)
+            table[index] = index < arguments.size() ? (MYFLT) arguments.getUnchecked (index) : 0;
+
+        table[tableSize] = table[0];
+    }
+    else
+    {
+        double value = arguments.getUnchecked (0);
+
+        for (int arg = 1; arg + 1 < arguments.size() && index <= tableSize; arg += 2)
+        {
+            const int length = jmax (0, roundToInt (arguments.getUnchecked (arg)));
+            const double target = arguments.getUnchecked (arg + 1);
+            const bool exponential = gen == 5 && value * target > 0;
+
+            for (int i = 0; i < length && index <= tableSize; i++)
+            {
+                const double proportion = i / (double) length;
+                table[index++] = (MYFLT) (exponential ? value * std::pow (target / value, proportion)
+                                                      : value + (target - value) * proportion);
+            }
+
+            value = target;
+        }
+
+        while (index <= tableSize)
+            table[index++] = (MYFLT) value;
+    }
+
+    if (genRoutine > 0)
+    {
+        MYFLT peak = 0;
+
+        for (int i = 0; i <= tableSize; i++)
+            peak = jmax (peak, (MYFLT) std::abs (table[i]));
+
+        if (peak > 0)
+            for (int i = 0; i <= tableSize; i++)
+                table[i] /= peak;
+    }
+}
+
+TableEditor::Slot::Slot (int number, int size, int numArgs) :
+    tableNumber (number),
+    tableSize (size),
+    numArguments (numArgs),
+    frameSize (size + 1 + numArgs),
+    frames ((size_t) (3 * frameSize), true)
+{
+}
+
+void TableEditor::Slot::apply (Csound& cs) noexcept
+{
+    if ((latestIndex.load() & newFrameFlag) == 0)
+        return;
+
+    readIndex = latestIndex.exchange (readIndex) & indexMask;
+    const MYFLT* frame = getFrame (readIndex);
+    MYFLT* table = nullptr;
+
+    //the table may have been replaced by an f-statement or a recompile since the edit was posted
+    if (cs.GetTable (table, tableNumber) != tableSize || table == nullptr)
+        return;
+
+    memcpy (table, frame, sizeof (MYFLT) * (size_t) (tableSize + 1));
+
+    //keeps the breakpoints Csound reports for the table in step with its contents
+    MYFLT* tableArguments = nullptr;
+
+    if (csoundGetTableArgs (cs.GetCsound(), &tableArguments, tableNumber) == numArguments && tableArguments != nullptr)
+        memcpy (tableArguments, frame + tableSize + 1, sizeof (MYFLT) * (size_t) numArguments);
+}
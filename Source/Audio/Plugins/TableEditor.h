@@ -0,0 +1,98 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef TABLEEDITOR_H_INCLUDED
+#define TABLEEDITOR_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <csound.hpp>
+
+//==================================================================================
+// Regenerates GEN02, GEN05 and GEN07 tables while a gentable's breakpoints are being
+// dragged. The message thread posts the newest breakpoints for a table, and a request
+// that arrives before the last one was generated simply replaces it. A worker thread
+// generates each table into a spare buffer of a triple buffer, and Csound's thread
+// swaps the newest one in and copies it into the function table between k-cycles, so
+// the table is never written while an instrument reads it. Once generated, widgets
+// are sent a change message and can fetch the new contents with getGeneratedTable().
+class TableEditor : public ChangeBroadcaster,
+    private Thread
+{
+public:
+    enum { maxTables = 32 };
+
+    TableEditor();
+    ~TableEditor();
+
+    //message thread. Returns false when the edit can't be handled here, because of its
+    //GEN routine, or because the table has changed size or argument count since its last
+    //edit, in which case the caller sends an f-statement instead
+    bool requestEdit (int tableNumber, int genRoutine, int tableSize, const Array<double>& arguments);
+
+    //message thread. Returns true and fills values if the table was generated again
+    //since version was last updated
+    bool getGeneratedTable (int tableNumber, Array<float, CriticalSection>& values, int& version);
+
+    //Csound's thread, between k-cycles
+    void applyPendingEdits (Csound& cs) noexcept
+    {
+        const int numSlotsToCheck = numActiveSlots.load();
+
+        for (int i = 0; i < numSlotsToCheck; i++)
+            slots.getUnchecked (i)->apply (cs);
+    }
+
+    //fills tableSize + 1 values. Any thread
+    static void generate (int genRoutine, const Array<double>& arguments, MYFLT* table, int tableSize) noexcept;
+
+private:
+    struct Slot
+    {
+        Slot (int tableNumber, int tableSize, int numArguments);
+
+        MYFLT* getFrame (int index) const noexcept      { return frames + index * frameSize; }
+        void apply (Csound& cs) noexcept;
+
+        const int tableNumber, tableSize, numArguments, frameSize;
+
+        //guarded by the editor's lock
+        int genRoutine = 0, version = 0;
+        Array<double> arguments;
+        bool hasRequest = false;
+        Array<float, CriticalSection> generated;
+
+        //each frame holds the table, its guard point, and the arguments Csound reports for it
+        HeapBlock<MYFLT> frames;
+        int writeIndex = 0, readIndex = 1;
+        std::atomic<int> latestIndex { 2 };
+    };
+
+    enum { indexMask = 3, newFrameFlag = 4 };
+
+    void run() override;
+
+    CriticalSection lock;
+    OwnedArray<Slot> slots;
+    std::atomic<int> numActiveSlots { 0 };
+    Array<double> argumentsBeingGenerated;
+
+    JUCE_DECLARE_NON_COPYABLE (TableEditor)
+};
+
+#endif  // TABLEEDITOR_H_INCLUDED
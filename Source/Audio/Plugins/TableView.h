@@ -0,0 +1,62 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#ifndef TABLEVIEW_H_INCLUDED
+#define TABLEVIEW_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <csound.hpp>
+
+//==================================================================================
+// A window onto a function table's own memory, as csoundGetTable() hands it out.
+// Nothing is copied, so the view is only good until Csound next replaces or resizes
+// the table. Widgets convert it to floats a block at a time into a scratch buffer they
+// own, rather than building a full copy of tables that may run to millions of samples.
+struct TableView
+{
+    const MYFLT* data = nullptr;
+    int size = 0;
+
+    bool isValid() const noexcept       { return data != nullptr && size > 0; }
+
+    //calls receiver (startSample, scratch, numSamples) for each block of the range
+    template <typename BlockReceiver>
+    void readInBlocks (Range<int> range, AudioSampleBuffer& scratch, BlockReceiver&& receiver) const
+    {
+        range = range.getIntersectionWith ({ 0, size });
+        const int blockSize = scratch.getNumSamples();
+
+        for (int start = range.getStart(); start < range.getEnd() && blockSize > 0; start += blockSize)
+        {
+            const int numSamples = jmin (blockSize, range.getEnd() - start);
+
+            for (int channel = 0; channel < scratch.getNumChannels(); channel++)
+            {
+                float* dest = scratch.getWritePointer (channel);
+
+                for (int i = 0; i < numSamples; i++)
+                    dest[i] = (float) data[start + i];
+            }
+
+            receiver (start, scratch, numSamples);
+        }
+    }
+};
+
+#endif  // TABLEVIEW_H_INCLUDED
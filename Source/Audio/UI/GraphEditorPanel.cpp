@@ -193,6 +193,10 @@ private AudioProcessorParameter::Listener
             }
         }
         
+        //Cabbage instruments can declare autosleep(), poll so the node shows its state
+        if (dynamic_cast<CabbagePluginProcessor*> (getProcessor()) != nullptr)
+            sleepStatePoller.startTimer (500);
+        
         setSize (150, 60);
     }
     
@@ -310,6 +314,16 @@ private AudioProcessorParameter::Listener
                          x + 4, y - 2, w - 8, h - 4,
                          Justification::centred, 2);
         
+        if (auto* cabbagePlugin = dynamic_cast<CabbagePluginProcessor*> (getProcessor()))
+        {
+            if (cabbagePlugin->isAutoSleepEnabled())
+            {
+                g.setFont(CabbageUtilities::getComponentFont().withHeight(10.f));
+                g.drawText(String(cabbagePlugin->isSleeping() ? "sleeping" : "awake") + " (" + String(cabbagePlugin->getSleepCount()) + ")",
+                           x + 4, y + h - 14, w - 8, 12, Justification::centred);
+            }
+        }
+        
         g.setOpacity(0.2);
         g.setColour(Colours::green.withAlpha(.3f));
         g.drawRoundedRectangle(x + 0.5, y + 0.5, w - 1, h - 1, 5, 1.0f);
@@ -544,6 +558,27 @@ private AudioProcessorParameter::Listener
     
     void parameterGestureChanged (int, bool) override  {}
     
+    void updateSleepState()
+    {
+        if (auto* cabbagePlugin = dynamic_cast<CabbagePluginProcessor*> (getProcessor()))
+        {
+            const int state = cabbagePlugin->isAutoSleepEnabled() ? cabbagePlugin->getSleepCount() * 2 + (cabbagePlugin->isSleeping() ? 1 : 0) : -1;
+            
+            if (state != lastSleepState)
+            {
+                lastSleepState = state;
+                repaint();
+            }
+        }
+    }
+    
+    struct SleepStatePoller : public Timer
+    {
+        SleepStatePoller (FilterComponent& o) : owner (o) {}
+        void timerCallback() override { owner.updateSleepState(); }
+        FilterComponent& owner;
+    };
+    
     GraphEditorPanel& panel;
     FilterGraph& graph;
     const AudioProcessorGraph::NodeID pluginID;
@@ -555,6 +590,8 @@ private AudioProcessorParameter::Listener
     int numIns = 0, numOuts = 0;
     DropShadowEffect shadow;
     std::unique_ptr<PopupMenu> menu;
+    SleepStatePoller sleepStatePoller { *this };
+    int lastSleepState = -1;
 };
 
 
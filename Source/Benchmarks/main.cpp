@@ -0,0 +1,149 @@
+/*
+  Copyright (C) 2016 Rory Walsh
+
+  Cabbage is free software; you can redistribute it
+  and/or modify it under the terms of the GNU General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  Cabbage is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU General Public
+  License along with Csound; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+  02111-1307 USA
+*/
+
+#include "../../JuceLibraryCode/JuceHeader.h"
+#include "../Audio/Plugins/CsoundPluginProcessor.h"
+#include "../Widgets/CabbageWidgetData.h"
+#include <iostream>
+
+//command line benchmarks and checks for the processor and the widget parser. They used to
+//run from the IDE's command line, but they don't need its windows or settings
+
+namespace
+{
+    //times the widget parser over the <Cabbage> section of every .csd in examplesDir
+    StringArray benchmarkWidgetParser (File examplesDir)
+    {
+        StringArray results;
+        Array<File> csdFiles;
+        examplesDir.findChildFiles (csdFiles, File::findFiles, true, "*.csd");
+
+        StringArray widgetLines;
+
+        for (auto& csdFile : csdFiles)
+        {
+            StringArray csdLines;
+            csdLines.addLines (csdFile.loadFileAsString());
+            bool inCabbageSection = false;
+
+            for (auto& line : csdLines)
+            {
+                if (line.contains ("</Cabbage>"))
+                    break;
+
+                if (inCabbageSection && line.trim().isNotEmpty())
+                    widgetLines.add (line);
+
+                if (line.contains ("<Cabbage>"))
+                    inCabbageSection = true;
+            }
+        }
+
+        if (widgetLines.isEmpty())
+        {
+            results.add ("No widget lines found in " + examplesDir.getFullPathName());
+            return results;
+        }
+
+        const int passes = 20;
+        const double linesParsed = double (widgetLines.size()) * passes;
+        int identifiers = 0;
+
+        double start = Time::getMillisecondCounterHiRes();
+
+        for (int pass = 0; pass < passes; pass++)
+        {
+            for (auto& line : widgetLines)
+            {
+                CabbageWidgetData::IdentifierLexer lexer (line);
+                CabbageWidgetData::IdentifierLexer::Span identifier, arguments;
+
+                while (lexer.next (identifier, arguments))
+                    identifiers++;
+            }
+        }
+
+        const double lexingTime = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+        start = Time::getMillisecondCounterHiRes();
+
+        for (int pass = 0; pass < passes; pass++)
+        {
+            for (auto& line : widgetLines)
+            {
+                ValueTree temp ("temp");
+                CabbageWidgetData::setWidgetState (temp, line, 0);
+            }
+        }
+
+        const double parsingTime = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+        results.add (String (csdFiles.size()) + " files, " + String (widgetLines.size()) + " widget lines, "
+                     + String (identifiers / passes) + " identifiers, " + String (passes) + " passes");
+        results.add ("IdentifierLexer: " + String (linesParsed / jmax (lexingTime, 1.0e-9), 0) + " lines per second");
+        results.add ("setWidgetState: " + String (linesParsed / jmax (parsingTime, 1.0e-9), 0) + " lines per second");
+        return results;
+    }
+
+    //the optional file or folder that follows a command, or an invalid File if there isn't one
+    File getFileArgument (const ArgumentList& args)
+    {
+        return args.size() > 1 && !args[1].isOption() ? args[1].resolveAsFile() : File();
+    }
+
+    void print (const StringArray& results)
+    {
+        for (auto& result : results)
+            std::cout << result << std::endl;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    //the processor's timers and background reloads need a message thread, this one plays it
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    ConsoleApplication app;
+    app.addHelpCommand ("--help|-h", "Usage: CabbageBenchmarks <command> [file]", true);
+
+    app.addCommand ({ "--benchmark-reload", "--benchmark-reload file.csd",
+                      "Compares background reloads of a file with compiling it in place", String(),
+                      [] (const ArgumentList& args) { print (CsoundPluginProcessor::benchmarkReload (getFileArgument (args))); } });
+
+    app.addCommand ({ "--benchmark-block-transfer", "--benchmark-block-transfer",
+                      "Times the audio transfer between host buffers and Csound's spin/spout", String(),
+                      [] (const ArgumentList&) { print (CsoundPluginProcessor::benchmarkBlockTransfer()); } });
+
+    app.addCommand ({ "--check-double-precision", "--check-double-precision [file.csd]",
+                      "Compares the float and double processing paths", String(),
+                      [] (const ArgumentList& args) { print (CsoundPluginProcessor::checkDoublePrecision (getFileArgument (args))); } });
+
+    app.addCommand ({ "--check-table-generators", "--check-table-generators",
+                      "Compares the gentable editor's GEN02, GEN05 and GEN07 tables with Csound's", String(),
+                      [] (const ArgumentList&) { print (CsoundPluginProcessor::checkTableGenerators()); } });
+
+    app.addCommand ({ "--benchmark-widget-parser", "--benchmark-widget-parser [dir]",
+                      "Times the widget parser over every .csd in dir, or in the working directory", String(),
+                      [] (const ArgumentList& args)
+                      {
+                          const File dir = getFileArgument (args);
+                          print (benchmarkWidgetParser (dir == File() ? File::getCurrentWorkingDirectory() : dir));
+                      } });
+
+    return app.findAndRunCommand (argc, argv);
+}
@@ -342,6 +342,9 @@ public:
         add ("metercolour:");
         add ("popuppostfix");
         add ("manufacturer");
+        add ("offlineksmps");
+        add ("guiframerate");
+        add ("audiochannel");
         add ("valuepostfix");
         add ("markerstart");
 		add ("keyreleased");
@@ -369,6 +372,7 @@ public:
         add ("updaterate");
         add ("gapmarkers");
         add ("guirefresh");
+        add ("oversample");
         add ("tablecolor");
         add ("radiogroup");
         add ("macronames");
@@ -385,6 +389,8 @@ public:
         add ("fontstyle");
         add ("fontcolor");
         add ("filmstrip");
+        add ("smoothing");
+        add ("autosleep");
         add ("arraysize");
         add ("increment");
         add ("namespace");
@@ -402,6 +408,7 @@ public:
         add ("typeface");
         add ("channels");
         add ("velocity");
+        add ("peakhold");
         add ("amprange");
         add ("celldata");
         add ("isparent");
@@ -527,8 +534,10 @@ namespace CabbageIdentifierIds
 	static const Identifier arraysize = "arraysize";
 	static const Identifier arrowbackgroundcolour = "arrowbackgroundcolour";
 	static const Identifier arrowcolour = "arrowcolour";
+	static const Identifier audiochannel = "audiochannel";
     static const Identifier automation = "automation";
     static const Identifier automatable = "automatable";
+	static const Identifier autosleep = "autosleep";
 	static const Identifier author = "author";
 	static const Identifier backgroundcolour = "backgroundcolour";
 	static const Identifier ballcolour = "ballcolour";
@@ -577,6 +586,7 @@ namespace CabbageIdentifierIds
 	static const Identifier fontstyle = "fontstyle";
 	static const Identifier fontsize = "fontsize";
 	static const Identifier gradient = "gradient";
+	static const Identifier guiframerate = "guiframerate";
 	static const Identifier guirefresh = "guirefresh";
 	static const Identifier height = "height";
 	static const Identifier highlightcolour = "highlightcolour";
@@ -635,15 +645,18 @@ namespace CabbageIdentifierIds
 	static const Identifier name = "name";
 	static const Identifier keypressed = "keypressed";
 	static const Identifier keyreleased = "keyreleased";
+	static const Identifier offlineksmps = "offlineksmps";
 	static const Identifier oncolour = "oncolour";
 	static const Identifier onfontcolour = "onfontcolour";
     static const Identifier opcodedir = "opcodedir";
 	static const Identifier orientation = "orientation";
 	static const Identifier outlinecolour = "outlinecolour";
 	static const Identifier outlinethickness = "outlinethickness";
+	static const Identifier oversample = "oversample";
 	static const Identifier overlaycolour = "overlaycolour";
 	static const Identifier parentcomponent = "parentcomponent";
 	static const Identifier parentdir = "parentdir";
+	static const Identifier peakhold = "peakhold";
 	static const Identifier pivotx = "pivotx";
 	static const Identifier pivoty = "pivoty";
 	static const Identifier plant = "plant";
@@ -677,6 +690,8 @@ namespace CabbageIdentifierIds
 	static const Identifier signalvariable = "signalvariable";
 	static const Identifier sliderrange = "sliderrange";
 	static const Identifier sliderskew = "sliderskew";
+	static const Identifier smoothing = "smoothing";
+	static const Identifier smoothingtype = "smoothingtype";
 	static const Identifier socketaddress = "socketaddress";
 	static const Identifier socketport = "socketport";
 	static const Identifier stack = "stack";
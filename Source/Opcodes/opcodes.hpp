@@ -28,6 +28,125 @@ public:
     int size = 0;
 };
 
+//====================================================================================================
+// Widget update messages pushed from the orchestra with cabbageSet. Every Csound instance
+// gets a queue of its own, published through the "cabbageWidgetMessages" global variable,
+// so the only producer is whichever thread is initialising or performing that instance, and
+// the queue needs no lock. Messages are copied into fixed slots so pushing never allocates,
+// and the message thread drains them on its next update.
+//====================================================================================================
+class CabbageWidgetMessageQueue
+{
+public:
+    enum
+    {
+        queueSize = 256, maxChannelLength = 128, maxMessageLength = 1024
+    };
+
+    struct Message
+    {
+        char channel[maxChannelLength];
+        char text[maxMessageLength];
+    };
+
+    CabbageWidgetMessageQueue() : fifo (queueSize), messages (queueSize) {}
+
+    //returns false if the queue is full or the message does not fit in a slot
+    bool push (const char* channel, const char* text)
+    {
+        if (strlen (channel) >= maxChannelLength || strlen (text) >= maxMessageLength)
+            return false;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 == 0)
+        {
+            ++numDropped;
+            return false;
+        }
+
+        strcpy (messages[start1].channel, channel);
+        strcpy (messages[start1].text, text);
+        fifo.finishedWrite (1);
+        numDropped = 0;
+        return true;
+    }
+
+    //producer only. True for the first message dropped since the queue last had room, so a
+    //full queue is reported once rather than on every k-cycle until it drains
+    bool isFirstDrop() const { return numDropped == 1; }
+
+    //message thread only
+    bool pop (Message& message)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (1, start1, size1, start2, size2);
+
+        if (size1 == 0)
+            return false;
+
+        message = messages[start1];
+        fifo.finishedRead (1);
+        return true;
+    }
+
+    bool isEmpty() const { return fifo.getNumReady() == 0; }
+
+private:
+    AbstractFifo fifo;
+    std::vector<Message> messages;
+    int numDropped = 0;
+};
+
+//====================================================================================================
+// cabbageSet "channel", "identifiers" at i-time, or cabbageSet ktrig, "channel", "identifiers"
+// whenever ktrig is non-zero. Sends identifier text to the widget with that channel, or with
+// that identchannel, without the host having to poll a string channel for it.
+//====================================================================================================
+struct CabbageSetIdentifiers : csnd::Plugin<0, 3>
+{
+    int init()
+    {
+        return push (inargs.str_data (0).data, inargs.str_data (1).data);
+    }
+
+    int kperf()
+    {
+        if (inargs[0] == 0)
+            return OK;
+
+        return push (inargs.str_data (1).data, inargs.str_data (2).data);
+    }
+
+    int push (const char* channel, const char* text)
+    {
+        CabbageWidgetMessageQueue** queue = (CabbageWidgetMessageQueue**)csound->query_global_variable ("cabbageWidgetMessages");
+
+        if (queue == nullptr || *queue == nullptr)
+            return OK;
+
+        if ((*queue)->push (channel, text))
+            return OK;
+
+        if (strlen (channel) >= CabbageWidgetMessageQueue::maxChannelLength || strlen (text) >= CabbageWidgetMessageQueue::maxMessageLength)
+        {
+            //the same text would be too long on every k-cycle, so only say so once for this
+            //opcode. Csound zeroes opcode memory when it allocates an instrument instance
+            if (! reportedTooLong)
+                csound->message ("cabbageSet: channel or identifier text too long, message dropped\n");
+
+            reportedTooLong = true;
+        }
+        else if ((*queue)->isFirstDrop())
+            csound->message ("cabbageSet: widget update queue is full, messages are dropped until it drains\n");
+
+        return OK;
+    }
+
+    bool reportedTooLong;
+};
+
 //====================================================================================================
 // ReadStateData
 //====================================================================================================
@@ -57,43 +57,6 @@ using namespace std;
 #define svgGroupboxHeight 300
 
 
-//simple abstract class used to hold information about about displays
-class SignalDisplay
-{
-public:
-    String caption;
-    int windid;
-    float yScale;
-    int min , max, size;
-
-    SignalDisplay (String _caption, int _id, float _scale, int _min, int _max, int _size):
-        caption (_caption),
-        windid (_id),
-        yScale (_scale),
-        min (_min),
-        max (_max),
-        size (_size)
-    {}
-
-    ~SignalDisplay()
-    {
-        points.clear();
-    }
-
-    Array<float, CriticalSection> getPoints()
-    {
-        return points;
-    }
-
-    void setPoints (Array <float, CriticalSection > tablePoints)
-    {
-        points.swapWith (tablePoints);
-    }
-
-private:
-    Array <float, CriticalSection > points;
-};
-
 //================================================================================
 class CabbageExamplesFolder
 {
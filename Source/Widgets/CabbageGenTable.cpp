@@ -41,7 +41,12 @@ CabbageGenTable::CabbageGenTable (ValueTree wData, CabbagePluginEditor* owner)
     ampRanges = CabbageWidgetData::getProperty (wData, CabbageIdentifierIds::amprange);
 
     initialiseGenTable (wData);
+    owner->getProcessor().getTableEditor().addChangeListener (this);
+}
 
+CabbageGenTable::~CabbageGenTable()
+{
+    owner->getProcessor().getTableEditor().removeChangeListener (this);
 }
 
 //===============================================================================
@@ -54,6 +59,15 @@ void CabbageGenTable::changeListenerCallback (ChangeBroadcaster* source)
         if (genTable->changeMessage == "updateFunctionTable")
             owner->updatefTableData (genTable);
     }
+    else if (source == &owner->getProcessor().getTableEditor())
+    {
+        //new contents for a table whose breakpoints are being dragged
+        for (int y = 0; y < jmin (tables.size(), tableEditVersions.size()); y++)
+        {
+            if (owner->getProcessor().getTableEditor().getGeneratedTable (tables[y], tableValues, tableEditVersions.getReference (y)))
+                table.setWaveform (tableValues, tables[y], false);
+        }
+    }
 }
 
 void CabbageGenTable::initialiseGenTable (ValueTree wData)
@@ -73,14 +87,17 @@ void CabbageGenTable::initialiseGenTable (ValueTree wData)
 
 
     tables = CabbageWidgetData::getProperty (wData, CabbageIdentifierIds::tablenumber);
+    tableTrackers.clear();
+    tableEditVersions.clear();
 
     for (int y = 0; y < tables.size(); y++)
     {
         int tableNumber = tables[y];
-        tableValues.clear();
-        tableValues = owner->getTableFloats (tableNumber);
+        tableTrackers.add (new TableChangeTracker());
+        tableEditVersions.add (0);
+        const TableView tableView = owner->getTableView (tableNumber);
 
-        if (tableNumber > 0 && tableValues.size() > 0)
+        if (tableNumber > 0 && tableView.isValid())
         {
             StringArray pFields = owner->getTableStatement (tableNumber);
             int genRoutine = pFields[4].getIntValue();
@@ -92,19 +109,18 @@ void CabbageGenTable::initialiseGenTable (ValueTree wData)
                                          Colour::fromString (CabbageWidgetData::getProperty (wData, CabbageIdentifierIds::tablecolour)[y].toString()) :
                                          Colour::fromString (CabbageWidgetData::getProperty (wData, CabbageIdentifierIds::tablecolour)[numberOfColours - 1].toString()));
 
-                table.addTable (44100, tableCol, (tableValues.size() >= MAX_TABLE_SIZE ? 1 : genRoutine), ampRanges, tableNumber, this);
+                table.addTable (44100, tableCol, (tableView.size >= MAX_TABLE_SIZE ? 1 : genRoutine), ampRanges, tableNumber, this);
 
-                if (abs (genRoutine) == 1 || tableValues.size() >= MAX_TABLE_SIZE)
+                if (abs (genRoutine) == 1 || tableView.size >= MAX_TABLE_SIZE)
                 {
-                    tableBuffer.clear();
-                    int channels = 1;//for now only works in mono;;
-                    tableBuffer.setSize (channels, tableValues.size());
-                    tableBuffer.addFrom (0, 0, tableValues.getRawDataPointer(), tableValues.size());
-                    table.setWaveform (tableBuffer, tableNumber);
+                    //for now only works in mono
+                    updateLargeTable (y, tableNumber, true);
                     table.setZoomFactor(CabbageWidgetData::getNumProp(wData, CabbageIdentifierIds::zoom));
                 }
                 else
                 {
+                    tableTrackers[y]->update (tableView);
+                    tableValues = owner->getTableFloats (tableNumber);
                     table.setWaveform (tableValues, tableNumber);
 
                     //only enable editing for gen05, 07, and 02
@@ -162,6 +178,29 @@ void CabbageGenTable::initialiseGenTable (ValueTree wData)
 }
 
 //===============================================================================
+//===============================================================================
+// Feeds only the blocks of a large table that changed since the last call to the
+// display's thumbnail, converting them from Csound's memory a block at a time
+void CabbageGenTable::updateLargeTable (int index, int tableNumber, bool resetLength)
+{
+    const TableView tableView = owner->getTableView (tableNumber);
+    GenTable* genTable = table.getTableFromFtNumber (tableNumber);
+
+    if (! tableView.isValid() || genTable == nullptr || ! isPositiveAndBelow (index, tableTrackers.size()))
+        return;
+
+    const SparseSet<int> changedSamples = tableTrackers[index]->update (tableView);
+
+    if (resetLength || genTable->tableSize != tableView.size)
+        table.setWaveformLength (tableView.size, tableNumber);
+
+    for (int i = 0; i < changedSamples.getNumRanges(); i++)
+        tableView.readInBlocks (changedSamples.getRange (i), tableBlock, [&] (int startSample, const AudioSampleBuffer& block, int numSamples)
+        {
+            table.updateWaveform (block, startSample, numSamples, tableNumber);
+        });
+}
+
 void CabbageGenTable::resized()
 {
     table.setBounds (0, 0, getWidth(), getHeight());
@@ -172,25 +211,21 @@ void CabbageGenTable::valueTreePropertyChanged (ValueTree& valueTree, const Iden
 {
     if (CabbageWidgetData::getNumProp (valueTree, CabbageIdentifierIds::update) == 1)
     {
-        const int numberOfTables = tables.size();
-        tableBuffer.clear();
+        const int numberOfTables = jmin (tables.size(), tableTrackers.size());
 
         for (int y = 0; y < numberOfTables; y++)
         {
             int tableNumber = tables[y];
-            tableValues.clear();
-            tableValues = owner->getTableFloats (tableNumber);
 
-            if (table.getTableFromFtNumber (tableNumber) != nullptr)
+            if (GenTable* genTable = table.getTableFromFtNumber (tableNumber))
             {
-                if (table.getTableFromFtNumber (tableNumber)->tableSize >= MAX_TABLE_SIZE)
+                if (genTable->tableSize >= MAX_TABLE_SIZE || genTable->genRoutine == 1)
                 {
-                    tableBuffer.clear();
-                    tableBuffer.addFrom (y, 0, tableValues.getRawDataPointer(), tableValues.size());
-                    table.setWaveform (tableBuffer, tableNumber);
+                    updateLargeTable (y, tableNumber, false);
                 }
-                else
+                else if (! tableTrackers[y]->update (owner->getTableView (tableNumber)).isEmpty())
                 {
+                    tableValues = owner->getTableFloats (tableNumber);
                     table.setWaveform (tableValues, tableNumber, false);
                     StringArray pFields = owner->getTableStatement (tableNumber);
                     table.enableEditMode (pFields, tableNumber);
@@ -23,6 +23,7 @@
 
 #include "../CabbageCommonHeaders.h"
 #include "CabbageWidgetBase.h"
+#include "../Audio/Plugins/CsoundPluginProcessor.h"
 #include "Legacy/TableManager.h"
 
 class CabbagePluginEditor;
@@ -43,12 +44,18 @@ class CabbageGenTable : public Component, public ValueTree::Listener, public Cab
     TableManager table;
     double scrubberPosition;
     Array <float, CriticalSection> tableValues;
-    AudioSampleBuffer tableBuffer;
+    //large tables are read straight from Csound a block at a time through this
+    AudioSampleBuffer tableBlock { 1, 4096 };
+    //one per entry in tables, so updates only touch the parts of a table that changed
+    OwnedArray<TableChangeTracker> tableTrackers;
+    //the last contents fetched from the processor's table editor, for each entry in tables
+    Array<int> tableEditVersions;
     var tables;
+    void updateLargeTable (int index, int tableNumber, bool resetLength);
 public:
 
     CabbageGenTable (ValueTree wData, CabbagePluginEditor* owner);
-    ~CabbageGenTable() {};
+    ~CabbageGenTable();
 
     //ValueTree::Listener virtual methods....
     void valueTreePropertyChanged (ValueTree& valueTree, const Identifier&)  override;
@@ -162,35 +162,59 @@ void CabbageSignalDisplay::showScrollbar (bool show)
 //====================================================================================
 void CabbageSignalDisplay::drawSonogram()
 {
-    const int rightHandEdge = spectrogramImage.getWidth() - 2;
+    //the image is a ring of columns, each frame overwrites the oldest one and paint() unrolls it
     const int imageHeight = spectrogramImage.getHeight();
+    spectrogramColumn = (spectrogramColumn + 1) % spectrogramImage.getWidth();
 
-    spectrogramImage.moveImageSection (0, 0, 1, 0, rightHandEdge, imageHeight);
-
-    Graphics g (spectrogramImage);
-    Range<float> maxLevel = FloatVectorOperations::findMinAndMax (signalFloatArray.getRawDataPointer(), signalFloatArray.size());
+    const Range<float> maxLevel = FloatVectorOperations::findMinAndMax (signalFloatArray.data, signalFloatArray.size);
+    Image::BitmapData pixels (spectrogramImage, spectrogramColumn, 0, 1, imageHeight, Image::BitmapData::writeOnly);
 
     for (int y = 0; y < imageHeight; y++)
     {
         const int index = jmap (y, 0, imageHeight, 0, vectorSize);
         const float level = jmap (signalFloatArray[index], 0.0f, jmax (maxLevel.getEnd(), signalFloatArray[index] + 0.1f), 0.0f, 1.0f);
-        g.setColour (Colour::fromHSV (level, 1.0f, level, 1.0f));
-        g.drawHorizontalLine (imageHeight - y, rightHandEdge, rightHandEdge + 2);
+        pixels.setPixelColour (0, imageHeight - 1 - y, Colour::fromHSV (level, 1.0f, level, 1.0f));
+    }
+}
+
+//====================================================================================
+void CabbageSignalDisplay::reduceToColumns (const SignalDisplay::Frame& points, int numPoints)
+{
+    //keeps the lowest and highest point landing on each visible pixel column, columns nothing lands on end up with min > max
+    FloatVectorOperations::fill (columnMinimums, std::numeric_limits<float>::max(), numColumns);
+    FloatVectorOperations::fill (columnMaximums, std::numeric_limits<float>::lowest(), numColumns);
+
+    for (int i = 0; i < numPoints; i++)
+    {
+        const int x = jmap (i, 0, numPoints, leftPos, scopeWidth);
+
+        if (isPositiveAndBelow (x, numColumns))
+        {
+            columnMinimums[x] = jmin (columnMinimums[x], points[i]);
+            columnMaximums[x] = jmax (columnMaximums[x], points[i]);
+        }
     }
 }
 
 //====================================================================================
 void CabbageSignalDisplay::drawSpectroscope (Graphics& g)
 {
-    for (int i = 0; i < vectorSize; i++)
+    const int offset = isScrollbarShowing == true ? scrollbarHeight : 0;
+    const int height = getHeight() - offset;
+    Path bars;
+
+    reduceToColumns (signalFloatArray, vectorSize);
+
+    for (int x = 0; x < numColumns; x++)
     {
-        const int position = jmap (i, 0, vectorSize, leftPos, scopeWidth);
-        const int offset = isScrollbarShowing == true ? scrollbarHeight : 0;
-        const int height = getHeight() - offset;
-        const int amp = (signalFloatArray[i] * 3 * height);
-        g.setColour (colour);
-        g.drawVerticalLine (position, height - amp, height);
+        const int amp = columnMaximums[x] * 3 * height;
+
+        if (columnMinimums[x] <= columnMaximums[x] && amp > 0)
+            bars.addRectangle (x, height - amp, 1, amp);
     }
+
+    g.setColour (colour);
+    g.fillPath (bars);
 }
 
 //====================================================================================
@@ -198,18 +222,30 @@ void CabbageSignalDisplay::drawWaveform (Graphics& g)
 {
     const int offset = isScrollbarShowing == true ? scrollbarHeight : 0;
     const int height = getHeight() - offset;
-    int prevXPos = 0;
-    int prevYPos = jmap (signalFloatArray[0]*-1.f, -1.f, 1.f, 0.f, 1.f) * height;
+    Path trace;
 
-    for (int i = 0; i < vectorSize; i++)
+    reduceToColumns (signalFloatArray, vectorSize);
+
+    //one vertical run per column, from its highest point to its lowest
+    for (int x = 0; x < numColumns; x++)
     {
-        const int position = jmap (i, 0, vectorSize, leftPos, scopeWidth);
-        const int amp = jmap (signalFloatArray[i]*-1.f, -1.f, 1.f, 0.f, 1.f) * height;
-        g.setColour (colour);
-        g.drawLine (prevXPos, prevYPos, position, amp, lineThickness);
-        prevXPos = position;
-        prevYPos = amp;
+        if (columnMinimums[x] > columnMaximums[x])
+            continue;
+
+        const float top = jmap (columnMaximums[x]*-1.f, -1.f, 1.f, 0.f, 1.f) * height;
+        const float bottom = jmap (columnMinimums[x]*-1.f, -1.f, 1.f, 0.f, 1.f) * height;
+
+        if (trace.isEmpty())
+            trace.startNewSubPath (x, top);
+        else
+            trace.lineTo (x, top);
+
+        if (bottom != top)
+            trace.lineTo (x, bottom);
     }
+
+    g.setColour (colour);
+    g.strokePath (trace, PathStrokeType (lineThickness));
 }
 
 //====================================================================================
@@ -217,38 +253,72 @@ void CabbageSignalDisplay::drawLissajous (Graphics& g)
 {
     const int offset = isScrollbarShowing == true ? scrollbarHeight : 0;
     const int height = getHeight() - offset;
-    int prevXPos = jmap (signalFloatArray[0], -1.f, 1.f, (float)leftPos, (float)scopeWidth);;
-    int prevYPos = jmap (signalFloatArray2[1], -1.f, 1.f, 0.f, 1.f) * height;
+    int prevXPos = std::numeric_limits<int>::min(), prevYPos = 0;
+    Path trace;
 
+    //consecutive points on the same pixel add nothing to the curve
     for (int i = 0; i < vectorSize; i++)
     {
         const int position = jmap (signalFloatArray[i], -1.f, 1.f, (float)leftPos, (float)scopeWidth);
         const int amp = jmap (signalFloatArray2[i], -1.f, 1.f, 0.f, 1.f) * height;
-        g.setColour (colour);
-        g.drawLine (prevXPos, prevYPos, position, amp, lineThickness);
+
+        if (position == prevXPos && amp == prevYPos)
+            continue;
+
+        if (trace.isEmpty())
+            trace.startNewSubPath (position, amp);
+        else
+            trace.lineTo (position, amp);
+
         prevXPos = position;
         prevYPos = amp;
     }
+
+    g.setColour (colour);
+    g.strokePath (trace, PathStrokeType (lineThickness));
 }
 
 //====================================================================================
 void CabbageSignalDisplay:: paint (Graphics& g)
 {
     g.fillAll (backgroundColour);
-    
+
+    //once something has arrived every repaint draws, the frames and the spectrogram persist
     if (shouldPaint)
     {
         if (shouldDrawSonogram)
-            g.drawImageWithin (spectrogramImage, 0, 0, getWidth(), getHeight(), RectanglePlacement::stretchToFit);
-        else if (displayType == "spectroscope")
-            drawSpectroscope (g);
-        else if (displayType == "waveform")
-            drawWaveform (g);
-        else if (displayType == "lissajous")
-            drawLissajous (g);
+        {
+            //oldest column first, that's the one after the last written
+            const int width = spectrogramImage.getWidth(), height = spectrogramImage.getHeight();
+            const int newest = spectrogramColumn + 1;
+            g.drawImage (spectrogramImage, 0, 0, width - newest, height, newest, 0, width - newest, height);
+            g.drawImage (spectrogramImage, width - newest, 0, newest, height, 0, 0, newest, height);
+        }
+        else if (readLatestFrames())
+        {
+            if (displayType == "spectroscope")
+                drawSpectroscope (g);
+            else if (displayType == "waveform")
+                drawWaveform (g);
+            else if (displayType == "lissajous")
+                drawLissajous (g);
+        }
     }
+}
+
+//====================================================================================
+bool CabbageSignalDisplay::isOnScreen() const
+{
+    if (!isShowing())
+        return false;
 
-    shouldPaint = false;
+    //a display scrolled out of a viewport is still showing as far as JUCE is concerned
+    Rectangle<int> area = getScreenBounds();
+
+    for (auto* parent = getParentComponent(); parent != nullptr; parent = parent->getParentComponent())
+        area = area.getIntersection (parent->getScreenBounds());
+
+    return !area.isEmpty();
 }
 
 //====================================================================================
@@ -267,63 +337,90 @@ void CabbageSignalDisplay::mouseMove (const MouseEvent& e)
 }
 
 //====================================================================================
-void CabbageSignalDisplay::setSignalFloatArray (Array<float, CriticalSection> _points)
+bool CabbageSignalDisplay::findSignalDisplays()
 {
-    signalFloatArray.swapWith (_points);
+    //displays register as Csound creates them and are released with their instance, so look
+    //again whenever the set changes
+    const int signalDisplayVersion = owner->getSignalDisplayVersion();
 
-    if (displayType == "lissajous" || displayType == "waveform")
-        vectorSize = signalFloatArray.size() / 2;
-    else
-        vectorSize = signalFloatArray.size();
-
-    if (vectorSize > 0)
+    if (signalDisplayVersion != signalDisplayVersionSeen)
     {
-        //spectrogram works on a scrolling image, the other displays are drawn directly
-        if (displayType == "spectrogram")
-            drawSonogram();
+        signalDisplayVersionSeen = signalDisplayVersion;
+        //the frames point into the displays being let go
+        signalFloatArray = signalFloatArray2 = {};
+        signalDisplays[0] = signalDisplays[1] = nullptr;
 
-        shouldPaint = true;
+        //audio channels are analysed by the processor, their displays are captioned after the channel
+        const bool usesAudioChannel = CabbageWidgetData::getStringProp (widgetData, CabbageIdentifierIds::audiochannel).isNotEmpty();
+        const Identifier source = usesAudioChannel ? CabbageIdentifierIds::audiochannel : CabbageIdentifierIds::signalvariable;
+        const String prefix = usesAudioChannel ? "audiochannel " : "";
+
+        if (displayType != "lissajous")
+        {
+            const String variable = CabbageWidgetData::getStringProp (widgetData, source);
+            signalDisplays[0] = owner->getSignalDisplay (prefix + variable, displayType);
+        }
+        else
+        {
+            const var variables = CabbageWidgetData::getProperty (widgetData, source);
+
+            if (variables.size() == 2)
+            {
+                signalDisplays[0] = owner->getSignalDisplay (prefix + variables[0].toString(), displayType);
+                signalDisplays[1] = owner->getSignalDisplay (prefix + variables[1].toString(), displayType);
+            }
+        }
     }
+
+    return signalDisplays[0] != nullptr && (displayType != "lissajous" || signalDisplays[1] != nullptr);
 }
 
 //====================================================================================
-void CabbageSignalDisplay::setSignalFloatArraysForLissajous (Array<float, CriticalSection> _points1, Array<float, CriticalSection> _points2)
+bool CabbageSignalDisplay::readLatestFrames()
 {
-    signalFloatArray.swapWith (_points1);
-    signalFloatArray2.swapWith (_points2);
-    vectorSize = signalFloatArray.size();
+    if (!findSignalDisplays())
+        return false;
+
+    //frames point straight into the processor's buffers, they are only good until the next read
+    signalFloatArray = signalDisplays[0]->getLatestFrame();
 
-    if (vectorSize > 0)
+    if (displayType == "lissajous")
     {
-        shouldPaint = true;
+        signalFloatArray2 = signalDisplays[1]->getLatestFrame();
+        vectorSize = signalFloatArray.size;
     }
+    else if (displayType == "waveform" && !signalDisplays[0]->fromAudioChannel)
+        vectorSize = signalFloatArray.size / 2;
+    else
+        vectorSize = signalFloatArray.size;
+
+    return vectorSize > 0;
 }
 
 //====================================================================================
 void CabbageSignalDisplay::timerCallback()
-{
-    const String variable = CabbageWidgetData::getStringProp (widgetData, CabbageIdentifierIds::signalvariable);
-    if (owner->shouldUpdateSignalDisplay(variable))
-    {
-        
-        const String signalDisplayType = CabbageWidgetData::getStringProp (widgetData, CabbageIdentifierIds::displaytype);
+{
+    //frames stay with the processor, nothing is lost by leaving them there while hidden
+    if (!isOnScreen() || !findSignalDisplays())
+        return;
 
-        if (signalDisplayType != "lissajous")
-        {
-            setSignalFloatArray (owner->getArrayForSignalDisplay (variable, signalDisplayType));
-        }
-        else
-        {
-            signalVariables = CabbageWidgetData::getProperty (widgetData, CabbageIdentifierIds::signalvariable);
+    const int frameNumber = signalDisplays[0]->getLatestFrame().number;
 
-            if (signalVariables.size() == 2)
-                setSignalFloatArraysForLissajous (owner->getArrayForSignalDisplay (signalVariables[0], signalDisplayType),
-                                                  owner->getArrayForSignalDisplay (signalVariables[1], signalDisplayType));
+    if (frameNumber == lastFrameNumber)
+        return;
 
-        }
+    lastFrameNumber = frameNumber;
+
+    if (readLatestFrames())
+    {
+        //spectrogram works on a scrolling image, the other displays are drawn directly
+        if (displayType == "spectrogram")
+            drawSonogram();
 
-        repaint();
+        shouldPaint = true;
     }
+
+    repaint();
 }
 
 //====================================================================================
@@ -337,6 +434,13 @@ void CabbageSignalDisplay::resized()
 {
     scrollbarHeight = jmin (15.0, getHeight() * .09);
 
+    //drawn one to one, so neither needs scaling when painted
+    numColumns = jmax (1, getWidth());
+    columnMinimums.malloc (numColumns);
+    columnMaximums.malloc (numColumns);
+    spectrogramImage = Image (Image::RGB, numColumns, jmax (1, getHeight()), true);
+    spectrogramColumn = 0;
+
     if (!shouldDrawSonogram)
     {
         freqRangeDisplay.setBounds (1, 0, getWidth(), 18);
@@ -354,6 +458,7 @@ void CabbageSignalDisplay::valueTreePropertyChanged (ValueTree& valueTree, const
     if (CabbageWidgetData::getStringProp (valueTree, CabbageIdentifierIds::displaytype) != displayType)
     {
         displayType = CabbageWidgetData::getStringProp (valueTree, CabbageIdentifierIds::displaytype);
+        signalDisplayVersionSeen = -1;
 
         shouldDrawSonogram = displayType == "spectrogram" ? true : false;
 
@@ -396,6 +501,7 @@ void CabbageSignalDisplay::valueTreePropertyChanged (ValueTree& valueTree, const
     if (signalVariables != CabbageWidgetData::getProperty (valueTree, CabbageIdentifierIds::signalvariable))
     {
         signalVariables = CabbageWidgetData::getProperty (valueTree, CabbageIdentifierIds::signalvariable);
+        signalDisplayVersionSeen = -1;
     }
 
     if (updateRate != CabbageWidgetData::getNumProp (valueTree, CabbageIdentifierIds::updaterate))
@@ -23,6 +23,7 @@
 
 #include "../CabbageCommonHeaders.h"
 #include "CabbageWidgetBase.h"
+#include "../Audio/Plugins/CsoundPluginProcessor.h"
 
 #include "Legacy/FrequencyRangeDisplayComponent.h"
 
@@ -34,8 +35,9 @@ class CabbageSignalDisplay : public Component, public ValueTree::Listener, publi
 
     String name, displayType;
     RoundButton zoomInButton, zoomOutButton;
-    Array<float, CriticalSection> signalFloatArray;
-    Array<float, CriticalSection> signalFloatArray2;
+    SignalDisplay::Ptr signalDisplays[2];
+    SignalDisplay::Frame signalFloatArray, signalFloatArray2;
+    int signalDisplayVersionSeen = -1, lastFrameNumber = 0;
     var signalVariables;
     int tableNumber, freq, shouldDrawSonogram, leftPos, scrollbarHeight,
         minFFTBin, maxFFTBin, vectorSize, zoomLevel, scopeWidth, lineThickness;
@@ -47,6 +49,8 @@ class CabbageSignalDisplay : public Component, public ValueTree::Listener, publi
     int updateRate {200};
 
     Image spectrogramImage, spectroscopeImage;
+    int spectrogramColumn = 0, numColumns = 0;
+    HeapBlock<float> columnMinimums, columnMaximums;
     FrequencyRangeDisplayComponent freqRangeDisplay;
     Range<int> freqRange;
 
@@ -70,12 +74,14 @@ public:
     void scrollBarMoved (ScrollBar* scrollBarThatHasMoved, double newRangeStart) override;
     void changeListenerCallback (ChangeBroadcaster* source) override;
     void drawSonogram();
+    void reduceToColumns (const SignalDisplay::Frame& points, int numPoints);
+    bool isOnScreen() const;
     void drawSpectroscope (Graphics& g);
     void drawWaveform (Graphics& g);
     void drawLissajous (Graphics& g);
     void paint (Graphics& g) override;
-    void setSignalFloatArray (Array<float, CriticalSection> _points);
-    void setSignalFloatArraysForLissajous (Array<float, CriticalSection> _points1, Array<float, CriticalSection> _points2);
+    bool findSignalDisplays();
+    bool readLatestFrames();
     void resized() override;
     void mouseMove (const MouseEvent& e) override;
     void showPopup (String text);
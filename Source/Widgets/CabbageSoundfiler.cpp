@@ -54,17 +54,8 @@ CabbageSoundfiler::CabbageSoundfiler (ValueTree wData, CabbagePluginEditor* _own
     
     for (int y = 0; y < tables.size(); y++)
     {
-        int tableNumber = tables[y];
-        tableValues.clear();
-        tableValues = owner->getTableFloats (tableNumber);
-        AudioBuffer<float> sampleBuffer;
-        sampleBuffer.setSize(1, tableValues.size());
-        //has to be a quicker way of doing this...
-        for ( int i = 0 ; i < tableValues.size() ; i++){
-            sampleBuffer.setSample(0, i, tableValues[i]);
-        }
-
-        setWaveform(sampleBuffer, 1);
+        tableNumber = tables[y];
+        updateTable (true);
     }
     
     if (CabbageWidgetData::getNumProp (wData, CabbageIdentifierIds::startpos) > -1 && CabbageWidgetData::getNumProp (wData, CabbageIdentifierIds::endpos) > 0)
@@ -108,6 +99,28 @@ void CabbageSoundfiler::setWaveform (AudioSampleBuffer buffer, int channels)
     soundfiler.setWaveform (buffer, channels);
 }
 
+void CabbageSoundfiler::updateTable (bool resetLength)
+{
+    const TableView tableView = owner->getTableView (tableNumber);
+
+    if (! tableView.isValid())
+        return;
+
+    if (resetLength)
+        tableTracker = TableChangeTracker();
+
+    const SparseSet<int> changedSamples = tableTracker.update (tableView);
+
+    if (resetLength || changedSamples.getTotalRange() == Range<int> (0, tableView.size))
+        soundfiler.setWaveformLength (tableView.size, 1);
+
+    for (int i = 0; i < changedSamples.getNumRanges(); i++)
+        tableView.readInBlocks (changedSamples.getRange (i), tableBlock, [this] (int startSample, const AudioSampleBuffer& block, int numSamples)
+        {
+            soundfiler.updateWaveform (block, startSample, numSamples);
+        });
+}
+
 int CabbageSoundfiler::getScrubberPosition()
 {
     return soundfiler.getCurrentPlayPosInSamples();
@@ -120,6 +133,14 @@ int CabbageSoundfiler::getLoopLength()
 
 void CabbageSoundfiler::valueTreePropertyChanged (ValueTree& valueTree, const Identifier& prop)
 {
+    if (prop == CabbageIdentifierIds::update)
+    {
+        if (CabbageWidgetData::getNumProp (valueTree, CabbageIdentifierIds::update) == 1)
+            updateTable (false);
+
+        return;
+    }
+
     if (file != CabbageWidgetData::getStringProp (valueTree, CabbageIdentifierIds::file))
     {
         file = CabbageWidgetData::getStringProp (valueTree, CabbageIdentifierIds::file);
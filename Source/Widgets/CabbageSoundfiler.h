@@ -22,6 +22,7 @@
 
 #include "../CabbageCommonHeaders.h"
 #include "CabbageWidgetBase.h"
+#include "../Audio/Plugins/CsoundPluginProcessor.h"
 #include "Legacy/Soundfiler.h"
 
 class CabbagePluginEditor;
@@ -39,7 +40,12 @@ class CabbageSoundfiler : public Component, public ValueTree::Listener, public C
     float scrubberPos;
 
     CabbagePluginEditor* owner;
-    Array <float, CriticalSection> tableValues;
+    //the table being shown is read from Csound a block at a time, and on update()
+    //only the blocks that changed are read again
+    int tableNumber = 0;
+    AudioSampleBuffer tableBlock { 1, 4096 };
+    TableChangeTracker tableTracker;
+    void updateTable (bool resetLength);
     
 public:
 
@@ -31,8 +31,16 @@ __attribute__((unused)) static CabbagePluginEditor* getPluginEditor(Component* c
 }
 
 
+CabbageWidgetBase::~CabbageWidgetBase()
+{
+    CabbageWidgetData::unregisterWidgetListener (this);
+}
+
 void CabbageWidgetBase::initialiseCommonAttributes (Component* child, ValueTree data)
 {
+    if (auto* listener = dynamic_cast<ValueTree::Listener*> (child))
+        CabbageWidgetData::registerWidgetListener (data, listener, this);
+
     toFront = -99;
     csdFile = CabbageWidgetData::getStringProp (data, CabbageIdentifierIds::csdfile);
     rotate = CabbageWidgetData::getNumProp (data, CabbageIdentifierIds::rotate);
@@ -36,7 +36,7 @@ class CabbageWidgetBase
 
 public:
     CabbageWidgetBase() {}
-    ~CabbageWidgetBase() {}
+    ~CabbageWidgetBase();
 
     int getActive() const
     {
@@ -31,6 +31,115 @@ constexpr unsigned long long int HashStringToInt (const char* str, unsigned long
     return (*str == 0) ? hash : 101 * HashStringToInt (str + 1) + *str;
 }
 //===============================================================================
+static bool isLineSpace (char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+CabbageWidgetData::IdentifierLexer::IdentifierLexer (const String& lineOfText) noexcept
+    : IdentifierLexer (lineOfText.toRawUTF8(), lineOfText.toRawUTF8() + lineOfText.getNumBytesAsUTF8())
+{
+}
+
+CabbageWidgetData::IdentifierLexer::IdentifierLexer (const char* text, const char* textEnd) noexcept
+    : position (text), end (textEnd)
+{
+    //anything after the last closing bracket is not part of an identifier
+    while (end > position && *(end - 1) != ')')
+        --end;
+
+    while (position < end && (*position == ')' || *position == ',' || *position == ' '))
+        ++position;
+}
+
+bool CabbageWidgetData::IdentifierLexer::next (Span& identifier, Span& arguments) noexcept
+{
+    while (position < end)
+    {
+        const char* start = position;
+        const char* close = position;
+
+        //brackets inside quoted text don't close an identifier
+        while (close < end && *close != ')')
+        {
+            if (*close == '\"')
+                while (++close < end && *close != '\"') {}
+
+            if (close < end)
+                ++close;
+        }
+
+        position = close < end ? close + 1 : end;
+
+        while (start < close && (isLineSpace (*start) || *start == ','))
+            ++start;
+
+        while (close > start && isLineSpace (*(close - 1)))
+            --close;
+
+        const char* open = start;
+
+        while (open < close && *open != '(')
+            ++open;
+
+        if (open == close)
+            continue;
+
+        identifier.start = start;
+        identifier.end = open;
+
+        while (identifier.end > identifier.start && isLineSpace (*(identifier.end - 1)))
+            --identifier.end;
+
+        if (identifier.isEmpty())
+            continue;
+
+        arguments.start = open + 1;
+        arguments.end = close;
+        return true;
+    }
+
+    return false;
+}
+
+unsigned long long CabbageWidgetData::IdentifierLexer::hash (Span identifier) noexcept
+{
+    const char* last = identifier.start;
+
+    while (last < identifier.end && *last != ':')
+        ++last;
+
+    if (last < identifier.end)
+        ++last;
+
+    //HashStringToInt() folds from the last character back to the first
+    unsigned long long result = 0;
+
+    for (const char* c = last; c > identifier.start;)
+        if (*--c != ' ')
+            result = 101 * result + *c;
+
+    return result;
+}
+
+void CabbageWidgetData::IdentifierLexer::getArguments (Span arguments, StringArray& tokens)
+{
+    tokens.clearQuick();
+
+    for (const char* start = arguments.start; start < arguments.end;)
+    {
+        const char* comma = start;
+        bool hasQuotes = false;
+
+        while (comma < arguments.end && *comma != ',')
+            hasQuotes = (*comma++ == '\"') || hasQuotes;
+
+        const String token = String (CharPointer_UTF8 (start), CharPointer_UTF8 (comma));
+        tokens.add (hasQuotes ? token.removeCharacters ("\"") : token);
+        start = comma + 1;
+    }
+}
+//===============================================================================
 void CabbageWidgetData::setWidgetState (ValueTree widgetData, String lineFromCsd, int ID)
 {
     setProperty (widgetData, "scalex", 1);
@@ -273,6 +382,8 @@ void CabbageWidgetData::setWidgetState (ValueTree widgetData, String lineFromCsd
 //===========================================================================================
 void CabbageWidgetData::setCustomWidgetState (ValueTree widgetData, String lineOfText, String currentIdentifier)
 {
+    //a line sets many properties, widgets are told about them together
+    PropertyTransaction transaction;
 
     //remove any text after a semicolon and take out tabs..
     lineOfText = lineOfText.replace ("\t", " ");
@@ -293,25 +404,18 @@ void CabbageWidgetData::setCustomWidgetState (ValueTree widgetData, String lineO
         lineOfText = lineOfText.substring (lineOfText.indexOf (typeOfWidget) + typeOfWidget.length()).trim();
     }
 
-    IdentifiersAndParameters identifierValueSet = getSetofIdentifiersAndParameters (lineOfText);
-
-    CabbageIdentifierStrings identifierArray;
-
+    IdentifierLexer lexer (lineOfText);
+    IdentifierLexer::Span identifierText, parameterText;
+    StringArray strTokens;
 
-    for ( int indx = 0 ; indx < identifierValueSet.identifier.size() ; indx++)
+    while (lexer.next (identifierText, parameterText))
     {
-        //CabbageUtilities::debug(identifierValueSet.identifier[indx]);
-        StringArray strTokens;
-        String identifier = identifierValueSet.identifier[indx].trimCharactersAtStart (" ");
-
-        if (identifier.indexOf (":") != -1)
-            identifier = identifier.substring (0, identifier.indexOf (":") + 1);
-
-        strTokens = CabbageUtilities::getTokens (identifierValueSet.parameter[indx], ',');
+        const String fullIdentifier = identifierText.toString().removeCharacters (" ");
+        const String identifier = fullIdentifier.upToFirstOccurrenceOf (":", true, false);
 
+        IdentifierLexer::getArguments (parameterText, strTokens);
 
-
-        switch (HashStringToInt (identifier.toStdString().c_str()))
+        switch (IdentifierLexer::hash (identifierText))
         {
             //======== strings ===============================
             case HashStringToInt ("kind"):
@@ -367,7 +471,7 @@ void CabbageWidgetData::setCustomWidgetState (ValueTree widgetData, String lineO
                 break;
             case HashStringToInt ("items:"):
             case HashStringToInt ("text:"):
-                setComboItemArrays (strTokens, widgetData, identifierValueSet.identifier[indx]);
+                setComboItemArrays (strTokens, widgetData, fullIdentifier);
                 break;
                 
             case HashStringToInt ("populate"):
@@ -400,10 +504,12 @@ void CabbageWidgetData::setCustomWidgetState (ValueTree widgetData, String lineO
             case HashStringToInt ("active"):
             case HashStringToInt ("automation"):
             case HashStringToInt ("automatable"):
+            case HashStringToInt ("autosleep"):
             case HashStringToInt ("alpha"):
             case HashStringToInt ("corners"):
             case HashStringToInt ("ffttablenumber"):
             case HashStringToInt ("fill"):
+            case HashStringToInt ("guiframerate"):
             case HashStringToInt ("guirefresh"):
             case HashStringToInt ("imgdebug"):
             case HashStringToInt ("increment"):
@@ -417,7 +523,10 @@ void CabbageWidgetData::setCustomWidgetState (ValueTree widgetData, String lineO
             case HashStringToInt ("markerthickness"):
             case HashStringToInt ("middlec"):
             case HashStringToInt ("mouseinteraction"):
+            case HashStringToInt ("offlineksmps"):
             case HashStringToInt ("outlinethickness"):
+            case HashStringToInt ("oversample"):
+            case HashStringToInt ("peakhold"):
             case HashStringToInt ("pivotx"):
             case HashStringToInt ("pivoty"):
             case HashStringToInt ("readonly"):
@@ -455,6 +564,11 @@ void CabbageWidgetData::setCustomWidgetState (ValueTree widgetData, String lineO
                 setProperty (widgetData, CabbageIdentifierIds::cropheight, strTokens[3].trim().getFloatValue());
                 break;
 
+            case HashStringToInt ("smoothing"):
+                setProperty (widgetData, CabbageIdentifierIds::smoothing, strTokens[0].trim().getFloatValue());
+                setProperty (widgetData, CabbageIdentifierIds::smoothingtype, strTokens.size() > 1 ? strTokens[1].trim().removeCharacters ("\"") : "linear");
+                break;
+
             case HashStringToInt ("max"):
                 setProperty (widgetData, CabbageIdentifierIds::maxenabled, 1);
                 setProperty (widgetData, CabbageIdentifierIds::max, strTokens[0].trim().getFloatValue());
@@ -492,6 +606,10 @@ void CabbageWidgetData::setCustomWidgetState (ValueTree widgetData, String lineO
                 setProperty (widgetData, CabbageIdentifierIds::signalvariable, getVarArrayFromTokens (strTokens));
                 break;
 
+            case HashStringToInt ("audiochannel"):
+                setProperty (widgetData, CabbageIdentifierIds::audiochannel, getVarArrayFromTokens (strTokens));
+                break;
+
             case HashStringToInt ("popup"):
             case HashStringToInt ("numberofsteps"):
             case HashStringToInt ("showstepnumbers"):
@@ -587,27 +705,27 @@ void CabbageWidgetData::setCustomWidgetState (ValueTree widgetData, String lineO
             case HashStringToInt ("colour"):
             case HashStringToInt ("fontcolour:"):
             case HashStringToInt ("fontcolour"):
-                setColourByNumber (strTokens, widgetData, identifierValueSet.identifier[indx]);
+                setColourByNumber (strTokens, widgetData, fullIdentifier);
                 break;
 
             case HashStringToInt ("tablecolour"):
             case HashStringToInt ("tablecolours"):
             case HashStringToInt ("tablecolour:"):
-                setColourArrays (strTokens, widgetData, identifierValueSet.identifier[indx]);
+                setColourArrays (strTokens, widgetData, fullIdentifier);
                 break;
 
             case HashStringToInt ("metercolour"):
             case HashStringToInt ("metercolour:"):
-                setColourArrays (strTokens, widgetData, identifierValueSet.identifier[indx], false);
+                setColourArrays (strTokens, widgetData, fullIdentifier, false);
                 break;
 
             //matrix event props
             case HashStringToInt ("celldata"):
-                setCellData(strTokens, identifierValueSet.parameter[indx], widgetData);
+                setCellData(strTokens, parameterText.toString().removeCharacters ("\""), widgetData);
                 break;
 			case HashStringToInt("rowprefix"):
 			case HashStringToInt("colprefix"):
-				setMatrixPrefix(strTokens, identifierValueSet.parameter[indx], widgetData, identifierValueSet.identifier[indx]);
+				setMatrixPrefix(strTokens, parameterText.toString().removeCharacters ("\""), widgetData, fullIdentifier);
 				break;
             case HashStringToInt( ("matrixsize")):
                 setMatrixSize(strTokens, widgetData);
@@ -634,36 +752,16 @@ var CabbageWidgetData::getVarArrayFromTokens (StringArray strTokens)
 
 CabbageWidgetData::IdentifiersAndParameters CabbageWidgetData::getSetofIdentifiersAndParameters (String lineOfText)
 {
-    StringArray identifiersInLine = CabbageUtilities::getTokens (lineOfText.substring (0, lineOfText.lastIndexOf (")")+1).trimCharactersAtStart ("), "), ')');
-//    CabbageUtilities::debug(identifiersInLine.joinIntoString(" - "));
-    StringArray parameters;
-
-    for ( int i = 0 ; i < identifiersInLine.size() ; i++)
-        identifiersInLine.set (i, identifiersInLine[i].trim().trimCharactersAtStart (" ,") + ")");
-
-    for ( int i = 0 ; i < identifiersInLine.size() ; i++)
-    {
-        String parameter = identifiersInLine[i];
-        parameter = parameter.substring (parameter.indexOf ("(") + 1, parameter.lastIndexOf (")")).trimCharactersAtStart ("\"").trimCharactersAtEnd ("\"");
-        parameters.add (parameter);
-    }
-
-    for ( int i = 0 ; i < identifiersInLine.size() ; i++)
-    {
-        const String newToken = identifiersInLine[i];
-        identifiersInLine.set (i, newToken.substring (0, newToken.indexOf ("(")));
-    }
-
     IdentifiersAndParameters valueSet;
-    identifiersInLine.removeEmptyStrings();
+    IdentifierLexer lexer (lineOfText);
+    IdentifierLexer::Span identifier, parameter;
 
-    for ( int i = 0 ; i < identifiersInLine.size() ; i++)
+    while (lexer.next (identifier, parameter))
     {
-        valueSet.identifier.add (identifiersInLine[i].removeCharacters(" "));
-        valueSet.parameter.add (parameters[i].removeCharacters ("\""));
+        valueSet.identifier.add (identifier.toString().removeCharacters (" "));
+        valueSet.parameter.add (parameter.toString().removeCharacters ("\""));
     }
 
-
     return valueSet;
 
 }
@@ -1272,7 +1370,7 @@ void CabbageWidgetData::setNumProp (ValueTree widgetData, Identifier prop, float
 
 void CabbageWidgetData::setStringProp (ValueTree widgetData, Identifier name, const String value)
 {
-    widgetData.setProperty (name, value, 0);
+    writeProperty (widgetData, name, value);
 }
 
 void CabbageWidgetData::setProperty (ValueTree widgetData, Identifier name, const var& value)
@@ -1286,15 +1384,204 @@ void CabbageWidgetData::setProperty (ValueTree widgetData, Identifier name, cons
         for ( int i = 0 ; i < array->size() ; i++)
             elements.append (array->getReference (i));
 
-        widgetData.setProperty (name, elements, 0);
+        writeProperty (widgetData, name, elements);
         return;
     }
 
-    widgetData.setProperty (name, value, 0);
+    writeProperty (widgetData, name, value);
+}
+
+//================================================================================================
+int CabbageWidgetData::transactionDepth = 0;
+Array<CabbageWidgetData::PendingProperties> CabbageWidgetData::pendingProperties;
+Array<CabbageWidgetData::WidgetListener> CabbageWidgetData::widgetListeners;
+
+CabbageWidgetData::PropertyTransaction::PropertyTransaction()
+    : isActive (MessageManager::existsAndIsCurrentThread())
+{
+    if (isActive)
+        ++transactionDepth;
+}
+
+CabbageWidgetData::PropertyTransaction::~PropertyTransaction()
+{
+    if (! isActive || --transactionDepth > 0)
+        return;
+
+    //listeners may write more properties, which now go through straight away
+    Array<PendingProperties> pending;
+    pending.swapWith (pendingProperties);
+
+    for (auto& properties : pending)
+        applyPendingProperties (properties);
+}
+
+void CabbageWidgetData::writeProperty (ValueTree widgetData, const Identifier& name, const var& value)
+{
+    if (transactionDepth == 0 || ! MessageManager::existsAndIsCurrentThread())
+    {
+        widgetData.setProperty (name, value, nullptr);
+        return;
+    }
+
+    if (name == CabbageIdentifierIds::update)
+    {
+        applyPendingProperties (widgetData);
+        widgetData.setProperty (name, value, nullptr);
+        return;
+    }
+
+    //new properties are announced straight away
+    if (! widgetData.hasProperty (name))
+    {
+        widgetData.setProperty (name, value, nullptr);
+        return;
+    }
+
+    PendingProperties* pending = findPendingProperties (widgetData);
+
+    if (pending == nullptr)
+    {
+        if (widgetData.getProperty (name).equalsWithSameType (value))
+            return;
+
+        pendingProperties.add ({ widgetData, {} });
+        pending = &pendingProperties.getReference (pendingProperties.size() - 1);
+    }
+
+    //a property written back to its old value is dropped by setProperty() when it's applied
+    pending->values.set (name, value);
+}
+
+CabbageWidgetData::PendingProperties* CabbageWidgetData::findPendingProperties (const ValueTree& widgetData)
+{
+    for (int i = pendingProperties.size(); --i >= 0;)
+        if (pendingProperties.getReference (i).widget == widgetData)
+            return &pendingProperties.getReference (i);
+
+    return nullptr;
+}
+
+void CabbageWidgetData::registerWidgetListener (ValueTree widgetData, ValueTree::Listener* listener, const void* owner)
+{
+    unregisterWidgetListener (owner);
+    widgetListeners.add ({ widgetData, listener, owner });
+}
+
+void CabbageWidgetData::unregisterWidgetListener (const void* owner)
+{
+    for (int i = widgetListeners.size(); --i >= 0;)
+        if (widgetListeners.getReference (i).owner == owner)
+            widgetListeners.remove (i);
+}
+
+//only a tree with a single registered widget can have its notifications merged
+ValueTree::Listener* CabbageWidgetData::findWidgetListener (const ValueTree& widgetData)
+{
+    ValueTree::Listener* found = nullptr;
+
+    for (auto& registered : widgetListeners)
+    {
+        if (registered.widget == widgetData)
+        {
+            if (found != nullptr)
+                return nullptr;
+
+            found = registered.listener;
+        }
+    }
+
+    return found;
+}
+
+//mirrors the properties that widgets test for by name in their valueTreePropertyChanged() methods
+bool CabbageWidgetData::isNotifiedIndividually (ValueTree widgetData, const Identifier& name)
+{
+    if (name == CabbageIdentifierIds::value)
+        return true;
+
+    const String type = getStringProp (widgetData, CabbageIdentifierIds::type);
+
+    if (type == CabbageWidgetTypes::hrange || type == CabbageWidgetTypes::vrange)
+        return name == CabbageIdentifierIds::minvalue || name == CabbageIdentifierIds::maxvalue;
+    if (type == CabbageWidgetTypes::xypad)
+        return name == CabbageIdentifierIds::valuex || name == CabbageIdentifierIds::valuey;
+    if (type == CabbageWidgetTypes::soundfiler)
+        return name == CabbageIdentifierIds::startpos || name == CabbageIdentifierIds::endpos;
+    if (type == CabbageWidgetTypes::combobox)
+        return name == CabbageIdentifierIds::populate || name == CabbageIdentifierIds::text;
+    if (type == CabbageWidgetTypes::eventsequencer)
+        return name == CabbageIdentifierIds::celldata;
+    if (type == CabbageWidgetTypes::image)
+        return name == CabbageIdentifierIds::width || name == CabbageIdentifierIds::height;
+
+    return false;
+}
+
+void CabbageWidgetData::applyPendingProperties (ValueTree widgetData)
+{
+    for (int i = 0; i < pendingProperties.size(); i++)
+    {
+        if (pendingProperties.getReference (i).widget == widgetData)
+        {
+            const PendingProperties pending = pendingProperties.removeAndReturn (i);
+            applyPendingProperties (pending);
+            return;
+        }
+    }
+}
+
+void CabbageWidgetData::applyPendingProperties (const PendingProperties& pending)
+{
+    ValueTree widget = pending.widget;
+    ValueTree::Listener* listener = findWidgetListener (widget);
+
+    if (listener == nullptr)
+    {
+        //the properties a widget handles by name go last, so that it sees its new ranges before any new value
+        for (auto& property : pending.values)
+            if (! isNotifiedIndividually (widget, property.name))
+                widget.setProperty (property.name, property.value, nullptr);
+
+        for (auto& property : pending.values)
+            if (isNotifiedIndividually (widget, property.name))
+                widget.setProperty (property.name, property.value, nullptr);
+
+        return;
+    }
+
+    Identifier lastChanged;
+    Array<Identifier> individuallyChanged;
+
+    for (auto& property : pending.values)
+    {
+        if (widget.getProperty (property.name).equalsWithSameType (property.value))
+            continue;
+
+        widget.setPropertyExcludingListener (listener, property.name, property.value, nullptr);
+
+        if (isNotifiedIndividually (widget, property.name))
+            individuallyChanged.add (property.name);
+        else
+            lastChanged = property.name;
+    }
+
+    //widgets refresh everything they don't test for by name, so any one of those properties will do
+    if (lastChanged.isValid())
+        listener->valueTreePropertyChanged (widget, lastChanged);
+
+    for (auto& name : individuallyChanged)
+        listener->valueTreePropertyChanged (widget, name);
 }
 
 var CabbageWidgetData::getProperty (ValueTree widgetData, Identifier name)
 {
+    //values written during a transaction are read back before they reach the tree
+    if (transactionDepth > 0 && MessageManager::existsAndIsCurrentThread())
+        if (PendingProperties* pending = findPendingProperties (widgetData))
+            if (var* value = pending->values.getVarPointer (name))
+                return *value;
+
     return widgetData.getProperty (name);
 }
 
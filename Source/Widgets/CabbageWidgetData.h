@@ -40,6 +40,40 @@ public:
         StringArray parameter;
     };
 
+    //============================================================================
+    // walks the identifiers of a widget line, e.g. bounds(10, 10, 60, 60), channel("gain")
+    // Spans point into the line's own UTF-8 text, so nothing is copied while lexing and
+    // the line must outlive the lexer
+    class IdentifierLexer
+    {
+    public:
+        struct Span
+        {
+            const char* start = nullptr;
+            const char* end = nullptr;
+
+            bool isEmpty() const noexcept      { return start == end; }
+            String toString() const            { return String (CharPointer_UTF8 (start), CharPointer_UTF8 (end)); }
+        };
+
+        explicit IdentifierLexer (const String& lineOfText) noexcept;
+        IdentifierLexer (const char* text, const char* textEnd) noexcept;
+
+        // identifier is the name before the brackets, arguments what is between them,
+        // returns false once there are no identifiers left
+        bool next (Span& identifier, Span& arguments) noexcept;
+
+        // same value as hashing the identifier text with spaces removed and cut after any ':'
+        static unsigned long long hash (Span identifier) noexcept;
+
+        // splits the arguments at each comma, quote characters are left out of the tokens
+        static void getArguments (Span arguments, StringArray& tokens);
+
+    private:
+        const char* position;
+        const char* end;
+    };
+
     CabbageWidgetData() {};
     ~CabbageWidgetData() {};
     //============================================================================
@@ -136,6 +170,53 @@ public:
     static ValueTree getValueTreeForComponent (ValueTree widgetData, String name, bool byChannel = false);
     static Rectangle<int> getBoundsFromText (String text);
     //const CabbageIdentifierStrings identifierArray;
+    //============================================================================
+    // Groups the property writes made on the message thread while it is in scope. Changes to
+    // existing properties are held back, and getProperty() returns the held value, until the
+    // outermost transaction ends. The held changes are then written to the tree without notifying
+    // the widget that registered for it, which gets a single valueTreePropertyChanged() for all of
+    // them, followed by one for each property its type handles by name. Other listeners, and
+    // widgets that never registered, see one call per property. A write to update applies the
+    // widget's held changes first, as listeners act on it straight away.
+    class PropertyTransaction
+    {
+    public:
+        PropertyTransaction();
+        ~PropertyTransaction();
+
+    private:
+        const bool isActive;
+        JUCE_DECLARE_NON_COPYABLE (PropertyTransaction)
+    };
+
+    // Widgets register the listener they add to their tree, so that a transaction can hand them
+    // their changes in one call. The owner is whatever pointer the widget unregisters with.
+    static void registerWidgetListener (ValueTree widgetData, ValueTree::Listener* listener, const void* owner);
+    static void unregisterWidgetListener (const void* owner);
+
+private:
+    struct WidgetListener
+    {
+        ValueTree widget;
+        ValueTree::Listener* listener;
+        const void* owner;
+    };
+
+    struct PendingProperties
+    {
+        ValueTree widget;
+        NamedValueSet values;
+    };
+
+    static void writeProperty (ValueTree widgetData, const Identifier& name, const var& value);
+    static PendingProperties* findPendingProperties (const ValueTree& widgetData);
+    static bool isNotifiedIndividually (ValueTree widgetData, const Identifier& name);
+    static void applyPendingProperties (ValueTree widgetData);
+    static void applyPendingProperties (const PendingProperties& pending);
+    static ValueTree::Listener* findWidgetListener (const ValueTree& widgetData);
+    static int transactionDepth;
+    static Array<PendingProperties> pendingProperties;
+    static Array<WidgetListener> widgetListeners;
 };
 
 #endif
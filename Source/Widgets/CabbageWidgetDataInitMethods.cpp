@@ -333,6 +333,8 @@ void CabbageWidgetData::setSignalDisplayProperties (ValueTree widgetData, int ID
     setProperty (widgetData, CabbageIdentifierIds::max, 2048);
     setProperty (widgetData, CabbageIdentifierIds::updaterate, 100);
     setProperty (widgetData, CabbageIdentifierIds::signalvariable, signalVariables);
+    setProperty (widgetData, CabbageIdentifierIds::audiochannel, signalVariables);
+    setProperty (widgetData, CabbageIdentifierIds::peakhold, 0);
     setProperty (widgetData, CabbageIdentifierIds::outlinethickness, 1);
     setProperty (widgetData, CabbageIdentifierIds::name, getProperty (widgetData, "name").toString() + String (ID));
     setProperty (widgetData, CabbageIdentifierIds::identchannel, "");
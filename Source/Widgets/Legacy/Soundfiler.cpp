@@ -51,6 +51,416 @@ public:
     }
 
 };
+//==============================================================================
+// waveform overviews
+//==============================================================================
+WaveformOverview::WaveformOverview (const File& source, const File& cache, AudioFormatManager& formats):
+    sourceFile (source),
+    cacheFile (cache),
+    sourceSize (source.getSize()),
+    sourceModificationTime (source.getLastModificationTime().toMilliseconds()),
+    formatManager (formats)
+{
+}
+
+WaveformOverview::~WaveformOverview()
+{
+}
+
+void WaveformOverview::setNumSamples (int64 newNumSamples)
+{
+    numSamples = newNumSamples;
+    levelOffsets.clearQuick();
+    levelSizes.clearQuick();
+    totalPoints = 0;
+
+    //level 0 has a point for every samplesPerPoint samples, each level above halves that
+    int64 levelSize = jmax ((int64) 1, (numSamples + samplesPerPoint - 1) / samplesPerPoint);
+
+    for (;;)
+    {
+        levelOffsets.add (totalPoints);
+        levelSizes.add (levelSize);
+        totalPoints += levelSize * numChannels;
+
+        if (levelSize == 1)
+            break;
+
+        levelSize = (levelSize + 1) / 2;
+    }
+}
+
+int64 WaveformOverview::getNumPointsReady (int level) const noexcept
+{
+    if (isComplete())
+        return levelSizes.getUnchecked (level);
+
+    return numSamplesReady.load() / ((int64) samplesPerPoint << level);
+}
+
+bool WaveformOverview::loadFromCache()
+{
+    std::unique_ptr<MemoryMappedFile> mapped (new MemoryMappedFile (cacheFile, MemoryMappedFile::readOnly));
+
+    if (mapped->getData() == nullptr || mapped->getSize() < sizeof (Header))
+        return false;
+
+    Header header;
+    memcpy (&header, mapped->getData(), sizeof (Header));
+
+    if (memcmp (header.magic, "CWOV", 4) != 0 || header.version != 1
+        || header.samplesPerPoint != samplesPerPoint
+        || header.sourceSize != sourceSize || header.sourceModificationTime != sourceModificationTime
+        || ! isPositiveAndNotGreaterThan (header.numChannels, (int32) maxChannels) || header.numChannels == 0
+        || header.numSamples <= 0)
+        return false;
+
+    numChannels = header.numChannels;
+    setNumSamples (header.numSamples);
+
+    if (mapped->getSize() < sizeof (Header) + (size_t) totalPoints * sizeof (Point))
+        return false;
+
+    points = reinterpret_cast<const Point*> (static_cast<const char*> (mapped->getData()) + sizeof (Header));
+    mappedCache = std::move (mapped);
+    numSamplesReady = numSamples;
+    //pruning goes by modification time, so mark this one as recently used
+    cacheFile.setLastModificationTime (Time::getCurrentTime());
+    return true;
+}
+
+bool WaveformOverview::startBuilding()
+{
+    reader.reset (WaveformOverviewCache::createReaderFor (formatManager, sourceFile));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0)
+        return false;
+
+    numChannels = (int) jlimit (1u, (unsigned int) maxChannels, reader->numChannels);
+    setNumSamples (reader->lengthInSamples);
+    builtPoints.calloc ((size_t) totalPoints);
+    points = builtPoints;
+    window.setSize (numChannels, windowSize);
+    return true;
+}
+
+int WaveformOverview::useTimeSlice()
+{
+    const int64 position = numSamplesReady.load();
+    const int numToRead = (int) jmin ((int64) windowSize, numSamples - position);
+
+    if (reader == nullptr || numToRead <= 0)
+        return -1;
+
+    reader->read (&window, 0, numToRead, position, true, true);
+
+    //windows start on a point boundary, so every level 0 point they touch is complete
+    int64 start = position / samplesPerPoint;
+    int64 end = start + (numToRead + samplesPerPoint - 1) / samplesPerPoint;
+
+    for (int64 index = start; index < end; index++)
+    {
+        const int offset = (int) ((index - start) * samplesPerPoint);
+        const int length = jmin ((int) samplesPerPoint, numToRead - offset);
+
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            const float* samples = window.getReadPointer (channel, offset);
+            const Range<float> range = FloatVectorOperations::findMinAndMax (samples, length);
+            float sumOfSquares = 0.f;
+
+            for (int i = 0; i < length; i++)
+                sumOfSquares += samples[i] * samples[i];
+
+            Point& point = builtPoints[levelOffsets[0] + index * numChannels + channel];
+            point.minimum = (int8) jlimit (-127, 127, roundToInt (range.getStart() * 127.f));
+            point.maximum = (int8) jlimit (-127, 127, roundToInt (range.getEnd() * 127.f));
+            point.rms = (uint8) jlimit (0, 255, roundToInt (std::sqrt (sumOfSquares / length) * 255.f));
+        }
+    }
+
+    //the last point of each level above may only have half its input yet, it gets
+    //recalculated along with the next window
+    for (int level = 1; level < levelSizes.size(); level++)
+    {
+        start /= 2;
+        end = (end + 1) / 2;
+
+        for (int64 index = start; index < end; index++)
+        {
+            for (int channel = 0; channel < numChannels; channel++)
+            {
+                const Point& first = getPoint (level - 1, index * 2, channel);
+                const Point& second = (index * 2 + 1 < levelSizes[level - 1] ? getPoint (level - 1, index * 2 + 1, channel) : first);
+
+                Point& point = builtPoints[levelOffsets[level] + index * numChannels + channel];
+                point.minimum = jmin (first.minimum, second.minimum);
+                point.maximum = jmax (first.maximum, second.maximum);
+                point.rms = (uint8) roundToInt (std::sqrt ((first.rms * first.rms + second.rms * second.rms) * 0.5f));
+            }
+        }
+    }
+
+    numSamplesReady = position + numToRead;
+    sendChangeMessage();
+
+    if (isComplete())
+    {
+        reader.reset();
+        window.setSize (1, 0);
+        writeToCache();
+        return -1;
+    }
+
+    return 0;
+}
+
+void WaveformOverview::writeToCache()
+{
+    Header header;
+    memcpy (header.magic, "CWOV", 4);
+    header.version = 1;
+    header.numChannels = numChannels;
+    header.samplesPerPoint = samplesPerPoint;
+    header.numSamples = numSamples;
+    header.sourceSize = sourceSize;
+    header.sourceModificationTime = sourceModificationTime;
+
+    TemporaryFile temp (cacheFile);
+
+    {
+        FileOutputStream out (temp.getFile());
+
+        if (! out.openedOk()
+            || ! out.write (&header, sizeof (Header))
+            || ! out.write (builtPoints, (size_t) totalPoints * sizeof (Point)))
+            return;
+    }
+
+    if (temp.overwriteTargetFileWithTemporary())
+        WaveformOverviewCache::pruneCacheDirectory (cacheFile.getParentDirectory(), cacheFile);
+}
+
+void WaveformOverview::drawChannels (Graphics& g, Rectangle<int> area, Range<double> sampleRange, Colour colour, float verticalZoom)
+{
+    if (area.isEmpty() || sampleRange.getLength() <= 0.0 || points == nullptr)
+        return;
+
+    const double samplesPerPixel = sampleRange.getLength() / area.getWidth();
+
+    if (samplesPerPixel < samplesPerPoint && drawSamples (g, area, sampleRange, colour, verticalZoom))
+        return;
+
+    //the coarsest level that still has at least one point per pixel
+    int level = 0;
+
+    while (level + 1 < levelSizes.size() && (double) ((int64) samplesPerPoint << (level + 1)) <= samplesPerPixel)
+        level++;
+
+    const double pointsPerSample = 1.0 / (double) ((int64) samplesPerPoint << level);
+    const int64 numPointsReady = getNumPointsReady (level);
+    const float channelHeight = area.getHeight() / (float) numChannels;
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        RectangleList<float> peaks, levels;
+        const float centre = area.getY() + channelHeight * (channel + 0.5f);
+        const float scale = channelHeight * 0.5f * verticalZoom / 127.f;
+
+        for (int x = 0; x < area.getWidth(); x++)
+        {
+            const int64 first = (int64) ((sampleRange.getStart() + x * samplesPerPixel) * pointsPerSample);
+            const int64 last = jmin (numPointsReady, jmax (first + 1, (int64) std::ceil ((sampleRange.getStart() + (x + 1) * samplesPerPixel) * pointsPerSample)));
+
+            if (first >= last)
+                break;
+
+            int minimum = 127, maximum = -127;
+            float sumOfSquares = 0.f;
+
+            for (int64 index = first; index < last; index++)
+            {
+                const Point& point = getPoint (level, index, channel);
+                minimum = jmin (minimum, (int) point.minimum);
+                maximum = jmax (maximum, (int) point.maximum);
+                sumOfSquares += (float) point.rms * point.rms;
+            }
+
+            const float rms = std::sqrt (sumOfSquares / (last - first)) * (127.f / 255.f);
+            peaks.addWithoutMerging ({ (float) (area.getX() + x), centre - maximum * scale, 1.f, jmax (1.f, (maximum - minimum) * scale) });
+            levels.addWithoutMerging ({ (float) (area.getX() + x), centre - rms * scale, 1.f, rms * scale * 2.f });
+        }
+
+        g.setColour (colour);
+        g.fillRectList (peaks);
+        g.setColour (colour.brighter (0.6f));
+        g.fillRectList (levels);
+    }
+}
+
+bool WaveformOverview::drawSamples (Graphics& g, Rectangle<int> area, Range<double> sampleRange, Colour colour, float verticalZoom)
+{
+    if (detailReader == nullptr)
+        detailReader.reset (WaveformOverviewCache::createReaderFor (formatManager, sourceFile));
+
+    if (detailReader == nullptr)
+        return false;
+
+    //fewer than samplesPerPoint samples per pixel, so this is never more than a few windows
+    const int64 start = jmax ((int64) 0, (int64) sampleRange.getStart());
+    const int numToRead = (int) jmin (numSamples - start, (int64) std::ceil (sampleRange.getEnd()) - start + 1);
+
+    if (numToRead <= 0)
+        return true;
+
+    detail.setSize (numChannels, numToRead, false, false, true);
+    detailReader->read (&detail, 0, numToRead, start, true, true);
+
+    const double samplesPerPixel = sampleRange.getLength() / area.getWidth();
+    const float channelHeight = area.getHeight() / (float) numChannels;
+
+    for (int channel = 0; channel < numChannels; channel++)
+    {
+        RectangleList<float> peaks;
+        const float centre = area.getY() + channelHeight * (channel + 0.5f);
+        const float scale = channelHeight * 0.5f * verticalZoom;
+
+        for (int x = 0; x < area.getWidth(); x++)
+        {
+            const int first = (int) ((int64) (sampleRange.getStart() + x * samplesPerPixel) - start);
+            const int last = jmin (numToRead, jmax (first + 1, (int) ((int64) std::ceil (sampleRange.getStart() + (x + 1) * samplesPerPixel) - start)));
+
+            if (first >= last)
+                break;
+
+            const Range<float> range = FloatVectorOperations::findMinAndMax (detail.getReadPointer (channel, first), last - first);
+            peaks.addWithoutMerging ({ (float) (area.getX() + x), centre - range.getEnd() * scale, 1.f, jmax (1.f, range.getLength() * scale) });
+        }
+
+        g.setColour (colour);
+        g.fillRectList (peaks);
+    }
+
+    return true;
+}
+
+//==============================================================================
+WaveformOverviewCache::WaveformOverviewCache():
+    cacheDirectory (CabbageUtilities::getStorageProps().getDefaultFile().getSiblingFile ("WaveformOverviews")),
+    thread ("Waveform overviews")
+{
+    formatManager.registerBasicFormats();
+    cacheDirectory.createDirectory();
+    thread.startThread (2);
+}
+
+WaveformOverviewCache::~WaveformOverviewCache()
+{
+    for (int i = 0; i < overviews.size(); i++)
+        thread.removeTimeSliceClient (overviews.getUnchecked (i));
+
+    thread.stopThread (2000);
+}
+
+WaveformOverview::Ptr WaveformOverviewCache::getOverview (const File& file)
+{
+    if (! file.existsAsFile())
+        return nullptr;
+
+    //finished overviews nobody is drawing any more can be mapped back in if needed. One that
+    //has just finished may still be inside its last time slice writing the cache, and the
+    //thread touches it again afterwards, so it is taken off the thread before it's let go.
+    //removeTimeSliceClient() waits for a running slice to return
+    for (int i = overviews.size(); --i >= 0;)
+    {
+        WaveformOverview* overview = overviews.getUnchecked (i);
+
+        if (overview->getReferenceCount() == 1 && overview->isComplete())
+        {
+            thread.removeTimeSliceClient (overview);
+            overviews.remove (i);
+        }
+    }
+
+    for (int i = 0; i < overviews.size(); i++)
+    {
+        WaveformOverview* existing = overviews.getUnchecked (i);
+
+        if (existing->getFile() == file
+            && existing->sourceSize == file.getSize()
+            && existing->sourceModificationTime == file.getLastModificationTime().toMilliseconds())
+            return existing;
+    }
+
+    WaveformOverview::Ptr overview (new WaveformOverview (file, getCacheFile (file), formatManager));
+
+    if (overview->loadFromCache())
+    {
+        overviews.add (overview);
+    }
+    else if (overview->startBuilding())
+    {
+        overviews.add (overview);
+        thread.addTimeSliceClient (overview.get());
+    }
+    else
+        return nullptr;
+
+    return overview;
+}
+
+File WaveformOverviewCache::getCacheFile (const File& file) const
+{
+    return cacheDirectory.getChildFile (String::toHexString (file.getFullPathName().hashCode64()) + ".overview");
+}
+
+void WaveformOverviewCache::pruneCacheDirectory (const File& directory, const File& fileToKeep)
+{
+    Array<File> files;
+    directory.findChildFiles (files, File::findFiles, false, "*.overview");
+
+    //oldest first
+    std::sort (files.begin(), files.end(), [] (const File& a, const File& b)
+    {
+        return a.getLastModificationTime() < b.getLastModificationTime();
+    });
+
+    const Time oldest = Time::getCurrentTime() - RelativeTime::days (maxCacheAgeDays);
+    int64 totalBytes = 0;
+
+    for (auto& file : files)
+        totalBytes += file.getSize();
+
+    for (auto& file : files)
+    {
+        if (file == fileToKeep)
+            continue;
+
+        if (totalBytes <= maxCacheBytes && file.getLastModificationTime() >= oldest)
+            break;
+
+        const int64 size = file.getSize();
+
+        if (file.deleteFile())
+            totalBytes -= size;
+    }
+}
+
+//wav and aiff files are mapped rather than read through a stream
+AudioFormatReader* WaveformOverviewCache::createReaderFor (AudioFormatManager& formats, const File& file)
+{
+    if (AudioFormat* format = formats.findFormatForFileExtension (file.getFileExtension()))
+    {
+        std::unique_ptr<MemoryMappedAudioFormatReader> mappedReader (format->createMemoryMappedReader (file));
+
+        if (mappedReader != nullptr && mappedReader->mapEntireFile())
+            return mappedReader.release();
+    }
+
+    return formats.createReaderFor (file);
+}
+
+
 //==============================================================================
 // soundfiler display  component
 //==============================================================================
@@ -93,6 +503,9 @@ Soundfiler::Soundfiler (int sr, Colour col, Colour bgcol):
 //==============================================================================
 Soundfiler::~Soundfiler()
 {
+    if (overview != nullptr)
+        overview->removeChangeListener (this);
+
     scrollbar->removeListener (this);
     thumbnail->removeChangeListener (this);
 }
@@ -108,6 +521,12 @@ void Soundfiler::changeListenerCallback (ChangeBroadcaster* source)
         else
             setZoomFactor (jmax (0.0, zoom -= 0.1));
     }
+    else if (source == thumbnail.get() && ! pendingWaveformArea.isEmpty())
+    {
+        repaint (pendingWaveformArea);
+        pendingWaveformArea = {};
+        return;
+    }
 
     repaint();
 }
@@ -137,29 +556,36 @@ void Soundfiler::setFile (const File& file)
 {
     if (! file.isDirectory())
     {
-        AudioFormatManager format;
-        format.registerBasicFormats();
-        //registers wav and aif format (just nescearry one time if you alays use the "getInstance()" method)
-        AudioFormatReader* reader = format.createReaderFor (file);
-
-        //creates a reader for the result file (may file, if the result/opened file is no wav or aif)
-        if (reader) //if a reader got created
+        //fails if the file is not one of the basic formats, the overview may still be
+        //filling in, or may have been mapped straight from the disk cache
+        if (WaveformOverview::Ptr newOverview = overviewCache->getOverview (file))
         {
-            AudioBuffer<float> buffer(reader->numChannels, (int)reader->lengthInSamples);
-            buffer.clear();
-            reader->read (&buffer, 0, buffer.getNumSamples(), 0, true, true);
-            setWaveform (buffer, reader->numChannels);
+            setWaveformLength ((int) jmin ((int64) std::numeric_limits<int>::max(), newOverview->getNumSamples()),
+                               newOverview->getNumChannels());
+            setOverview (newOverview);
         }
-
-        delete reader;
     }
 
     repaint (0, 0, getWidth(), getHeight());
 }
 
+void Soundfiler::setOverview (WaveformOverview::Ptr newOverview)
+{
+    if (overview != nullptr)
+        overview->removeChangeListener (this);
+
+    overview = newOverview;
+
+    if (overview != nullptr)
+        overview->addChangeListener (this);
+
+    repaint();
+}
+
 //==============================================================================
 void Soundfiler::setWaveform (AudioSampleBuffer buffer, int channels)
 {
+    setOverview (nullptr);
     thumbnail->clear();
     repaint();
     thumbnail->reset (channels, 44100, buffer.getNumSamples());
@@ -172,6 +598,29 @@ void Soundfiler::setWaveform (AudioSampleBuffer buffer, int channels)
     repaint();
 }
 
+void Soundfiler::setWaveformLength (int numSamples, int channels)
+{
+    setOverview (nullptr);
+    thumbnail->reset (channels, 44100, numSamples);
+    const Range<double> newRange (0.0, numSamples / 44100.0);
+    scrollbar->setRangeLimits (newRange);
+    setRange (newRange);
+    setZoomFactor (zoom);
+    pendingWaveformArea = {};
+    repaint();
+}
+
+void Soundfiler::updateWaveform (const AudioSampleBuffer& block, int startSample, int numSamples)
+{
+    thumbnail->addBlock (startSample, block, 0, numSamples);
+
+    const int x1 = jmax (0, (int) std::floor (timeToX (startSample / 44100.0)) - 1);
+    const int x2 = jmin (getWidth(), (int) std::ceil (timeToX ((startSample + numSamples) / 44100.0)) + 1);
+
+    if (x2 > x1)
+        pendingWaveformArea = pendingWaveformArea.getUnion ({ x1, 0, x2 - x1, getHeight() });
+}
+
 //==============================================================================
 void Soundfiler::setZoomFactor (double amount)
 {
@@ -215,8 +664,12 @@ void Soundfiler::paint (Graphics& g)
         Rectangle<int> thumbArea (getLocalBounds());
         thumbArea.setHeight (getHeight() - 14);
         thumbArea.setTop (10.f);
-        thumbnail->drawChannels (g, thumbArea.reduced (2),
-                                 visibleRange.getStart(), visibleRange.getEnd(), .8f);
+
+        if (overview != nullptr)
+            overview->drawChannels (g, thumbArea.reduced (2), { visibleRange.getStart() * 44100.0, visibleRange.getEnd() * 44100.0 }, colour, .8f);
+        else
+            thumbnail->drawChannels (g, thumbArea.reduced (2),
+                                     visibleRange.getStart(), visibleRange.getEnd(), .8f);
 
         //if(regionWidth>1){
         g.setColour (colour.contrasting (.5f).withAlpha (.7f));
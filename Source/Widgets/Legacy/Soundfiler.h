@@ -23,6 +23,126 @@
 #include "../../CabbageCommonHeaders.h"
 
 class ZoomButton;
+class WaveformOverviewCache;
+
+//=================================================================
+// A min/max/RMS overview of a sound file, kept as a pyramid. Each level summarises
+// twice as many samples per point as the one below it, and drawing reads only the
+// level that matches the zoom, so a repaint costs the same however long the file is.
+// When zoomed in past the finest level the visible samples are read from the file.
+// Overviews are built on WaveformOverviewCache's thread, a window of the file at a
+// time, and can be drawn while they are still filling in.
+//=================================================================
+class WaveformOverview : public ReferenceCountedObject,
+    public ChangeBroadcaster,
+    private TimeSliceClient
+{
+public:
+    using Ptr = ReferenceCountedObjectPtr<WaveformOverview>;
+    enum { samplesPerPoint = 128, maxChannels = 2 };
+
+    ~WaveformOverview();
+
+    const File& getFile() const noexcept        { return sourceFile; }
+    int getNumChannels() const noexcept         { return numChannels; }
+    int64 getNumSamples() const noexcept        { return numSamples; }
+    bool isComplete() const noexcept            { return numSamplesReady.load() >= numSamples; }
+
+    //sampleRange is in samples of the file, each channel gets its own strip of area
+    void drawChannels (Graphics& g, Rectangle<int> area, Range<double> sampleRange, Colour colour, float verticalZoom);
+
+private:
+    friend class WaveformOverviewCache;
+    enum { windowSize = 256 * samplesPerPoint };
+
+    struct Point
+    {
+        int8 minimum, maximum;
+        uint8 rms;
+    };
+
+    //the on-disk format is this header followed by every level's points, channels interleaved
+    struct Header
+    {
+        char magic[4];
+        int32 version, numChannels, samplesPerPoint;
+        int64 numSamples, sourceSize, sourceModificationTime;
+    };
+
+    WaveformOverview (const File& source, const File& cache, AudioFormatManager& formats);
+
+    bool loadFromCache();
+    bool startBuilding();
+    int useTimeSlice() override;
+    void writeToCache();
+    bool drawSamples (Graphics& g, Rectangle<int> area, Range<double> sampleRange, Colour colour, float verticalZoom);
+
+    void setNumSamples (int64 newNumSamples);
+    int64 getNumPointsReady (int level) const noexcept;
+    const Point& getPoint (int level, int64 index, int channel) const noexcept
+    {
+        return points[levelOffsets.getUnchecked (level) + index * numChannels + channel];
+    }
+
+    const File sourceFile, cacheFile;
+    const int64 sourceSize, sourceModificationTime;
+    AudioFormatManager& formatManager;
+
+    int numChannels = 1;
+    int64 numSamples = 0, totalPoints = 0;
+    Array<int64> levelOffsets, levelSizes;
+    const Point* points = nullptr;
+    std::atomic<int64> numSamplesReady { 0 };
+
+    //one of these holds the points, depending on whether they were mapped from the cache or built
+    std::unique_ptr<MemoryMappedFile> mappedCache;
+    HeapBlock<Point> builtPoints;
+
+    //used by the cache's thread while building
+    std::unique_ptr<AudioFormatReader> reader;
+    AudioSampleBuffer window;
+
+    //used on the message thread when zoomed in past the finest level
+    std::unique_ptr<AudioFormatReader> detailReader;
+    AudioSampleBuffer detail;
+
+    JUCE_DECLARE_NON_COPYABLE (WaveformOverview)
+};
+
+//=================================================================
+// Hands out WaveformOverviews, one per file for the whole process. Finished overviews
+// are written under the user settings folder, keyed by the file's path, size and
+// modification time, and are memory-mapped back in the next time the file is opened.
+// Hold one through a SharedResourcePointer for as long as overviews are in use.
+//=================================================================
+class WaveformOverviewCache
+{
+public:
+    WaveformOverviewCache();
+    ~WaveformOverviewCache();
+
+    //returns nullptr if the file can't be read
+    WaveformOverview::Ptr getOverview (const File& file);
+
+    static AudioFormatReader* createReaderFor (AudioFormatManager& formats, const File& file);
+    //deletes overviews unused for maxCacheAgeDays, then the least recently used until the
+    //folder is under maxCacheBytes. Called on the cache's thread after each new overview
+    static void pruneCacheDirectory (const File& directory, const File& fileToKeep);
+
+private:
+    enum { maxCacheAgeDays = 90 };
+    static const int64 maxCacheBytes = 256 * 1024 * 1024;
+
+    File getCacheFile (const File& file) const;
+
+    AudioFormatManager formatManager;
+    File cacheDirectory;
+    TimeSliceThread thread;
+    ReferenceCountedArray<WaveformOverview> overviews;
+
+    JUCE_DECLARE_NON_COPYABLE (WaveformOverviewCache)
+};
+
 //=================================================================
 // display a sound file as a waveform..
 //=================================================================
@@ -87,6 +207,10 @@ public:
     void setFile (const File& file);
     void mouseWheelMove (const MouseEvent&, const MouseWheelDetails& wheel) override;
     void setWaveform (AudioSampleBuffer buffer, int channels);
+    //for waveforms that arrive in pieces, sizes an empty thumbnail and then fills in
+    //one block at a time, repainting only the stretch of the display each block covers
+    void setWaveformLength (int numSamples, int channels);
+    void updateWaveform (const AudioSampleBuffer& block, int startSample, int numSamples);
     void createImage (String filename);
     void setRange (Range<double> newRange);
     void showScrollbars (bool show);
@@ -101,6 +225,7 @@ private:
     double zoom;
     std::unique_ptr<DrawableRectangle> currentPositionMarker;
     std::unique_ptr<ScrollBar> scrollbar;
+    Rectangle<int> pendingWaveformArea;
     
     void resized() override;
     void paint (Graphics& g) override;
@@ -121,6 +246,10 @@ private:
     Image waveformImage;
     AudioThumbnailCache thumbnailCache;
     std::unique_ptr<AudioThumbnail> thumbnail;
+    //files are drawn from a shared overview, tables from the thumbnail
+    SharedResourcePointer<WaveformOverviewCache> overviewCache;
+    WaveformOverview::Ptr overview;
+    void setOverview (WaveformOverview::Ptr newOverview);
     Colour colour, bgColour;
     int mouseDownX, mouseUpX;
     Rectangle<int> localBounds;
@@ -492,6 +492,29 @@ void TableManager::setWaveform (AudioSampleBuffer buffer, int ftNumber)
         }
 }
 
+//==============================================================================
+// sizes a large table's display without any samples, and then fills in the parts
+// that change, so that a table update only costs as much as the blocks it touched
+void TableManager::setWaveformLength (int numSamples, int ftNumber)
+{
+    for ( int i = 0; i < tables.size(); i++)
+        if (ftNumber == tables[i]->tableNumber)
+        {
+            tables[i]->setWaveformLength (numSamples);
+            return;
+        }
+}
+
+void TableManager::updateWaveform (const AudioSampleBuffer& block, int startSample, int numSamples, int ftNumber)
+{
+    for ( int i = 0; i < tables.size(); i++)
+        if (ftNumber == tables[i]->tableNumber)
+        {
+            tables[i]->updateWaveform (block, startSample, numSamples);
+            return;
+        }
+}
+
 //==============================================================================
 void TableManager::setFile (const File file)
 {
@@ -599,6 +622,9 @@ GenTable::~GenTable()
 {
     scrollbar->removeListener (this);
 
+    if (overview != nullptr)
+        overview->removeChangeListener (this);
+
     if (thumbnail)
         thumbnail->removeChangeListener (this);
 }
@@ -660,6 +686,12 @@ void GenTable::setAmpRanges (var ampRange)
 //==============================================================================
 void GenTable::changeListenerCallback (ChangeBroadcaster* source)
 {
+    if (source == overview.get())
+    {
+        repaint();
+        return;
+    }
+
     currentHandle = dynamic_cast<HandleComponent*> (source);
 
     if (currentHandle)
@@ -725,24 +757,16 @@ void GenTable::scrollBarMoved (ScrollBar* scrollBarThatHasMoved, double /*newRan
 
 void GenTable::setFile (const File& file)
 {
-    if (file.existsAsFile())
+    if (file.existsAsFile() && thumbnail != nullptr)
     {
         genRoutine = 1;
-        AudioFormatManager format;
-        format.registerBasicFormats();
 
-        AudioFormatReader* reader = format.createReaderFor (file);
-
-        if (reader) //if a reader got created
+        if (WaveformOverview::Ptr newOverview = overviewCache->getOverview (file))
         {
-            AudioSampleBuffer buffer (reader->numChannels, (int)reader->lengthInSamples);
-            buffer.clear();
-            buffer.setSize (reader->numChannels, (int)reader->lengthInSamples);
-            reader->read (&buffer, 0, buffer.getNumSamples(), 0, true, true);
-            setWaveform (buffer);
+            //the thumbnail is kept empty, it only provides the length for zooming and scrolling
+            setWaveformLength ((int) jmin ((int64) std::numeric_limits<int>::max(), newOverview->getNumSamples()));
+            setOverview (newOverview);
         }
-
-        delete reader;
     }
 
     repaint (0, 0, getWidth(), getHeight());
@@ -802,6 +826,7 @@ void GenTable::setWaveform (AudioSampleBuffer buffer)
     {
         tableSize = buffer.getNumSamples();
         genRoutine = 1;
+        setOverview (nullptr);
         thumbnail->clear();
         repaint();
         thumbnail->reset (buffer.getNumChannels(), 44100, buffer.getNumSamples());
@@ -814,6 +839,45 @@ void GenTable::setWaveform (AudioSampleBuffer buffer)
     }
 }
 
+void GenTable::setWaveformLength (int numSamples)
+{
+    tableSize = numSamples;
+    genRoutine = 1;
+    setOverview (nullptr);
+    thumbnail->reset (1, 44100, numSamples);
+    const Range<double> newRange (0.0, numSamples / 44100.0);
+    scrollbar->setRangeLimits (newRange);
+    setRange (newRange);
+    repaint();
+}
+
+void GenTable::setOverview (WaveformOverview::Ptr newOverview)
+{
+    if (overview != nullptr)
+        overview->removeChangeListener (this);
+
+    overview = newOverview;
+
+    if (overview != nullptr)
+        overview->addChangeListener (this);
+
+    repaint();
+}
+
+void GenTable::updateWaveform (const AudioSampleBuffer& block, int startSample, int numSamples)
+{
+    if (genRoutine != 1)
+        return;
+
+    thumbnail->addBlock (startSample, block, 0, numSamples);
+
+    const int x1 = jmax (0, (int) std::floor (timeToX (startSample / 44100.0)) - 1);
+    const int x2 = jmin (getWidth(), (int) std::ceil (timeToX ((startSample + numSamples) / 44100.0)) + 1);
+
+    if (x2 > x1)
+        repaint (x1, 0, x2 - x1, getHeight());
+}
+
 void GenTable::setWaveform (Array<float, CriticalSection> buffer, bool updateRange)
 {
     if (genRoutine != 1)
@@ -1104,7 +1168,11 @@ void GenTable::paint (Graphics& g)
     if (genRoutine == 1 || waveformBuffer.size() > MAX_TABLE_SIZE)
     {
         g.setColour (tableColour);
-        thumbnail->drawChannels (g, thumbArea.reduced (2), visibleRange.getStart(), visibleRange.getEnd(), .8f);
+
+        if (overview != nullptr)
+            overview->drawChannels (g, thumbArea.reduced (2), { visibleRange.getStart() * 44100.0, visibleRange.getEnd() * 44100.0 }, tableColour, .8f);
+        else
+            thumbnail->drawChannels (g, thumbArea.reduced (2), visibleRange.getStart(), visibleRange.getEnd(), .8f);
         g.setColour (tableColour.contrasting (.5f).withAlpha (.7f));
         float zoomFactor = thumbnail->getTotalLength() / visibleRange.getLength();
         regionWidth = (regionWidth == 2 ? 2 : regionWidth * zoomFactor);
@@ -25,6 +25,7 @@
 
 #include "../../CabbageCommonHeaders.h"
 #include "../../LookAndFeel/CabbageLookAndFeel2.h"
+#include "Soundfiler.h"
 
 class RoundButton;
 class HandleViewer;
@@ -74,6 +75,8 @@ public:
     void scroll (double newRangeStart);
     void addTable (int sr, const Colour col, int gen, var ampRange, int ftnumber, ChangeListener* listener);
     void setWaveform (AudioSampleBuffer buffer, int ftNumber);
+    void setWaveformLength (int numSamples, int ftNumber);
+    void updateWaveform (const AudioSampleBuffer& block, int startSample, int numSamples, int ftNumber);
     void scrollBarMoved (ScrollBar* scrollBarThatHasMoved, double newRangeStart) override;
     void setWaveform (Array<float, CriticalSection> buffer, int ftNumber, bool updateRange = true);
     void setFile (const File file);
@@ -137,6 +140,9 @@ public:
     void setFile (const File& file);
     void mouseWheelMove (const MouseEvent&, const MouseWheelDetails& wheel) override;
     void setWaveform (AudioSampleBuffer buffer);
+    //large tables can also be sent a block at a time, see TableManager::updateWaveform()
+    void setWaveformLength (int numSamples);
+    void updateWaveform (const AudioSampleBuffer& block, int startSample, int numSamples);
     void enableEditMode (StringArray pFields);
     juce::Point<int> tableTopAndHeight;
     void setWaveform (Array<float, CriticalSection> buffer, bool updateRange = true);
@@ -262,6 +268,10 @@ private:
     Image waveformImage = {};
     AudioThumbnailCache thumbnailCache;
     std::unique_ptr<AudioThumbnail> thumbnail;
+    //sound files are drawn from a shared overview rather than the thumbnail
+    SharedResourcePointer<WaveformOverviewCache> overviewCache;
+    WaveformOverview::Ptr overview;
+    void setOverview (WaveformOverview::Ptr newOverview);
     Colour tableColour, fontcolour;
     int mouseDownX = 0, mouseUpX = 0;
     juce::Rectangle<int> localBounds = {};